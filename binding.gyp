@@ -1,10 +1,24 @@
 {
+  "variables": {
+    "libraw_openmp%": "<!(node -p \"process.env.LIBRAW_OPENMP === '1' ? 1 : 0\")",
+    "libraw_jpeg%": "<!(node -p \"process.env.LIBRAW_JPEG === '1' ? 1 : 0\")",
+    "libjpeg_include%": "<!(node -p \"process.env.LIBJPEG_INCLUDE || ''\")",
+    "libjpeg_lib%": "<!(node -p \"process.env.LIBJPEG_LIB || '-ljpeg'\")",
+    "libraw_zlib%": "<!(node -p \"process.env.LIBRAW_ZLIB === '1' ? 1 : 0\")"
+  },
   "targets": [
     {
       "target_name": "libraw_addon",
       "sources": [
         "src/addon.cpp",
-        "src/libraw_wrapper.cpp"
+        "src/libraw_wrapper.cpp",
+        "src/libraw_async.cpp",
+        "src/libraw_pool.cpp",
+        "src/batch_processor.cpp",
+        "src/js_blocking_call.cpp",
+        "src/js_datastream.cpp",
+        "src/js_band_writer.cpp",
+        "src/jpeg_encoder.cpp"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
@@ -19,6 +33,16 @@
         "LIBRAW_NO_MEMPOOL_CHECK"
       ],
       "conditions": [
+        ["libraw_openmp==1 and OS=='linux'", {
+          "cflags_cc": ["-fopenmp"],
+          "ldflags": ["-fopenmp"]
+        }],
+        ["libraw_openmp==1 and OS=='mac'", {
+          "xcode_settings": {
+            "OTHER_CPLUSPLUSFLAGS": ["-Xpreprocessor", "-fopenmp"],
+            "OTHER_LDFLAGS": ["-lomp"]
+          }
+        }],
         ["OS=='win'", {
           "libraries": [
             "<(module_root_dir)/deps/LibRaw-Source/LibRaw-0.21.4/build/win32/lib/libraw.a"
@@ -63,6 +87,18 @@
               ]
             }]
           ]
+        }],
+        ["libraw_jpeg==1", {
+          "defines": ["LIBRAW_ADDON_JPEG"],
+          "libraries": ["<(libjpeg_lib)"],
+          "conditions": [
+            ["libjpeg_include!=''", {
+              "include_dirs": ["<(libjpeg_include)"]
+            }]
+          ]
+        }],
+        ["libraw_zlib==1", {
+          "libraries": ["-lz"]
         }]
       ]
     }
@@ -63,4 +63,9 @@
 #define getbits(n)  getbithuff(n, 0)
 #define gethuff(h)  getbithuff(*h, h + 1)
 
+/* ljpeg_lookahead(): table index width and its offset (in ushorts, kept
+   int-aligned) behind a make_decoder() table with max-bit codes */
+#define LJPEG_LOOKAHEAD 12
+#define LJPEG_LOOKAHEAD_OFFSET(max) (((1 << (max)) + 2) & ~1)
+
 #endif
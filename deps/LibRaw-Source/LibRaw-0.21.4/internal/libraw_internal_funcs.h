@@ -28,6 +28,7 @@ it under the terms of the one of two licenses as you choose:
 	static void remove_caseSubstr(char *string, char *remove);
 	static void removeExcessiveSpaces(char *string);
 	static void trimSpaces(char *s);
+	static int simd_kernels_available();
 /* static tables/variables */
 	static libraw_static_table_t tagtype_dataunit_bytes;
 	static libraw_static_table_t Canon_wbi2std;
@@ -152,11 +153,21 @@ it under the terms of the one of two licenses as you choose:
 
 // LJPEG decoder
 	unsigned    getbithuff (int nbits, ushort *huff);
+	unsigned    getbithuff (libraw_getbits_t *gb, int nbits, ushort *huff);
+	void        getbits_fill (libraw_getbits_t *gb, int nbits, int bytewise = 1);
+	void        getbits_sync ();
+	void        getbits_sync (libraw_getbits_t *gb);
+	INT64       getbits_tell ();
+	INT64       getbits_tell (libraw_getbits_t *gb);
+	void        derror (libraw_getbits_t *gb);
 	ushort*     make_decoder_ref (const uchar **source);
 	ushort*     make_decoder (const uchar *source);
-	int         ljpeg_start (struct jhead *jh, int info_only);
+	ushort*     ljpeg_lookahead (ushort *huff);
+	int         ljpeg_start (struct jhead *jh, int info_only, libraw_getbits_t *gb = 0);
 	void        ljpeg_end(struct jhead *jh);
 	int         ljpeg_diff (ushort *huff);
+	int         ljpeg_diff (libraw_getbits_t *gb, ushort *huff);
+	int         ljpeg_diff_lookahead (libraw_getbits_t *gb, ushort *huff);
 	ushort *    ljpeg_row (int jrow, struct jhead *jh);
 	ushort *    ljpeg_row_unrolled (int jrow, struct jhead *jh);
 	void	    ljpeg_idct (struct jhead *jh);
@@ -171,6 +182,11 @@ it under the terms of the one of two licenses as you choose:
 // Adobe DNG
 	void        adobe_copy_pixel (unsigned int row, unsigned int col, ushort **rp);
 	void        lossless_dng_load_raw();
+	int         lossless_dng_decode_tile(libraw_getbits_t *gb, unsigned trow, unsigned tcol);
+	int         packed_dng_decode_tile(libraw_getbits_t *gb, unsigned trow, unsigned tcol);
+	int         dng_decode_tiles_parallel(int (LibRaw::*decode_tile)(libraw_getbits_t *, unsigned, unsigned));
+	int         dng_tile_offsets(std::vector<INT64> &offsets, unsigned &tiles_across);
+	void        dng_skip_tile(unsigned trow, unsigned tcol, INT64 offset);
 	void        deflate_dng_load_raw();
 	void        packed_dng_load_raw();
     void        packed_tiled_dng_load_raw();
@@ -370,6 +386,11 @@ it under the terms of the one of two licenses as you choose:
 	void ahd_interpolate_build_homogeneity_map(int top, int left, short (*lab)[LIBRAW_AHD_TILE][LIBRAW_AHD_TILE][3], char (*out_homogeneity_map)[LIBRAW_AHD_TILE][2]);
 	void ahd_interpolate_combine_homogeneous_pixels(int top, int left, ushort (*rgb)[LIBRAW_AHD_TILE][LIBRAW_AHD_TILE][3], char (*homogeneity_map)[LIBRAW_AHD_TILE][2]);
 
+// split VNG and PPG code
+	void vng_interpolate_row(int row, int *(*code)[16], int prow, int pcol, ushort (*out)[4]);
+	void ppg_interpolate_green_row(int row, const int *dir);
+	void ppg_interpolate_rb_row(int row, const int *dir);
+
 	void init_fuji_compr(struct fuji_compressed_params* info);
 	void init_fuji_block(struct fuji_compressed_block* info, const struct fuji_compressed_params *params, INT64 raw_offset, unsigned dsize);
 	void copy_line_to_xtrans(struct fuji_compressed_block* info, int cur_line, int cur_block, int cur_block_width);
@@ -208,6 +208,9 @@ public:
 
 #endif
   int open_buffer(const void *buffer, size_t size);
+  /* open_file() through a read-only mapping of the file, see
+   * LibRaw_mmap_datastream. Same as open_file() on Windows */
+  int open_mmap(const char *fname);
   virtual int open_datastream(LibRaw_abstract_datastream *);
   virtual int open_bayer(const unsigned char *data, unsigned datalen,
                          ushort _raw_width, ushort _raw_height,
@@ -228,6 +231,7 @@ public:
   int raw2image();
   int raw2image_ex(int do_subtract_black);
   void raw2image_start();
+  void bin_half_size(int factor);
   void free_image();
   int adjust_maximum();
   int adjust_to_raw_inset_crop(unsigned mask, float maxcrop = 0.55f); 
@@ -285,6 +289,8 @@ public:
   void get_mem_image_format(int *width, int *height, int *colors,
                             int *bps) const;
   int copy_mem_image(void *scan0, int stride, int bgr);
+  int copy_mem_image_bands(int band_rows, int bgr, mem_image_band_callback cb,
+                           void *data);
 
   /* free all internal data structures */
   void recycle();
@@ -362,6 +368,12 @@ protected:
   virtual void copy_fuji_uncropped(unsigned short cblack[4],
                                    unsigned short *dmaxp);
   virtual void copy_bayer(unsigned short cblack[4], unsigned short *dmaxp);
+  void mem_image_curve();
+  uchar *mem_image_curve8();
+  void copy_mem_rows(void *scan0, int stride, int bgr, int first_row,
+                     int nrows, const uchar *curve8);
+  void frame_channel_maximum(unsigned filt);
+  int frame_data_maximum(const int cblack[4]);
   virtual void fuji_rotate();
   virtual void convert_to_rgb_loop(float out_cam[3][4]);
   virtual void lin_interpolate_loop(int *code, int size);
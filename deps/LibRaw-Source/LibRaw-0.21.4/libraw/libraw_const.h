@@ -272,6 +272,7 @@ enum LibRaw_runtime_capabilities
   LIBRAW_CAPS_JPEG = 1<<7,
   LIBRAW_CAPS_RAWSPEED3 = 1<<8,
   LIBRAW_CAPS_RAWSPEED_BITS = 1<<9,
+  LIBRAW_CAPS_SIMD_KERNELS = 1<<10,
 };
 
 enum LibRaw_colorspace {
@@ -639,7 +640,8 @@ enum LibRaw_processing_options
   LIBRAW_RAWOPTIONS_DNG_STAGE2_IFPRESENT = 1 << 20,
   LIBRAW_RAWOPTIONS_DNG_STAGE3_IFPRESENT = 1 << 21,
   LIBRAW_RAWOPTIONS_DNG_ADD_MASKS = 1 << 22,
-  LIBRAW_RAWOPTIONS_CANON_IGNORE_MAKERNOTES_ROTATION = 1 << 23
+  LIBRAW_RAWOPTIONS_CANON_IGNORE_MAKERNOTES_ROTATION = 1 << 23,
+  LIBRAW_RAWOPTIONS_NO_SIMD_KERNELS = 1 << 24
 };
 
 enum LibRaw_decoder_flags
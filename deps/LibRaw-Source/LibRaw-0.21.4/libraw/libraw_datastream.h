@@ -104,6 +104,12 @@ public:
    * OpenMP is not used */
   virtual int lock() { return 1; } /* success */
   virtual void unlock() {}
+  /* read size bytes at offset, returns the number of bytes read. The default
+   * is seek() + read(), so callers must serialize it like those. Streams
+   * returning nonzero from concurrent_reads() leave tell() untouched and may
+   * be called from several threads without lock() */
+  virtual int read_at(void *ptr, size_t size, INT64 offset);
+  virtual int concurrent_reads() { return 0; }
   virtual const char *fname() { return NULL; };
 #ifdef LIBRAW_WIN32_UNICODEPATHS
   virtual const wchar_t *wfname() { return NULL; };
@@ -282,6 +288,8 @@ public:
     if (streampos >= streamsize)   return -1;
     return buf[streampos++];
   }
+  virtual int read_at(void *ptr, size_t size, INT64 offset);
+  virtual int concurrent_reads() { return 1; }
 
 private:
   unsigned char *buf;
@@ -330,6 +338,95 @@ protected:
 #endif
 };
 
+#ifndef LIBRAW_WIN32_CALLS
+/* maps the whole file read-only, so reads are memory copies without stdio
+ * buffering and decoder threads can share the stream without locking */
+class DllDef LibRaw_mmap_datastream : public LibRaw_buffer_datastream
+{
+public:
+  LibRaw_mmap_datastream(const char *fname);
+  virtual ~LibRaw_mmap_datastream();
+  virtual const char *fname();
+
+protected:
+  inline void reconstruct_base()
+  {
+    (LibRaw_buffer_datastream &)*this =
+        LibRaw_buffer_datastream(map, mapsize);
+  }
+
+  std::string filename;
+  void *map;      /* start of the mapping, NULL if mapping failed */
+  size_t mapsize; /* mapped (file) size */
+};
+#endif
+
+/* serves reads from a few window-aligned blocks of another (owned) stream,
+ * so the scattered small reads of identify() and parse_tiff() turn into a
+ * handful of large reads of the source. Reads of a window or more go to the
+ * source directly. Meant for network/FUSE storage, where each request costs
+ * more than the bytes it moves */
+class DllDef LibRaw_prefetch_datastream : public LibRaw_abstract_datastream
+{
+public:
+  LibRaw_prefetch_datastream(LibRaw_abstract_datastream *source,
+                             size_t window = 65536, int blocks = 8);
+  virtual ~LibRaw_prefetch_datastream();
+  virtual int valid();
+#ifdef LIBRAW_OLD_VIDEO_SUPPORT
+  virtual void *make_jas_stream();
+#endif
+
+  virtual int read(void *ptr, size_t size, size_t nmemb);
+  virtual int eof() { return _fpos >= _fsize; }
+  virtual int seek(INT64 o, int whence);
+  virtual INT64 tell() { return _fpos; }
+  virtual INT64 size() { return _fsize; }
+  virtual char *gets(char *str, int sz);
+  virtual int scanf_one(const char *fmt, void *val);
+  virtual const char *fname() { return source ? source->fname() : NULL; }
+#ifdef LIBRAW_WIN32_UNICODEPATHS
+  virtual const wchar_t *wfname()
+  {
+    return source ? source->wfname() : NULL;
+  }
+#endif
+  virtual int get_char()
+  {
+    if (cur && _fpos >= cur->start && _fpos < cur->start + INT64(cur->filled))
+      return cur->data[size_t(_fpos++ - cur->start)];
+    size_t avail;
+    const unsigned char *p = block_at(_fpos, avail);
+    if (!p)
+      return -1;
+    _fpos++;
+    return *p;
+  }
+
+  /* I/O done against the source so far */
+  INT64 bytes_read() const { return _bytes_read; }
+  int source_reads() const { return _source_reads; }
+
+protected:
+  struct block_t
+  {
+    INT64 start; /* -1 if unused */
+    size_t filled;
+    unsigned age;
+    std::vector<unsigned char> data;
+  };
+  block_t *find_block(INT64 pos);
+  const unsigned char *block_at(INT64 pos, size_t &avail);
+
+  LibRaw_abstract_datastream *source;
+  std::vector<block_t> blocks;
+  block_t *cur; /* last block served */
+  size_t window;
+  INT64 _fsize, _fpos, _bytes_read;
+  int _source_reads;
+  unsigned clock;
+};
+
 #ifdef LIBRAW_WIN32_CALLS
 class DllDef LibRaw_windows_datastream : public LibRaw_buffer_datastream
 {
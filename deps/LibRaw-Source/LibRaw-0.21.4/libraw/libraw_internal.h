@@ -26,14 +26,22 @@ it under the terms of the one of two licenses as you choose:
 #include "libraw_datastream.h"
 #include "libraw_types.h"
 
+/* getbithuff() state: LibRaw_TLS holds the instance's reader, parallel
+   tile decoders use one per thread over their own datastream */
+struct libraw_getbits_t
+{
+  UINT64 bitbuf;
+  int vbits, reset, lag;
+  int errors; /* derror(gb) calls, reset per DNG tile */
+  unsigned pos, len;
+  LibRaw_abstract_datastream *input; /* NULL: the instance's input */
+  uchar buf[0x4000];
+};
+
 class LibRaw_TLS
 {
 public:
-  struct
-  {
-    unsigned bitbuf;
-    int vbits, reset;
-  } getbits;
+  libraw_getbits_t getbits;
   struct
   {
     UINT64 bitbuf;
@@ -57,7 +65,10 @@ public:
   void init()
   {
     getbits.bitbuf = 0;
-    getbits.vbits = getbits.reset = 0;
+    getbits.vbits = getbits.reset = getbits.lag = 0;
+    getbits.pos = getbits.len = 0;
+    getbits.errors = 0;
+    getbits.input = 0;
     ph1_bits.bitbuf = 0;
     ph1_bits.vbits = 0;
     pana_data.vpos = 0;
@@ -93,6 +104,9 @@ typedef struct
   INT64 profile_offset;
   INT64 toffset;
   unsigned pana_black[4];
+  /* Per-color raw maxima of the uncropped frame, filled by a cropped
+     raw2image_ex(); all zero when the image was not cropped */
+  ushort frame_maximum[4];
 
 } internal_data_t;
 
@@ -233,6 +247,7 @@ struct jhead
 {
   int algo, bits, high, wide, clrs, sraw, psv, restart, vpred[6];
   ushort quant[64], idct[64], *huff[20], *free[20], *row;
+  libraw_getbits_t *gb;
 };
 
 struct libraw_tiff_tag
@@ -148,6 +148,10 @@ typedef unsigned long long UINT64;
   typedef int (*pre_identify_callback)(void *ctx);
   typedef void (*post_identify_callback)(void *ctx);
   typedef void (*process_step_callback)(void *ctx);
+  /* Receives nrows output rows starting at first_row, stride bytes apart;
+     a nonzero return stops copy_mem_image_bands() */
+  typedef int (*mem_image_band_callback)(void *data, void *rows, int first_row,
+                                         int nrows, int stride);
 
   typedef struct
   {
@@ -927,6 +931,9 @@ typedef unsigned long long UINT64;
     int no_auto_scale;
     /* Disable intepolation */
     int no_interpolation;
+    /* with half_size: also average NxN half-size pixels of Bayer images
+       (0/1 = off, up to 64) */
+    int half_size_bin;
   } libraw_output_params_t;
 
   typedef struct  
@@ -206,6 +206,10 @@ static inline void crxFillBuffer(CrxBitstream *bitStrm)
   {
     bitStrm->curPos = 0;
     bitStrm->curBufOffset += bitStrm->curBufSize;
+    if (bitStrm->input->concurrent_reads())
+      bitStrm->curBufSize =
+          bitStrm->input->read_at(bitStrm->mdatBuf, _min(bitStrm->mdatSize, CRX_BUF_SIZE), bitStrm->curBufOffset);
+    else
 #ifdef LIBRAW_USE_OPENMP
 #pragma omp critical
 #endif
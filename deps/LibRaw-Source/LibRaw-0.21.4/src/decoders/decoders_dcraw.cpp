@@ -19,31 +19,134 @@
 #include "../../internal/dcraw_defs.h"
 #include "../../internal/libraw_cameraids.h"
 
-unsigned LibRaw::getbithuff(int nbits, ushort *huff)
+/*
+   Bits are pulled from a block buffer into a 64-bit accumulator, several
+   bytes at a time while no 0xFF (marker/stuffing) byte is in sight, and one
+   byte at a time otherwise. "lag" counts the accumulated bits that the
+   classic byte-at-a-time reader would not have fetched yet, so the exact
+   stream position can be restored with getbits_sync(). The state lives in
+   a libraw_getbits_t: the instance's own (tls->getbits, behind the getbits()
+   and gethuff() macros) or one per thread for parallel tile decoding.
+ */
+#define bitbuf gb->bitbuf
+#define vbits gb->vbits
+#define reset gb->reset
+#define lag gb->lag
+#define gbpos gb->pos
+#define gblen gb->len
+#define gbbuf gb->buf
+#define gbinput (gb->input ? gb->input : ifp)
+
+void LibRaw::getbits_fill(libraw_getbits_t *gb, int nbits, int bytewise)
+{
+  const UINT64 ones = 0x0101010101010101ULL, highs = 0x8080808080808080ULL;
+  int c, k;
+
+  while (!reset && vbits < nbits)
+  {
+    if (gblen - gbpos < 8)
+    {
+      if (gbpos)
+      {
+        memmove(gbbuf, gbbuf + gbpos, gblen - gbpos);
+        gblen -= gbpos;
+        gbpos = 0;
+      }
+      int got = fread(gbbuf + gblen, 1, sizeof(gbbuf) - gblen, gbinput);
+      if (got > 0)
+        gblen += got;
+    }
+    if (gblen - gbpos >= 8)
+    {
+      UINT64 w = 0;
+      for (c = 0; c < 8; c++)
+        w = (w << 8) | gbbuf[gbpos + c];
+      k = MIN((64 - vbits) >> 3, 7);
+      UINT64 t = ~w | ((1ULL << (64 - k * 8)) - 1);
+      if (!zero_after_ff || !((t - ones) & ~t & highs))
+      {
+        bitbuf = (bitbuf << (k * 8)) | (w >> (64 - k * 8));
+        vbits += k * 8;
+        lag += k * 8;
+        gbpos += k;
+        continue;
+      }
+    }
+    /* byte-wise path: identical to the classic fgetc() loop */
+    if (!bytewise)
+      break;
+    lag = 0;
+    if (gbpos >= gblen)
+      break;
+    c = gbbuf[gbpos++];
+    if (zero_after_ff && c == 0xff)
+    {
+      if (gbpos >= gblen)
+      {
+        gblen = gbpos = 0;
+        int got = fread(gbbuf, 1, sizeof(gbbuf), gbinput);
+        if (got > 0)
+          gblen = got;
+      }
+      if (gbpos >= gblen || gbbuf[gbpos++])
+      {
+        reset = 1;
+        break;
+      }
+    }
+    bitbuf = (bitbuf << 8) + (uchar)c;
+    vbits += 8;
+  }
+}
+
+/*
+   Hands read-ahead bytes back to the datastream: call before touching ifp
+   directly (or before getbits(-1) that continues at the next byte) once
+   getbits has been used; getbits(-1) alone restarts at the current ifp.
+ */
+void LibRaw::getbits_sync(libraw_getbits_t *gb)
+{
+  INT64 unread = gblen - gbpos + (lag >> 3);
+  if (unread)
+    fseek(gbinput, -unread, SEEK_CUR);
+  if (vbits > 0)
+  {
+    vbits -= lag;
+    bitbuf >>= lag;
+  }
+  lag = 0;
+  gbpos = gblen = 0;
+}
+
+/*
+   Stream position the classic byte-at-a-time reader would report: ftell()
+   less the buffered bytes not yet pulled into bitbuf and the "lag" bytes.
+ */
+INT64 LibRaw::getbits_tell(libraw_getbits_t *gb)
+{
+  return ftell(gbinput) - (gblen - gbpos) - (lag >> 3);
+}
+
+unsigned LibRaw::getbithuff(libraw_getbits_t *gb, int nbits, ushort *huff)
 {
-#ifdef LIBRAW_NOTHREADS
-  static unsigned bitbuf = 0;
-  static int vbits = 0, reset = 0;
-#else
-#define bitbuf tls->getbits.bitbuf
-#define vbits tls->getbits.vbits
-#define reset tls->getbits.reset
-#endif
   unsigned c;
 
   if (nbits > 25)
     return 0;
   if (nbits < 0)
-    return bitbuf = vbits = reset = 0;
-  if (nbits == 0 || vbits < 0)
-    return 0;
-  while (!reset && vbits < nbits && (c = fgetc(ifp)) != (unsigned)EOF &&
-         !(reset = zero_after_ff && c == 0xff && fgetc(ifp)))
   {
-    bitbuf = (bitbuf << 8) + (uchar)c;
-    vbits += 8;
+    lag = 0;
+    gbpos = gblen = 0;
+    bitbuf = 0;
+    return vbits = reset = 0;
   }
-  c = vbits == 0 ? 0 : bitbuf << (32 - vbits) >> (32 - nbits);
+  if (nbits == 0 || vbits < 0)
+    return 0;
+  if (vbits < nbits)
+    getbits_fill(gb, nbits);
+  if (vbits - lag < nbits)
+    lag = MAX(lag - ((nbits - vbits + lag + 7) & ~7), 0);
+  c = vbits == 0 ? 0 : unsigned(bitbuf << (64 - vbits) >> (64 - nbits));
   if (huff)
   {
     vbits -= huff[c] >> 8;
@@ -52,15 +155,66 @@ unsigned LibRaw::getbithuff(int nbits, ushort *huff)
   else
     vbits -= nbits;
   if (vbits < 0)
-    derror();
+    derror(gb);
   return c;
-#ifndef LIBRAW_NOTHREADS
+}
+
+/*
+   Lossless JPEG difference decoding through the lookahead table appended by
+   ljpeg_lookahead(): one lookup resolves the code and, when they fit in
+   LJPEG_LOOKAHEAD bits, its difference bits as well. Anything the table
+   cannot resolve (long codes, little buffered data) goes to ljpeg_diff().
+ */
+int LibRaw::ljpeg_diff_lookahead(libraw_getbits_t *gb, ushort *huff)
+{
+  if (!huff)
+    throw LIBRAW_EXCEPTION_IO_CORRUPT;
+  int need = MAX(LJPEG_LOOKAHEAD, huff[0]);
+  if (vbits < need)
+    getbits_fill(gb, need, 0);
+  if (vbits < need)
+    return ljpeg_diff(gb, huff);
+  const int *look = (const int *)(huff + LJPEG_LOOKAHEAD_OFFSET(huff[0]));
+  int e = look[unsigned(bitbuf >> (vbits - LJPEG_LOOKAHEAD)) &
+               ((1 << LJPEG_LOOKAHEAD) - 1)];
+  if (!e)
+    return ljpeg_diff(gb, huff);
+  int len = e & 31, ssss = (e >> 5) & 31;
+  /* keep "lag" in step with the classic gethuff() + getbits() sequence */
+  if (vbits - lag < huff[0])
+    lag = MAX(lag - ((huff[0] - vbits + lag + 7) & ~7), 0);
+  vbits -= len;
+  if (!(e & 1024))
+  {
+    int diff = getbithuff(gb, ssss, 0);
+    if ((diff & (1 << (ssss - 1))) == 0)
+      diff -= (1 << ssss) - 1;
+    return diff;
+  }
+  if (vbits - lag < ssss)
+    lag = MAX(lag - ((ssss - vbits + lag + 7) & ~7), 0);
+  vbits -= ssss;
+  return e >> 16;
+}
+
 #undef bitbuf
 #undef vbits
 #undef reset
-#endif
+#undef lag
+#undef gbpos
+#undef gblen
+#undef gbbuf
+#undef gbinput
+
+unsigned LibRaw::getbithuff(int nbits, ushort *huff)
+{
+  return getbithuff(&tls->getbits, nbits, huff);
 }
 
+void LibRaw::getbits_sync() { getbits_sync(&tls->getbits); }
+
+INT64 LibRaw::getbits_tell() { return getbits_tell(&tls->getbits); }
+
 /*
    Construct a decode tree according the specification in *source.
    The first 16 bytes specify how many codes should be 1-bit, 2-bit
@@ -111,6 +265,47 @@ ushort *LibRaw::make_decoder(const uchar *source)
   return make_decoder_ref(&source);
 }
 
+/*
+   Appends to a make_decoder_ref() table a 1 << LJPEG_LOOKAHEAD entry table
+   for ljpeg_diff_lookahead(). Each entry packs the code length (bits 0-4)
+   and its difference length (bits 5-9); when both fit in the lookahead bits
+   bit 10 is set and bits 16-31 hold the decoded difference. Zero entries
+   (long or invalid codes, 16-bit differences) use the regular path.
+ */
+ushort *LibRaw::ljpeg_lookahead(ushort *huff)
+{
+  int max = huff[0], i, e, len, ssss, diff;
+  ushort *table = (ushort *)realloc(
+      huff, LJPEG_LOOKAHEAD_OFFSET(max) * sizeof(ushort) +
+                (1 << LJPEG_LOOKAHEAD) * sizeof(int));
+  if (!table)
+  {
+    free(huff);
+    throw LIBRAW_EXCEPTION_ALLOC;
+  }
+  int *look = (int *)(table + LJPEG_LOOKAHEAD_OFFSET(max));
+  for (i = 0; i < 1 << LJPEG_LOOKAHEAD; i++)
+  {
+    e = table[1 + (max >= LJPEG_LOOKAHEAD ? i << (max - LJPEG_LOOKAHEAD)
+                                          : i >> (LJPEG_LOOKAHEAD - max))];
+    len = e >> 8;
+    ssss = e & 0xff;
+    look[i] = 0;
+    if (!len || len > LJPEG_LOOKAHEAD || ssss > 15)
+      continue;
+    if (len + ssss > LJPEG_LOOKAHEAD)
+    {
+      look[i] = ssss << 5 | len;
+      continue;
+    }
+    diff = (i >> (LJPEG_LOOKAHEAD - len - ssss)) & ((1 << ssss) - 1);
+    if (ssss && (diff & (1 << (ssss - 1))) == 0)
+      diff -= (1 << ssss) - 1;
+    look[i] = int(unsigned(diff) << 16) | 1024 | ssss << 5 | len;
+  }
+  return table;
+}
+
 void LibRaw::crw_init_tables(unsigned table, ushort *huff[2])
 {
   static const uchar first_tree[3][29] = {
@@ -252,6 +447,7 @@ void LibRaw::canon_load_raw()
       }
       if (lowbits)
       {
+        getbits_sync();
         save = ftell(ifp);
         fseek(ifp, 26 + row * raw_width / 4, SEEK_SET);
         for (prow = pixel, i = 0; i < raw_width * 2; i++)
@@ -277,7 +473,7 @@ void LibRaw::canon_load_raw()
   FORC(2) free(huff[c]);
 }
 
-int LibRaw::ljpeg_start(struct jhead *jh, int info_only)
+int LibRaw::ljpeg_start(struct jhead *jh, int info_only, libraw_getbits_t *gb)
 {
   ushort c, tag, len;
   int cnt = 0;
@@ -287,21 +483,23 @@ int LibRaw::ljpeg_start(struct jhead *jh, int info_only)
 
   memset(jh, 0, sizeof *jh);
   jh->restart = INT_MAX;
-  if (fread(data, 2, 1, ifp) != 1 || data[1] != 0xd8)
+  jh->gb = gb ? gb : &tls->getbits;
+  LibRaw_abstract_datastream *in = jh->gb->input ? jh->gb->input : ifp;
+  if (fread(data, 2, 1, in) != 1 || data[1] != 0xd8)
     return 0;
   do
   {
-    if (feof(ifp))
+    if (feof(in))
       return 0;
     if (cnt++ > 1024)
       return 0; // 1024 tags limit
-    if (fread(data, 2, 2, ifp) != 2)
+    if (fread(data, 2, 2, in) != 2)
       return 0;
     tag = data[0] << 8 | data[1];
     len = (data[2] << 8 | data[3]) - 2;
     if (tag <= 0xff00)
       return 0;
-    if (fread(data, 1, len, ifp) != len)
+    if (fread(data, 1, len, in) != len)
       return 0;
     switch (tag)
     {
@@ -315,13 +513,13 @@ int LibRaw::ljpeg_start(struct jhead *jh, int info_only)
       jh->wide = data[3] << 8 | data[4];
       jh->clrs = data[5] + jh->sraw;
       if (len == 9 && !dng_version)
-        getc(ifp);
+        getc(in);
       break;
     case 0xffc4: // define Huffman tables
       if (info_only)
         break;
       for (dp = data; dp < data + len && !((c = *dp++) & -20);)
-        jh->free[c] = jh->huff[c] = make_decoder_ref(&dp);
+        jh->free[c] = jh->huff[c] = ljpeg_lookahead(make_decoder_ref(&dp));
       break;
     case 0xffda: // start of scan
       jh->psv = data[1 + data[0] * 2];
@@ -348,7 +546,9 @@ int LibRaw::ljpeg_start(struct jhead *jh, int info_only)
     FORC(jh->sraw) jh->huff[1 + c] = jh->huff[0];
   }
   jh->row = (ushort *)calloc(jh->wide * jh->clrs, 16);
-  return zero_after_ff = 1;
+  if (!zero_after_ff) // preset by parallel tile decoders
+    zero_after_ff = 1;
+  return 1;
 }
 
 void LibRaw::ljpeg_end(struct jhead *jh)
@@ -358,16 +558,18 @@ void LibRaw::ljpeg_end(struct jhead *jh)
   free(jh->row);
 }
 
-int LibRaw::ljpeg_diff(ushort *huff)
+int LibRaw::ljpeg_diff(ushort *huff) { return ljpeg_diff(&tls->getbits, huff); }
+
+int LibRaw::ljpeg_diff(libraw_getbits_t *gb, ushort *huff)
 {
   int len, diff;
   if (!huff)
     throw LIBRAW_EXCEPTION_IO_CORRUPT;
 
-  len = gethuff(huff);
+  len = getbithuff(gb, *huff, huff + 1);
   if (len == 16 && (!dng_version || dng_version >= 0x1010000))
     return -32768;
-  diff = getbits(len);
+  diff = getbithuff(gb, len, 0);
 
 
   if ((diff & (1 << (len - 1))) == 0)
@@ -389,18 +591,20 @@ ushort *LibRaw::ljpeg_row(int jrow, struct jhead *jh)
     FORC(6) jh->vpred[c] = 1 << (jh->bits - 1);
     if (jrow)
     {
-      fseek(ifp, -2, SEEK_CUR);
+      LibRaw_abstract_datastream *in = jh->gb->input ? jh->gb->input : ifp;
+      getbits_sync(jh->gb);
+      fseek(in, -2, SEEK_CUR);
       do
-        mark = (mark << 8) + (c = fgetc(ifp));
+        mark = (mark << 8) + (c = fgetc(in));
       while (c != EOF && mark >> 4 != 0xffd);
     }
-    getbits(-1);
+    getbithuff(jh->gb, -1, 0);
   }
   FORC3 row[c] = jh->row + jh->wide * jh->clrs * ((jrow + c) & 1);
   for (col = 0; col < jh->wide; col++)
     FORC(jh->clrs)
     {
-      diff = ljpeg_diff(jh->huff[c]);
+      diff = ljpeg_diff_lookahead(jh->gb, jh->huff[c]);
       if (jh->sraw && c <= jh->sraw && (col | c))
         pred = spred;
       else if (col)
@@ -435,7 +639,7 @@ ushort *LibRaw::ljpeg_row(int jrow, struct jhead *jh)
         }
       if ((**row = pred + diff) >> jh->bits)
 		  if(!(load_flags & 512))
-			derror();
+			derror(jh->gb);
       if (c <= jh->sraw)
         spred = **row;
       row[0]++;
@@ -454,22 +658,24 @@ ushort *LibRaw::ljpeg_row_unrolled(int jrow, struct jhead *jh)
     FORC(6) jh->vpred[c] = 1 << (jh->bits - 1);
     if (jrow)
     {
-      fseek(ifp, -2, SEEK_CUR);
+      LibRaw_abstract_datastream *in = jh->gb->input ? jh->gb->input : ifp;
+      getbits_sync(jh->gb);
+      fseek(in, -2, SEEK_CUR);
       do
-        mark = (mark << 8) + (c = fgetc(ifp));
+        mark = (mark << 8) + (c = fgetc(in));
       while (c != EOF && mark >> 4 != 0xffd);
     }
-    getbits(-1);
+    getbithuff(jh->gb, -1, 0);
   }
   FORC3 row[c] = jh->row + jh->wide * jh->clrs * ((jrow + c) & 1);
 
   // The first column uses one particular predictor.
   FORC(jh->clrs)
   {
-    diff = ljpeg_diff(jh->huff[c]);
+    diff = ljpeg_diff_lookahead(jh->gb, jh->huff[c]);
     pred = (jh->vpred[c] += diff) - diff;
     if ((**row = pred + diff) >> jh->bits)
-      derror();
+      derror(jh->gb);
     row[0]++;
     row[1]++;
   }
@@ -479,10 +685,10 @@ ushort *LibRaw::ljpeg_row_unrolled(int jrow, struct jhead *jh)
     for (col = 1; col < jh->wide; col++)
       FORC(jh->clrs)
       {
-        diff = ljpeg_diff(jh->huff[c]);
+        diff = ljpeg_diff_lookahead(jh->gb, jh->huff[c]);
         pred = row[0][-jh->clrs];
         if ((**row = pred + diff) >> jh->bits)
-          derror();
+          derror(jh->gb);
         row[0]++;
         row[1]++;
       }
@@ -492,10 +698,10 @@ ushort *LibRaw::ljpeg_row_unrolled(int jrow, struct jhead *jh)
     for (col = 1; col < jh->wide; col++)
       FORC(jh->clrs)
       {
-        diff = ljpeg_diff(jh->huff[c]);
+        diff = ljpeg_diff_lookahead(jh->gb, jh->huff[c]);
         pred = row[0][-jh->clrs];
         if ((**row = pred + diff) >> jh->bits)
-          derror();
+          derror(jh->gb);
         row[0]++;
       }
   }
@@ -504,7 +710,7 @@ ushort *LibRaw::ljpeg_row_unrolled(int jrow, struct jhead *jh)
     for (col = 1; col < jh->wide; col++)
       FORC(jh->clrs)
       {
-        diff = ljpeg_diff(jh->huff[c]);
+        diff = ljpeg_diff_lookahead(jh->gb, jh->huff[c]);
         pred = row[0][-jh->clrs];
         switch (jh->psv)
         {
@@ -532,7 +738,7 @@ ushort *LibRaw::ljpeg_row_unrolled(int jrow, struct jhead *jh)
           pred = 0;
         }
         if ((**row = pred + diff) >> jh->bits)
-          derror();
+          derror(jh->gb);
         row[0]++;
         row[1]++;
       }
@@ -778,14 +984,14 @@ void LibRaw::ljpeg_idct(struct jhead *jh)
   if (!cs[0])
     FORC(106) cs[c] = cos((c & 31) * M_PI / 16) / 2;
   memset(work, 0, sizeof work);
-  work[0][0][0] = jh->vpred[0] += ljpeg_diff(jh->huff[0]) * jh->quant[0];
+  work[0][0][0] = jh->vpred[0] += ljpeg_diff(jh->gb, jh->huff[0]) * jh->quant[0];
   for (i = 1; i < 64; i++)
   {
-    len = gethuff(jh->huff[16]);
+    len = getbithuff(jh->gb, *jh->huff[16], jh->huff[16] + 1);
     i += skip = len >> 4;
     if (!(len &= 15) && skip < 15)
       break;
-    coef = getbits(len);
+    coef = getbithuff(jh->gb, len, 0);
     if ((coef & (1 << (len - 1))) == 0)
       coef -= (1 << len) - 1;
     ((float *)work)[zigzag[i]] = coef * jh->quant[i];
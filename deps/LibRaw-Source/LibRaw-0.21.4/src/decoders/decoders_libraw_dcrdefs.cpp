@@ -14,27 +14,52 @@
 
 #include "../../internal/dcraw_defs.h"
 
-void LibRaw::packed_tiled_dng_load_raw()
+int LibRaw::packed_dng_decode_tile(libraw_getbits_t *gb, unsigned trow,
+                                   unsigned tcol)
 {
+  LibRaw_abstract_datastream *in = gb->input ? gb->input : ifp;
+  std::vector<ushort> pixel(tile_width * tiff_samples);
   ushort *rp;
   unsigned row, col;
 
+  getbithuff(gb, -1, 0); // derror(gb) reads the stream position via gb
+  gb->errors = 0;
+  for (row = 0; row < tile_length && (row + trow) < raw_height; row++)
+  {
+    if (tiff_bps == 16)
+    {
+      if (fread(pixel.data(), 2, pixel.size(), in) < (int)pixel.size())
+        derror(gb);
+      if ((order == 0x4949) == (ntohs(0x1234) == 0x1234))
+        libraw_swab(pixel.data(), int(pixel.size()) * 2);
+    }
+    else
+    {
+      if (row)
+        getbits_sync(gb);
+      getbithuff(gb, -1, 0);
+      for (col = 0; col < tile_width * tiff_samples; col++)
+        pixel[col] = getbithuff(gb, tiff_bps, 0);
+    }
+    for (rp = pixel.data(), col = 0; col < tile_width; col++)
+      adobe_copy_pixel(trow+row, tcol+col, &rp);
+  }
+  return 1;
+}
+
+void LibRaw::packed_tiled_dng_load_raw()
+{
+  int ntiles = 1 + (raw_width) / tile_width;
+  if ((unsigned)ntiles * tile_width > raw_width * 2u)
+    throw LIBRAW_EXCEPTION_ALLOC;
+
   int ss = shot_select;
   shot_select = libraw_internal_data.unpacker_data.dng_frames[LIM(ss, 0, (LIBRAW_IFD_MAXCOUNT * 2 - 1))] & 0xff;
-  std::vector<ushort> pixel;
 
   try
   {
-    int ntiles = 1 + (raw_width) / tile_width;
-    if ((unsigned)ntiles * tile_width > raw_width * 2u) throw LIBRAW_EXCEPTION_ALLOC;
-    pixel.resize(tile_width * ntiles * tiff_samples);
-  }
-  catch (...)
-  {
-    throw LIBRAW_EXCEPTION_ALLOC; // rethrow
-  }
-  try
-  {
+    if (!dng_decode_tiles_parallel(&LibRaw::packed_dng_decode_tile))
+    {
       unsigned trow = 0, tcol = 0;
       INT64 save;
       while (trow < raw_height)
@@ -43,24 +68,12 @@ void LibRaw::packed_tiled_dng_load_raw()
         save = ftell(ifp);
         if (tile_length < INT_MAX)
           fseek(ifp, get4(), SEEK_SET);
-
-        for (row = 0; row < tile_length && (row + trow) < raw_height; row++)
-        {
-          if (tiff_bps == 16)
-            read_shorts(pixel.data(), tile_width * tiff_samples);
-          else
-          {
-            getbits(-1);
-            for (col = 0; col < tile_width * tiff_samples; col++)
-              pixel[col] = getbits(tiff_bps);
-          }
-          for (rp = pixel.data(), col = 0; col < tile_width; col++)
-            adobe_copy_pixel(trow+row, tcol+col, &rp);
-        }
+        packed_dng_decode_tile(&tls->getbits, trow, tcol);
         fseek(ifp, save + 4, SEEK_SET);
         if ((tcol += tile_width) >= raw_width)
           trow += tile_length + (tcol = 0);
       }
+    }
   }
   catch (...)
   {
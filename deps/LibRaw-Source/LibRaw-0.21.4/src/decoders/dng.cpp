@@ -46,84 +46,311 @@ void LibRaw::adobe_copy_pixel(unsigned row, unsigned col, ushort **rp)
   if (tiff_samples == 2 && shot_select)
     (*rp)--;
 }
-void LibRaw::lossless_dng_load_raw()
+/*
+   One tile's view of the image datastream with a private read position, so
+   that tiles can be decoded concurrently. Memory-backed streams are read in
+   place; other streams are serialized through the dng_tile_read critical
+   section.
+ */
+class LibRaw_tile_datastream : public LibRaw_abstract_datastream
 {
-  unsigned trow = 0, tcol = 0, jwide, jrow, jcol, row, col, i, j;
-  INT64 save;
-  struct jhead jh;
-  ushort *rp;
+public:
+  LibRaw_tile_datastream(LibRaw_abstract_datastream *p, INT64 offset)
+      : parent(p), pos(offset)
+  {
+  }
+  virtual int valid() { return parent->valid(); }
+  virtual int read(void *ptr, size_t size, size_t nmemb)
+  {
+    int got;
+    if (!size || !nmemb)
+      return 0;
+    if (parent->concurrent_reads())
+      got = parent->read_at(ptr, size * nmemb, pos);
+    else
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp critical(dng_tile_read)
+#endif
+      got = parent->read_at(ptr, size * nmemb, pos);
+    if (got <= 0)
+      return 0;
+    pos += got;
+    return int(got / size);
+  }
+  virtual int seek(INT64 o, int whence)
+  {
+    INT64 npos;
+    switch (whence)
+    {
+    case SEEK_SET:
+      npos = o;
+      break;
+    case SEEK_CUR:
+      npos = pos + o;
+      break;
+    case SEEK_END:
+      npos = size() + o;
+      break;
+    default:
+      return -1;
+    }
+    if (npos < 0)
+      return -1;
+    pos = npos;
+    return 0;
+  }
+  virtual INT64 tell() { return pos; }
+  virtual INT64 size() { return parent->size(); }
+  virtual int get_char()
+  {
+    uchar c;
+    return read(&c, 1, 1) == 1 ? c : -1;
+  }
+  virtual char *gets(char *, int) { return NULL; }
+  virtual int scanf_one(const char *, void *) { return -1; }
+  virtual int eof() { return pos >= size(); }
+#ifdef LIBRAW_OLD_VIDEO_SUPPORT
+  virtual void *make_jas_stream() { return NULL; }
+#endif
 
-  int ss = shot_select;
-  shot_select = libraw_internal_data.unpacker_data.dng_frames[LIM(ss,0,(LIBRAW_IFD_MAXCOUNT*2-1))] & 0xff;
+private:
+  LibRaw_abstract_datastream *parent;
+  INT64 pos;
+};
+
+/*
+   Reads the tile offset table at the current ifp position. Returns the
+   number of tiles, or 0 (ifp untouched) for an implausible tile layout.
+ */
+int LibRaw::dng_tile_offsets(std::vector<INT64> &offsets,
+                             unsigned &tiles_across)
+{
+  if (tile_length >= INT_MAX || !tile_width || !tile_length)
+    return 0;
+  tiles_across = (raw_width + tile_width - 1) / tile_width;
+  unsigned tiles_down = (raw_height + tile_length - 1) / tile_length;
+  if (!tiles_across || !tiles_down || tiles_across > 0xffff ||
+      tiles_down > 0xffff || INT64(tiles_across) * tiles_down > 0x100000)
+    return 0;
+  int tile_count = tiles_across * tiles_down;
+  if (ftell(ifp) + 4 * INT64(tile_count) > ifp->size())
+    return 0;
+
+  offsets.resize(tile_count);
+  for (int i = 0; i < tile_count; i++)
+    offsets[i] = get4();
+  return tile_count;
+}
+
+/*
+   A tile whose header cannot be decoded is cleared and reported as a data
+   error; the remaining tiles are still decoded, so a damaged file unpacks
+   partially instead of failing. Safe to call from parallel tile decoders.
+ */
+void LibRaw::dng_skip_tile(unsigned trow, unsigned tcol, INT64 offset)
+{
+  unsigned row, ncols;
 
-  while (trow < raw_height)
+  if (trow >= raw_height || tcol >= raw_width)
+    return;
+  ncols = MIN(tile_width, raw_width - tcol);
+  for (row = trow; row < trow + tile_length && row < raw_height; row++)
+    if (raw_image)
+      memset(&RAW(row, tcol), 0, ncols * sizeof *raw_image);
+    else if (image)
+      memset(image[row * raw_width + tcol], 0, ncols * sizeof *image);
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp critical(libraw_derror)
+#endif
   {
-    checkCancel();
-    save = ftell(ifp);
-    if (tile_length < INT_MAX)
-      fseek(ifp, get4(), SEEK_SET);
-    if (!ljpeg_start(&jh, 0))
-      break;
-    jwide = jh.wide;
-    if (filters)
-      jwide *= jh.clrs;
+    if (!data_error && callbacks.data_cb)
+      (*callbacks.data_cb)(callbacks.datacb_data,
+                           libraw_internal_data.internal_data.input->fname(),
+                           int(offset));
+    data_error++;
+  }
+}
 
-    if(filters && (tiff_samples == 2)) // Fuji Super CCD
-        jwide /= 2;
+/*
+   Decodes all tiles of a tiled DNG at once: the tile offsets are read up
+   front, then every thread decodes whole tiles through its own bit reader
+   and tile datastream. A tile that cannot be decoded (decode_tile returns
+   0) is skipped with dng_skip_tile(), as in the tile-by-tile loops. Returns
+   0 (ifp untouched) when the layout does not allow it and the caller should
+   decode tile by tile.
+ */
+int LibRaw::dng_decode_tiles_parallel(
+    int (LibRaw::*decode_tile)(libraw_getbits_t *, unsigned, unsigned))
+{
+#ifdef LIBRAW_USE_OPENMP
+  if (omp_get_max_threads() < 2)
+    return 0;
+  std::vector<INT64> offsets;
+  unsigned tiles_across;
+  INT64 start = ftell(ifp);
+  int tile_count = dng_tile_offsets(offsets, tiles_across);
+  if (tile_count < 2)
+  {
+    fseek(ifp, start, SEEK_SET);
+    return 0;
+  }
+
+  int buffer_count = omp_get_max_threads();
+  char **buffers = malloc_omp_buffers(buffer_count, sizeof(libraw_getbits_t));
+  int error = 0;
+
+#pragma omp parallel for schedule(dynamic) default(none) shared(error, offsets) firstprivate(buffers, tiles_across, tile_count, decode_tile)
+  for (int tile = 0; tile < tile_count; tile++)
+  {
+    int failed;
+#pragma omp critical(dng_tile_error)
+    failed = error;
+    if (failed)
+      continue;
+    libraw_getbits_t *gb = (libraw_getbits_t *)buffers[omp_get_thread_num()];
+    LibRaw_tile_datastream in(ifp, offsets[tile]);
+    int code = 0;
+    gb->input = &in;
     try
     {
-      switch (jh.algo)
+      checkCancel();
+      getbithuff(gb, -1, 0);
+      unsigned trow = (tile / tiles_across) * tile_length;
+      unsigned tcol = (tile % tiles_across) * tile_width;
+      if (!(this->*decode_tile)(gb, trow, tcol))
+        dng_skip_tile(trow, tcol, offsets[tile]);
+    }
+    catch (LibRaw_exceptions e)
+    {
+      code = e;
+    }
+    catch (std::bad_alloc &)
+    {
+      code = LIBRAW_EXCEPTION_ALLOC;
+    }
+    catch (...)
+    {
+      code = LIBRAW_EXCEPTION_IO_CORRUPT;
+    }
+    gb->input = 0;
+    if (code)
+    {
+#pragma omp critical(dng_tile_error)
+      if (!error)
+        error = code;
+    }
+  }
+
+  free_omp_buffers(buffers, buffer_count);
+  fseek(ifp, start + 4 * INT64(tile_count), SEEK_SET);
+  if (error)
+    throw LibRaw_exceptions(error);
+  return 1;
+#else
+  (void)decode_tile;
+  return 0;
+#endif
+}
+
+int LibRaw::lossless_dng_decode_tile(libraw_getbits_t *gb, unsigned trow,
+                                     unsigned tcol)
+{
+  unsigned jwide, jrow, jcol, row, col, i, j;
+  struct jhead jh;
+  ushort *rp;
+
+  if (!ljpeg_start(&jh, 0, gb))
+    return 0;
+  jh.gb->errors = 0;
+  jwide = jh.wide;
+  if (filters)
+    jwide *= jh.clrs;
+
+  if(filters && (tiff_samples == 2)) // Fuji Super CCD
+      jwide /= 2;
+  try
+  {
+    switch (jh.algo)
+    {
+    case 0xc1:
+      jh.vpred[0] = 16384;
+      getbithuff(jh.gb, -1, 0);
+      for (jrow = 0; jrow + 7 < (unsigned)jh.high; jrow += 8)
       {
-      case 0xc1:
-        jh.vpred[0] = 16384;
-        getbits(-1);
-        for (jrow = 0; jrow + 7 < (unsigned)jh.high; jrow += 8)
+        checkCancel();
+        for (jcol = 0; jcol + 7 < (unsigned)jh.wide; jcol += 8)
         {
-          checkCancel();
-          for (jcol = 0; jcol + 7 < (unsigned)jh.wide; jcol += 8)
+          ljpeg_idct(&jh);
+          rp = jh.idct;
+          row = trow + jcol / tile_width + jrow * 2;
+          col = tcol + jcol % tile_width;
+          for (i = 0; i < 16; i += 2)
+            for (j = 0; j < 8; j++)
+              adobe_copy_pixel(row + i, col + j, &rp);
+        }
+      }
+      break;
+    case 0xc3:
+      for (row = col = jrow = 0; jrow < (unsigned)jh.high; jrow++)
+      {
+        checkCancel();
+        rp = ljpeg_row(jrow, &jh);
+        if (tiff_samples == 1 && jh.clrs > 1 && jh.clrs * jwide == raw_width)
+          for (jcol = 0; jcol < jwide * jh.clrs; jcol++)
           {
-            ljpeg_idct(&jh);
-            rp = jh.idct;
-            row = trow + jcol / tile_width + jrow * 2;
-            col = tcol + jcol % tile_width;
-            for (i = 0; i < 16; i += 2)
-              for (j = 0; j < 8; j++)
-                adobe_copy_pixel(row + i, col + j, &rp);
+            adobe_copy_pixel(trow + row, tcol + col, &rp);
+            if (++col >= tile_width || col >= raw_width)
+              row += 1 + (col = 0);
+          }
+        else
+          for (jcol = 0; jcol < jwide; jcol++)
+          {
+            adobe_copy_pixel(trow + row, tcol + col, &rp);
+            if (++col >= tile_width || col >= raw_width)
+              row += 1 + (col = 0);
           }
-        }
-        break;
-      case 0xc3:
-        for (row = col = jrow = 0; jrow < (unsigned)jh.high; jrow++)
-        {
-          checkCancel();
-          rp = ljpeg_row(jrow, &jh);
-          if (tiff_samples == 1 && jh.clrs > 1 && jh.clrs * jwide == raw_width)
-            for (jcol = 0; jcol < jwide * jh.clrs; jcol++)
-            {
-              adobe_copy_pixel(trow + row, tcol + col, &rp);
-              if (++col >= tile_width || col >= raw_width)
-                row += 1 + (col = 0);
-            }
-          else
-            for (jcol = 0; jcol < jwide; jcol++)
-            {
-              adobe_copy_pixel(trow + row, tcol + col, &rp);
-              if (++col >= tile_width || col >= raw_width)
-                row += 1 + (col = 0);
-            }
-        }
       }
     }
-    catch (...)
-    {
-      ljpeg_end(&jh);
-      shot_select = ss;
-      throw;
-    }
-    fseek(ifp, save + 4, SEEK_SET);
-    if ((tcol += tile_width) >= raw_width)
-      trow += tile_length + (tcol = 0);
+  }
+  catch (...)
+  {
     ljpeg_end(&jh);
+    throw;
+  }
+  ljpeg_end(&jh);
+  return 1;
+}
+
+void LibRaw::lossless_dng_load_raw()
+{
+  unsigned trow = 0, tcol = 0;
+  INT64 save, offset;
+
+  int ss = shot_select;
+  shot_select = libraw_internal_data.unpacker_data.dng_frames[LIM(ss,0,(LIBRAW_IFD_MAXCOUNT*2-1))] & 0xff;
+
+  zero_after_ff = 1; // set by ljpeg_start(), but not from parallel threads
+  try
+  {
+    if (!dng_decode_tiles_parallel(&LibRaw::lossless_dng_decode_tile))
+      while (trow < raw_height)
+      {
+        checkCancel();
+        save = ftell(ifp);
+        if (tile_length < INT_MAX)
+          fseek(ifp, get4(), SEEK_SET);
+        offset = ftell(ifp);
+        if (!lossless_dng_decode_tile(&tls->getbits, trow, tcol))
+          dng_skip_tile(trow, tcol, offset);
+        fseek(ifp, save + 4, SEEK_SET);
+        if ((tcol += tile_width) >= raw_width)
+          trow += tile_length + (tcol = 0);
+      }
+  }
+  catch (...)
+  {
+    shot_select = ss;
+    throw;
   }
   shot_select = ss;
 }
@@ -152,6 +379,8 @@ void LibRaw::packed_dng_load_raw()
         read_shorts(pixel, raw_width * tiff_samples);
       else
       {
+        if (row)
+          getbits_sync();
         getbits(-1);
         for (col = 0; col < raw_width * tiff_samples; col++)
           pixel[col] = getbits(tiff_bps);
@@ -178,15 +407,22 @@ static void jpegErrorExit_d(j_common_ptr /*cinfo*/)
   throw LIBRAW_EXCEPTION_DECODE_JPEG;
 }
 
+/* lossy_dng_load_raw() per-thread decompressor, reused for every tile */
+struct lossy_dng_decoder_t
+{
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_error_mgr pub;
+  std::vector<JSAMPLE> buf;
+  bool created;
+  lossy_dng_decoder_t() : created(false) {}
+};
+
 void LibRaw::lossy_dng_load_raw()
 {
   if (!image)
     throw LIBRAW_EXCEPTION_IO_CORRUPT;
-  struct jpeg_decompress_struct cinfo;
 
   unsigned sorder = order, ntags, opcode, deg, i, j, c;
-  unsigned trow = 0, tcol = 0, row, col;
-  INT64 save = data_offset - 4;
   ushort cur[4][256];
   double coeff[9], tot;
 
@@ -228,57 +464,115 @@ void LibRaw::lossy_dng_load_raw()
     FORC4 memcpy(cur[c], curve, sizeof cur[0]);
   }
 
-  struct jpeg_error_mgr pub;
-  cinfo.err = jpeg_std_error(&pub);
-  pub.error_exit = jpegErrorExit_d;
-
-  std::vector<JSAMPLE> buf;
-
-  jpeg_create_decompress(&cinfo);
+  /* tile offsets are read up front, tiles decode independently */
+  std::vector<INT64> offsets(1, INT64(data_offset));
+  unsigned tiles_across = 1;
+  if (tile_length < INT_MAX)
+  {
+    fseek(ifp, data_offset, SEEK_SET);
+    if (!dng_tile_offsets(offsets, tiles_across))
+      throw LIBRAW_EXCEPTION_DECODE_JPEG;
+  }
+  int tile_count = int(offsets.size());
 
-  while (trow < raw_height)
+#ifdef LIBRAW_USE_OPENMP
+  int thread_count = MIN(omp_get_max_threads(), tile_count);
+#else
+  int thread_count = 1;
+#endif
+  std::vector<lossy_dng_decoder_t> decoders(thread_count);
+  try
   {
-    fseek(ifp, save += 4, SEEK_SET);
-    if (tile_length < INT_MAX)
-      fseek(ifp, get4(), SEEK_SET);
-    if (libraw_internal_data.internal_data.input->jpeg_src(&cinfo) == -1)
+    for (int t = 0; t < thread_count; t++)
     {
-      jpeg_destroy_decompress(&cinfo);
-      throw LIBRAW_EXCEPTION_DECODE_JPEG;
+      decoders[t].cinfo.err = jpeg_std_error(&decoders[t].pub);
+      decoders[t].pub.error_exit = jpegErrorExit_d;
+      jpeg_create_decompress(&decoders[t].cinfo);
+      decoders[t].created = true;
     }
-    jpeg_read_header(&cinfo, TRUE);
-    jpeg_start_decompress(&cinfo);
-	if (cinfo.output_components != colors)
-		throw LIBRAW_EXCEPTION_DECODE_JPEG;
-
-	if (buf.size() < cinfo.output_width * cinfo.output_components)
-		buf = std::vector<JSAMPLE>(cinfo.output_width * cinfo.output_components,0);
+  }
+  catch (...)
+  {
+    for (int t = 0; t < thread_count; t++)
+      if (decoders[t].created)
+        jpeg_destroy_decompress(&decoders[t].cinfo);
+    throw;
+  }
 
+  int error = 0;
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(thread_count)
+#endif
+  for (int tile = 0; tile < tile_count; tile++)
+  {
+    int failed;
+#pragma omp critical(dng_tile_error)
+    failed = error;
+    if (failed)
+      continue;
+#ifdef LIBRAW_USE_OPENMP
+    lossy_dng_decoder_t &d = decoders[omp_get_thread_num()];
+#else
+    lossy_dng_decoder_t &d = decoders[0];
+#endif
+    unsigned trow = (tile / tiles_across) * tile_length;
+    unsigned tcol = (tile % tiles_across) * tile_width;
+    unsigned row, col;
+    int code = 0;
+    LibRaw_tile_datastream in(ifp, offsets[tile]);
     try
     {
+      if (in.jpeg_src(&d.cinfo) == -1)
+        throw LIBRAW_EXCEPTION_DECODE_JPEG;
+      jpeg_read_header(&d.cinfo, TRUE);
+      jpeg_start_decompress(&d.cinfo);
+      if (d.cinfo.output_components != colors)
+        throw LIBRAW_EXCEPTION_DECODE_JPEG;
+
+      if (d.buf.size() < d.cinfo.output_width * d.cinfo.output_components)
+        d.buf = std::vector<JSAMPLE>(d.cinfo.output_width * d.cinfo.output_components, 0);
+
       JSAMPLE *buffer_array[1];
-      buffer_array[0] = buf.data();
-      while (cinfo.output_scanline < cinfo.output_height &&
-             (row = trow + cinfo.output_scanline) < height)
+      buffer_array[0] = d.buf.data();
+      while (d.cinfo.output_scanline < d.cinfo.output_height &&
+             (row = trow + d.cinfo.output_scanline) < height)
       {
         checkCancel();
-        jpeg_read_scanlines(&cinfo, buffer_array, 1);
-        for (col = 0; col < cinfo.output_width && tcol + col < width; col++)
+        jpeg_read_scanlines(&d.cinfo, buffer_array, 1);
+        for (col = 0; col < d.cinfo.output_width && tcol + col < width; col++)
         {
-          FORC(colors) image[row * width + tcol + col][c] = cur[c][buf[col*colors+c]];
+          FORC(colors) image[row * width + tcol + col][c] = cur[c][d.buf[col*colors+c]];
         }
       }
     }
+    catch (LibRaw_exceptions e)
+    {
+      code = e;
+    }
+    catch (std::bad_alloc &)
+    {
+      code = LIBRAW_EXCEPTION_ALLOC;
+    }
     catch (...)
     {
-      jpeg_destroy_decompress(&cinfo);
-      throw;
+      code = LIBRAW_EXCEPTION_DECODE_JPEG;
+    }
+    jpeg_abort_decompress(&d.cinfo);
+    if (code)
+    {
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp critical(dng_tile_error)
+#endif
+      if (!error)
+        error = code;
     }
-    jpeg_abort_decompress(&cinfo);
-    if ((tcol += tile_width) >= raw_width)
-      trow += tile_length + (tcol = 0);
   }
-  jpeg_destroy_decompress(&cinfo);
+
+  for (int t = 0; t < thread_count; t++)
+    if (decoders[t].created)
+      jpeg_destroy_decompress(&decoders[t].cinfo);
+  if (error)
+    throw LibRaw_exceptions(error);
   maximum = 0xffff;
 }
 #endif
@@ -326,6 +326,16 @@ void tile_stripe_data_t::init(tiff_ifd_t *ifd, const libraw_image_sizes_t& sizes
 }
 
 #ifdef USE_ZLIB
+/* deflate_dng_load_raw() per-thread state */
+struct fp_dng_inflater_t
+{
+  z_stream strm;
+  bool ready;
+  float max;
+  std::vector<uchar> cBuffer, uBuffer;
+  fp_dng_inflater_t() : ready(false), max(0.f) { memset(&strm, 0, sizeof(strm)); }
+};
+
 void LibRaw::deflate_dng_load_raw()
 {
   int iifd = find_ifd_by_offset(libraw_internal_data.unpacker_data.data_offset);
@@ -377,44 +387,116 @@ void LibRaw::deflate_dng_load_raw()
   if(INT64(tiles.maxBytesInTile) > INT64(imgdata.rawparams.max_raw_memory_mb) * INT64(1024 * 1024) )
     throw LIBRAW_EXCEPTION_TOOBIG;
 
-  std::vector<uchar> cBuffer(tiles.maxBytesInTile,0);
-  std::vector<uchar> uBuffer(tileBytes + tileRowBytes,0); // extra row for decoding
+#ifdef LIBRAW_USE_OPENMP
+  int thread_count = omp_get_max_threads();
+#else
+  int thread_count = 1;
+#endif
+  std::vector<fp_dng_inflater_t> inflaters(thread_count);
+  int error = 0;
+  int bytesps = ifd->bps >> 3;
+  LibRaw_abstract_datastream *input = libraw_internal_data.internal_data.input;
 
-  for (size_t y = 0, t = 0; y < imgdata.sizes.raw_height; y += tiles.tileHeight)
+  try
+  {
+    for (int i = 0; i < thread_count; i++)
     {
-      for (size_t x = 0; x < imgdata.sizes.raw_width; x += tiles.tileWidth, ++t)
-      {
-        libraw_internal_data.internal_data.input->seek(tiles.tOffsets[t], SEEK_SET);
-        libraw_internal_data.internal_data.input->read(cBuffer.data(), 1, tiles.tBytes[t]);
-        unsigned long dstLen = tileBytes;
-        int err =
-            uncompress(uBuffer.data() + tileRowBytes, &dstLen, cBuffer.data(), (unsigned long)tiles.tBytes[t]);
-        if (err != Z_OK)
-        {
-          throw LIBRAW_EXCEPTION_DECODE_RAW;
-          return;
-        }
-        else
-        {
-          int bytesps = ifd->bps >> 3;
-          size_t rowsInTile = y + tiles.tileHeight > imgdata.sizes.raw_height ? imgdata.sizes.raw_height - y : tiles.tileHeight;
-          size_t colsInTile = x + tiles.tileWidth > imgdata.sizes.raw_width ? imgdata.sizes.raw_width - x : tiles.tileWidth;
-
-          for (size_t row = 0; row < rowsInTile; ++row) // do not process full tile if not needed
-          {
-              unsigned char *dst = uBuffer.data() + row * tiles.tileWidth * bytesps * ifd->samples;
-              unsigned char *src = dst + tileRowBytes;
-              DecodeFPDelta(src, dst, tiles.tileWidth / xFactor, ifd->samples * xFactor, bytesps);
-              float lmax = expandFloats(dst, tiles.tileWidth * ifd->samples, bytesps);
-            max = MAX(max, lmax);
-            unsigned char *dst2 = (unsigned char *)&float_raw_image
-                [((y + row) * imgdata.sizes.raw_width + x) * ifd->samples];
-            memmove(dst2, dst, colsInTile * ifd->samples * sizeof(float));
-          }
-        }
-      }
+      inflaters[i].cBuffer.resize(tiles.maxBytesInTile);
+      inflaters[i].uBuffer.resize(tileBytes + tileRowBytes); // extra row for decoding
+      if (inflateInit(&inflaters[i].strm) != Z_OK)
+        throw LIBRAW_EXCEPTION_ALLOC;
+      inflaters[i].ready = true;
+    }
+  }
+  catch (...)
+  {
+    for (int i = 0; i < thread_count; i++)
+      if (inflaters[i].ready)
+        inflateEnd(&inflaters[i].strm);
+    free(float_raw_image);
+    throw LIBRAW_EXCEPTION_ALLOC;
+  }
+
+  /* Tiles are independent: each thread inflates whole tiles with its own
+     z_stream and buffers and keeps its own maximum, merged below */
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int t = 0; t < tiles.tileCnt; t++)
+  {
+    int failed;
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp critical(dng_tile_error)
+#endif
+    failed = error;
+    if (failed)
+      continue;
+#ifdef LIBRAW_USE_OPENMP
+    fp_dng_inflater_t &z = inflaters[omp_get_thread_num()];
+#else
+    fp_dng_inflater_t &z = inflaters[0];
+#endif
+    size_t y = (t / tiles.tilesH) * size_t(tiles.tileHeight);
+    size_t x = (t % tiles.tilesH) * size_t(tiles.tileWidth);
+
+    // memory-backed streams read without sharing the stream position
+    if (input->concurrent_reads())
+      input->read_at(z.cBuffer.data(), tiles.tBytes[t], tiles.tOffsets[t]);
+    else
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp critical(dng_tile_read)
+#endif
+    {
+      input->seek(tiles.tOffsets[t], SEEK_SET);
+      input->read(z.cBuffer.data(), 1, tiles.tBytes[t]);
+    }
+
+    /* same result as uncompress(), without a new z_stream per tile */
+    int err = inflateReset(&z.strm);
+    if (err == Z_OK)
+    {
+      z.strm.next_in = z.cBuffer.data();
+      z.strm.avail_in = uInt(tiles.tBytes[t]);
+      z.strm.next_out = z.uBuffer.data() + tileRowBytes;
+      z.strm.avail_out = tileBytes;
+      err = inflate(&z.strm, Z_FINISH) == Z_STREAM_END ? Z_OK : Z_DATA_ERROR;
+    }
+    if (err != Z_OK)
+    {
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp critical(dng_tile_error)
+#endif
+      error = 1;
+      continue;
+    }
+
+    size_t rowsInTile = y + tiles.tileHeight > imgdata.sizes.raw_height ? imgdata.sizes.raw_height - y : tiles.tileHeight;
+    size_t colsInTile = x + tiles.tileWidth > imgdata.sizes.raw_width ? imgdata.sizes.raw_width - x : tiles.tileWidth;
+
+    for (size_t row = 0; row < rowsInTile; ++row) // do not process full tile if not needed
+    {
+      unsigned char *dst = z.uBuffer.data() + row * tiles.tileWidth * bytesps * ifd->samples;
+      unsigned char *src = dst + tileRowBytes;
+      DecodeFPDelta(src, dst, tiles.tileWidth / xFactor, ifd->samples * xFactor, bytesps);
+      float lmax = expandFloats(dst, tiles.tileWidth * ifd->samples, bytesps);
+      z.max = MAX(z.max, lmax);
+      unsigned char *dst2 = (unsigned char *)&float_raw_image
+          [((y + row) * imgdata.sizes.raw_width + x) * ifd->samples];
+      memmove(dst2, dst, colsInTile * ifd->samples * sizeof(float));
     }
-  
+  }
+
+  for (int i = 0; i < thread_count; i++)
+  {
+    inflateEnd(&inflaters[i].strm);
+    max = MAX(max, inflaters[i].max);
+  }
+  if (error)
+  {
+    free(float_raw_image);
+    throw LIBRAW_EXCEPTION_DECODE_RAW;
+  }
+
   imgdata.color.fmaximum = max;
 
   // Set fields according to data format
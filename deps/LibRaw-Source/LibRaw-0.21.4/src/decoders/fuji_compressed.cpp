@@ -231,6 +231,11 @@ static inline void fuji_fill_buffer(fuji_compressed_block *info)
   {
     info->cur_pos = 0;
     info->cur_buf_offset += info->cur_buf_size;
+    // memory-backed streams read without sharing the stream position
+    if (info->input->concurrent_reads())
+      info->cur_buf_size = info->input->read_at(info->cur_buf, _min(info->max_read_size, XTRANS_BUF_SIZE),
+                                                info->cur_buf_offset);
+    else
 #ifdef LIBRAW_USE_OPENMP
 #pragma omp critical
 #endif
@@ -243,19 +248,19 @@ static inline void fuji_fill_buffer(fuji_compressed_block *info)
 #ifndef LIBRAW_USE_OPENMP
       info->input->unlock();
 #endif
-      if (info->cur_buf_size < 1) // nothing read
+    }
+    if (info->cur_buf_size < 1) // nothing read
+    {
+      if (info->fillbytes > 0)
       {
-        if (info->fillbytes > 0)
-        {
-          int ls = _max(1, _min(info->fillbytes, XTRANS_BUF_SIZE));
-          memset(info->cur_buf, 0, ls);
-          info->fillbytes -= ls;
-        }
-        else
-          throw LIBRAW_EXCEPTION_IO_EOF;
+        int ls = _max(1, _min(info->fillbytes, XTRANS_BUF_SIZE));
+        memset(info->cur_buf, 0, ls);
+        info->fillbytes -= ls;
       }
-      info->max_read_size -= info->cur_buf_size;
+      else
+        throw LIBRAW_EXCEPTION_IO_EOF;
     }
+    info->max_read_size -= info->cur_buf_size;
   }
 }
 
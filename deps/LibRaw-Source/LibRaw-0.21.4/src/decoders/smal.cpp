@@ -88,7 +88,7 @@ void LibRaw::smal_decode_segment(unsigned seg[2][2], int holes)
     diff = sym[2] << 5 | sym[1] << 2 | (sym[0] & 3);
     if (sym[0] & 4)
       diff = diff ? -diff : 0x80;
-    if (ftell(ifp) + 12 >= seg[1][1])
+    if (getbits_tell() + 12 >= seg[1][1])
       diff = 0;
     if (pix >= unsigned(raw_width * raw_height))
       throw LIBRAW_EXCEPTION_IO_CORRUPT;
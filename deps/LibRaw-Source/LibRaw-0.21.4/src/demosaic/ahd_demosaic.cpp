@@ -296,20 +296,36 @@ void LibRaw::ahd_interpolate()
     cielab(0, 0);
     border_interpolate(5);
 
+    /* Tiles overlap by 6 pixels and only read raw samples, so every tile can
+       be processed independently. Handing out single tiles rather than whole
+       tile rows keeps all threads busy on images only a few tiles high. */
+    const int step = LIBRAW_AHD_TILE - 6;
+    const int tile_rows = (height - 7 + step - 1) / step;
+    const int tile_cols = (width - 7 + step - 1) / step;
+    const int tile_count =
+        (tile_rows > 0 && tile_cols > 0) ? tile_rows * tile_cols : 0;
+
 #ifdef LIBRAW_USE_OPENMP
     int buffer_count = omp_get_max_threads();
 #else
     int buffer_count = 1;
 #endif
 
+    /* One scratch buffer per thread, allocated once for the whole image */
     size_t buffer_size = 26 * LIBRAW_AHD_TILE * LIBRAW_AHD_TILE; /* 1664 kB */
     char** buffers = malloc_omp_buffers(buffer_count, buffer_size);
 
 #ifdef LIBRAW_USE_OPENMP
-#pragma omp parallel for schedule(dynamic) default(none) shared(terminate_flag) firstprivate(buffers)
+#pragma omp parallel for schedule(dynamic) default(none) shared(terminate_flag) firstprivate(buffers, step, tile_cols, tile_count)
 #endif
-    for (int top = 2; top < height - 5; top += LIBRAW_AHD_TILE - 6)
+    for (int tile = 0; tile < tile_count; tile++)
     {
+        if (terminate_flag)
+            continue;
+
+        int top = 2 + (tile / tile_cols) * step;
+        int left = 2 + (tile % tile_cols) * step;
+
 #ifdef LIBRAW_USE_OPENMP
         if (0 == omp_get_thread_num())
 #endif
@@ -317,7 +333,7 @@ void LibRaw::ahd_interpolate()
             {
                 int rr = (*callbacks.progress_cb)(callbacks.progresscb_data,
                     LIBRAW_PROGRESS_INTERPOLATE,
-                    top - 2, height - 7);
+                    tile, tile_count);
                 if (rr)
                     terminate_flag = 1;
             }
@@ -338,14 +354,10 @@ void LibRaw::ahd_interpolate()
         homo = (char(*)[LIBRAW_AHD_TILE][2])(buffer + 24 * LIBRAW_AHD_TILE *
             LIBRAW_AHD_TILE);
 
-        for (int left = 2; !terminate_flag && (left < width - 5);
-            left += LIBRAW_AHD_TILE - 6)
-        {
-            ahd_interpolate_green_h_and_v(top, left, rgb);
-            ahd_interpolate_r_and_b_and_convert_to_cielab(top, left, rgb, lab);
-            ahd_interpolate_build_homogeneity_map(top, left, lab, homo);
-            ahd_interpolate_combine_homogeneous_pixels(top, left, rgb, homo);
-        }
+        ahd_interpolate_green_h_and_v(top, left, rgb);
+        ahd_interpolate_r_and_b_and_convert_to_cielab(top, left, rgb, lab);
+        ahd_interpolate_build_homogeneity_map(top, left, lab, homo);
+        ahd_interpolate_combine_homogeneous_pixels(top, left, rgb, homo);
     }
 
     free_omp_buffers(buffers, buffer_count);
@@ -39,13 +39,99 @@
 
 // last modification: 11.07.2010
 
+#ifdef _OPENMP
+#include <thread> /* ahead of the dcraw_defs.h macros */
+#endif
 #include "../../internal/dcraw_defs.h"
 
+/* Several DCB and FBDD passes update the image in place and read neighbours
+   that earlier rows of the same pass have already rewritten, so their rows
+   cannot simply be split between threads. Instead rows are dealt to the
+   threads round-robin and processed in column spans; a span starts once the
+   row it depends on (lag rows above) has finished the span to its right.
+   Every pixel then reads exactly the values the sequential loop would. */
+class dcb_row_pipeline
+{
+public:
+  dcb_row_pipeline(int first_row, int last_row, int first_col, int last_col,
+                   int lag);
+  ~dcb_row_pipeline() { free((void *)progress); }
+
+  int parallel() const { return progress != 0; }
+  int spans() const { return span_count; }
+  int span_start(int span) const { return first_col + span * span_width; }
+  int span_end(int span) const
+  {
+    return MIN(first_col + (span + 1) * span_width, last_col);
+  }
+  void wait(int row, int span) const;
+  void finish(int row, int span);
+
+private:
+  int first_row, first_col, last_col, lag, span_width, span_count;
+  volatile int *progress; /* spans finished in each row */
+};
+
+dcb_row_pipeline::dcb_row_pipeline(int first_row, int last_row, int first_col,
+                                   int last_col, int lag)
+    : first_row(first_row), first_col(first_col), last_col(last_col),
+      lag(lag), span_width(last_col - first_col), span_count(1), progress(0)
+{
+#ifdef LIBRAW_USE_OPENMP
+  const int span = 128; /* even, so spans keep the Bayer column parity */
+  if (omp_get_max_threads() > 1 && last_row - first_row > 2 * lag &&
+      last_col - first_col > 2 * span)
+  {
+    span_width = span;
+    span_count = (last_col - first_col + span - 1) / span;
+    progress = (volatile int *)calloc(last_row - first_row, sizeof(int));
+  }
+#else
+  (void)last_row;
+#endif
+}
+
+void dcb_row_pipeline::wait(int row, int span) const
+{
+#ifdef LIBRAW_USE_OPENMP
+  if (!progress || row - lag < first_row)
+    return;
+  int needed = MIN(span + 2, span_count);
+  volatile int *above = progress + (row - lag - first_row);
+  while (*above < needed)
+  {
+    std::this_thread::yield();
+#pragma omp flush
+  }
+#pragma omp flush
+#else
+  (void)row;
+  (void)span;
+#endif
+}
+
+void dcb_row_pipeline::finish(int row, int span)
+{
+#ifdef LIBRAW_USE_OPENMP
+  if (!progress)
+    return;
+#pragma omp flush
+  progress[row - first_row] = span + 1;
+#pragma omp flush
+#else
+  (void)row;
+  (void)span;
+#endif
+}
+
 // interpolates green vertically and saves it to image3
 void LibRaw::dcb_ver(float (*image3)[3])
 {
   int row, col, u = width, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, indx) schedule(static)
+#endif
   for (row = 2; row < height - 2; row++)
     for (col = 2 + (FC(row, 2) & 1), indx = row * width + col; col < u - 2;
          col += 2, indx += 2)
@@ -60,6 +146,9 @@ void LibRaw::dcb_hor(float (*image2)[3])
 {
   int row, col, u = width, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, indx) schedule(static)
+#endif
   for (row = 2; row < height - 2; row++)
     for (col = 2 + (FC(row, 2) & 1), indx = row * width + col; col < u - 2;
          col += 2, indx += 2)
@@ -74,6 +163,10 @@ void LibRaw::dcb_color()
 {
   int row, col, c, d, u = width, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, indx)                 \
+    schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
     for (col = 1 + (FC(row, 1) & 1), indx = row * width + col,
         c = 2 - FC(row, col);
@@ -88,6 +181,10 @@ void LibRaw::dcb_color()
                             4.0);
     }
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, d, indx)              \
+    schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
     for (col = 1 + (FC(row, 2) & 1), indx = row * width + col,
         c = FC(row, col + 1), d = 2 - c;
@@ -110,6 +207,10 @@ void LibRaw::dcb_color2(float (*image2)[3])
 {
   int row, col, c, d, u = width, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, indx)                 \
+    schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
     for (col = 1 + (FC(row, 1) & 1), indx = row * width + col,
         c = 2 - FC(row, col);
@@ -125,6 +226,10 @@ void LibRaw::dcb_color2(float (*image2)[3])
                4.0);
     }
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, d, indx)              \
+    schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
     for (col = 1 + (FC(row, 2) & 1), indx = row * width + col,
         c = FC(row, col + 1), d = 2 - c;
@@ -144,6 +249,10 @@ void LibRaw::dcb_color3(float (*image3)[3])
 {
   int row, col, c, d, u = width, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, indx)                 \
+    schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
     for (col = 1 + (FC(row, 1) & 1), indx = row * width + col,
         c = 2 - FC(row, col);
@@ -159,6 +268,10 @@ void LibRaw::dcb_color3(float (*image3)[3])
                4.0);
     }
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, d, indx)              \
+    schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
     for (col = 1 + (FC(row, 2) & 1), indx = row * width + col,
         c = FC(row, col + 1), d = 2 - c;
@@ -179,6 +292,11 @@ void LibRaw::dcb_decide(float (*image2)[3], float (*image3)[3])
   int row, col, c, d, u = width, v = 2 * u, indx;
   float current, current2, current3;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared)                                       \
+    private(col, c, d, indx, current, current2, current3)                      \
+    schedule(static)
+#endif
   for (row = 2; row < height - 2; row++)
     for (col = 2 + (FC(row, 2) & 1), indx = row * width + col, c = FC(row, col);
          col < u - 2; col += 2, indx += 2)
@@ -239,6 +357,9 @@ void LibRaw::dcb_copy_to_buffer(float (*image2)[3])
 {
   int indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) schedule(static)
+#endif
   for (indx = 0; indx < height * width; indx++)
   {
     image2[indx][0] = image[indx][0]; // R
@@ -251,6 +372,9 @@ void LibRaw::dcb_restore_from_buffer(float (*image2)[3])
 {
   int indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) schedule(static)
+#endif
   for (indx = 0; indx < height * width; indx++)
   {
     image[indx][0] = image2[indx][0]; // R
@@ -261,50 +385,70 @@ void LibRaw::dcb_restore_from_buffer(float (*image2)[3])
 // R and B smoothing using green contrast, all pixels except 2 pixel wide border
 void LibRaw::dcb_pp()
 {
-  int g1, r1, b1, u = width, indx, row, col;
+  int g1, r1, b1, u = width, indx, row, col, span;
+  dcb_row_pipeline pipe(2, height - 2, 2, width - 2, 1);
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(g1, r1, b1, indx, col, span)  \
+    schedule(static, 1) if (pipe.parallel())
+#endif
   for (row = 2; row < height - 2; row++)
-    for (col = 2, indx = row * u + col; col < width - 2; col++, indx++)
+    for (span = 0; span < pipe.spans(); span++)
     {
-
-      r1 = (image[indx - 1][0] + image[indx + 1][0] + image[indx - u][0] +
-            image[indx + u][0] + image[indx - u - 1][0] +
-            image[indx + u + 1][0] + image[indx - u + 1][0] +
-            image[indx + u - 1][0]) /
-           8.0;
-      g1 = (image[indx - 1][1] + image[indx + 1][1] + image[indx - u][1] +
-            image[indx + u][1] + image[indx - u - 1][1] +
-            image[indx + u + 1][1] + image[indx - u + 1][1] +
-            image[indx + u - 1][1]) /
-           8.0;
-      b1 = (image[indx - 1][2] + image[indx + 1][2] + image[indx - u][2] +
-            image[indx + u][2] + image[indx - u - 1][2] +
-            image[indx + u + 1][2] + image[indx - u + 1][2] +
-            image[indx + u - 1][2]) /
-           8.0;
-
-      image[indx][0] = CLIP(r1 + (image[indx][1] - g1));
-      image[indx][2] = CLIP(b1 + (image[indx][1] - g1));
+      pipe.wait(row, span);
+      for (col = pipe.span_start(span), indx = row * u + col;
+           col < pipe.span_end(span); col++, indx++)
+      {
+        r1 = (image[indx - 1][0] + image[indx + 1][0] + image[indx - u][0] +
+              image[indx + u][0] + image[indx - u - 1][0] +
+              image[indx + u + 1][0] + image[indx - u + 1][0] +
+              image[indx + u - 1][0]) /
+             8.0;
+        g1 = (image[indx - 1][1] + image[indx + 1][1] + image[indx - u][1] +
+              image[indx + u][1] + image[indx - u - 1][1] +
+              image[indx + u + 1][1] + image[indx - u + 1][1] +
+              image[indx + u - 1][1]) /
+             8.0;
+        b1 = (image[indx - 1][2] + image[indx + 1][2] + image[indx - u][2] +
+              image[indx + u][2] + image[indx - u - 1][2] +
+              image[indx + u + 1][2] + image[indx - u + 1][2] +
+              image[indx + u - 1][2]) /
+             8.0;
+
+        image[indx][0] = CLIP(r1 + (image[indx][1] - g1));
+        image[indx][2] = CLIP(b1 + (image[indx][1] - g1));
+      }
+      pipe.finish(row, span);
     }
 }
 
 // green blurring correction, helps to get the nyquist right
 void LibRaw::dcb_nyquist()
 {
-  int row, col, c, u = width, v = 2 * u, indx;
+  int row, col, c, u = width, v = 2 * u, indx, span;
+  dcb_row_pipeline pipe(2, height - 2, 2, u - 2, 2);
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, indx, span)           \
+    schedule(static, 1) if (pipe.parallel())
+#endif
   for (row = 2; row < height - 2; row++)
-    for (col = 2 + (FC(row, 2) & 1), indx = row * width + col, c = FC(row, col);
-         col < u - 2; col += 2, indx += 2)
+    for (span = 0; span < pipe.spans(); span++)
     {
-
-      image[indx][1] = CLIP((image[indx + v][1] + image[indx - v][1] +
-                             image[indx - 2][1] + image[indx + 2][1]) /
-                                4.0 +
-                            image[indx][c] -
-                            (image[indx + v][c] + image[indx - v][c] +
-                             image[indx - 2][c] + image[indx + 2][c]) /
-                                4.0);
+      pipe.wait(row, span);
+      for (col = pipe.span_start(span) + (FC(row, 2) & 1),
+          indx = row * width + col, c = FC(row, col);
+           col < pipe.span_end(span); col += 2, indx += 2)
+      {
+        image[indx][1] = CLIP((image[indx + v][1] + image[indx - v][1] +
+                               image[indx - 2][1] + image[indx + 2][1]) /
+                                  4.0 +
+                              image[indx][c] -
+                              (image[indx + v][c] + image[indx - v][c] +
+                               image[indx - 2][c] + image[indx + 2][c]) /
+                                  4.0);
+      }
+      pipe.finish(row, span);
     }
 }
 
@@ -312,17 +456,25 @@ void LibRaw::dcb_nyquist()
 // Rodríguez
 void LibRaw::dcb_color_full()
 {
-  int row, col, c, d, u = width, w = 3 * u, indx, g1, g2;
+  int row, col, c, d, u = width, w = 3 * u, indx, g1, g2, span;
   float f[4], g[4], (*chroma)[2];
 
   chroma = (float(*)[2])calloc(width * height, sizeof *chroma);
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, d, indx)              \
+    schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
     for (col = 1 + (FC(row, 1) & 1), indx = row * width + col, c = FC(row, col),
         d = c / 2;
          col < u - 1; col += 2, indx += 2)
       chroma[indx][d] = image[indx][c] - image[indx][1];
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, d, indx, f, g)        \
+    schedule(static)
+#endif
   for (row = 3; row < height - 3; row++)
     for (col = 3 + (FC(row, 1) & 1), indx = row * width + col,
         c = 1 - FC(row, col) / 2, d = 1 - c;
@@ -360,6 +512,10 @@ void LibRaw::dcb_color_full()
           (f[0] * g[0] + f[1] * g[1] + f[2] * g[2] + f[3] * g[3]) /
           (f[0] + f[1] + f[2] + f[3]);
     }
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, d, indx, f, g)        \
+    schedule(static)
+#endif
   for (row = 3; row < height - 3; row++)
     for (col = 3 + (FC(row, 2) & 1), indx = row * width + col,
         c = FC(row, col + 1) / 2;
@@ -393,51 +549,66 @@ void LibRaw::dcb_color_full()
             (f[0] + f[1] + f[2] + f[3]);
       }
 
+  dcb_row_pipeline pipe(6, height - 6, 6, width - 6, 1);
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, indx, g1, g2, span)      \
+    schedule(static, 1) if (pipe.parallel())
+#endif
   for (row = 6; row < height - 6; row++)
-    for (col = 6, indx = row * width + col; col < width - 6; col++, indx++)
+    for (span = 0; span < pipe.spans(); span++)
     {
-      image[indx][0] = CLIP(chroma[indx][0] + image[indx][1]);
-      image[indx][2] = CLIP(chroma[indx][1] + image[indx][1]);
-
-      g1 = MIN(
-          image[indx + 1 + u][0],
-          MIN(image[indx + 1 - u][0],
-              MIN(image[indx - 1 + u][0],
-                  MIN(image[indx - 1 - u][0],
-                      MIN(image[indx - 1][0],
-                          MIN(image[indx + 1][0],
-                              MIN(image[indx - u][0], image[indx + u][0])))))));
-
-      g2 = MAX(
-          image[indx + 1 + u][0],
-          MAX(image[indx + 1 - u][0],
-              MAX(image[indx - 1 + u][0],
-                  MAX(image[indx - 1 - u][0],
-                      MAX(image[indx - 1][0],
-                          MAX(image[indx + 1][0],
-                              MAX(image[indx - u][0], image[indx + u][0])))))));
-
-      image[indx][0] = ULIM(image[indx][0], g2, g1);
-
-      g1 = MIN(
-          image[indx + 1 + u][2],
-          MIN(image[indx + 1 - u][2],
-              MIN(image[indx - 1 + u][2],
-                  MIN(image[indx - 1 - u][2],
-                      MIN(image[indx - 1][2],
-                          MIN(image[indx + 1][2],
-                              MIN(image[indx - u][2], image[indx + u][2])))))));
-
-      g2 = MAX(
-          image[indx + 1 + u][2],
-          MAX(image[indx + 1 - u][2],
-              MAX(image[indx - 1 + u][2],
-                  MAX(image[indx - 1 - u][2],
-                      MAX(image[indx - 1][2],
-                          MAX(image[indx + 1][2],
-                              MAX(image[indx - u][2], image[indx + u][2])))))));
-
-      image[indx][2] = ULIM(image[indx][2], g2, g1);
+      pipe.wait(row, span);
+      for (col = pipe.span_start(span), indx = row * width + col;
+           col < pipe.span_end(span); col++, indx++)
+      {
+        image[indx][0] = CLIP(chroma[indx][0] + image[indx][1]);
+        image[indx][2] = CLIP(chroma[indx][1] + image[indx][1]);
+
+        g1 = MIN(
+            image[indx + 1 + u][0],
+            MIN(image[indx + 1 - u][0],
+                MIN(image[indx - 1 + u][0],
+                    MIN(image[indx - 1 - u][0],
+                        MIN(image[indx - 1][0],
+                            MIN(image[indx + 1][0],
+                                MIN(image[indx - u][0],
+                                    image[indx + u][0])))))));
+
+        g2 = MAX(
+            image[indx + 1 + u][0],
+            MAX(image[indx + 1 - u][0],
+                MAX(image[indx - 1 + u][0],
+                    MAX(image[indx - 1 - u][0],
+                        MAX(image[indx - 1][0],
+                            MAX(image[indx + 1][0],
+                                MAX(image[indx - u][0],
+                                    image[indx + u][0])))))));
+
+        image[indx][0] = ULIM(image[indx][0], g2, g1);
+
+        g1 = MIN(
+            image[indx + 1 + u][2],
+            MIN(image[indx + 1 - u][2],
+                MIN(image[indx - 1 + u][2],
+                    MIN(image[indx - 1 - u][2],
+                        MIN(image[indx - 1][2],
+                            MIN(image[indx + 1][2],
+                                MIN(image[indx - u][2],
+                                    image[indx + u][2])))))));
+
+        g2 = MAX(
+            image[indx + 1 + u][2],
+            MAX(image[indx + 1 - u][2],
+                MAX(image[indx - 1 + u][2],
+                    MAX(image[indx - 1 - u][2],
+                        MAX(image[indx - 1][2],
+                            MAX(image[indx + 1][2],
+                                MAX(image[indx - u][2],
+                                    image[indx + u][2])))))));
+
+        image[indx][2] = ULIM(image[indx][2], g2, g1);
+      }
+      pipe.finish(row, span);
     }
 
   free(chroma);
@@ -450,6 +621,9 @@ void LibRaw::dcb_map()
 {
   int row, col, u = width, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, indx) schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
   {
     for (col = 1, indx = row * width + col; col < width - 1; col++, indx++)
@@ -476,6 +650,10 @@ void LibRaw::dcb_correction()
 {
   int current, row, col, u = width, v = 2 * u, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(current, col, indx)           \
+    schedule(static)
+#endif
   for (row = 2; row < height - 2; row++)
     for (col = 2 + (FC(row, 2) & 1), indx = row * width + col; col < u - 2;
          col += 2, indx += 2)
@@ -500,6 +678,10 @@ void LibRaw::dcb_correction2()
 {
   int current, row, col, c, u = width, v = 2 * u, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(current, col, c, indx)        \
+    schedule(static)
+#endif
   for (row = 4; row < height - 4; row++)
     for (col = 4 + (FC(row, 2) & 1), indx = row * width + col, c = FC(row, col);
          col < u - 4; col += 2, indx += 2)
@@ -524,108 +706,121 @@ void LibRaw::dcb_correction2()
 
 void LibRaw::dcb_refinement()
 {
-  int row, col, c, u = width, v = 2 * u, w = 3 * u, indx, current;
+  int row, col, c, u = width, v = 2 * u, w = 3 * u, indx, current, span;
   float f[5], g1, g2;
+  dcb_row_pipeline pipe(4, height - 4, 4, u - 4, 1);
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared)                                       \
+    private(col, c, indx, current, f, g1, g2, span)                            \
+    schedule(static, 1) if (pipe.parallel())
+#endif
   for (row = 4; row < height - 4; row++)
-    for (col = 4 + (FC(row, 2) & 1), indx = row * width + col, c = FC(row, col);
-         col < u - 4; col += 2, indx += 2)
+    for (span = 0; span < pipe.spans(); span++)
     {
-
-      current = 4 * image[indx][3] +
-                2 * (image[indx + u][3] + image[indx - u][3] +
-                     image[indx + 1][3] + image[indx - 1][3]) +
-                image[indx + v][3] + image[indx - v][3] + image[indx - 2][3] +
-                image[indx + 2][3];
-
-      if (image[indx][c] > 1)
+      pipe.wait(row, span);
+      for (col = pipe.span_start(span) + (FC(row, 2) & 1),
+          indx = row * width + col, c = FC(row, col);
+           col < pipe.span_end(span); col += 2, indx += 2)
       {
+        current = 4 * image[indx][3] +
+                  2 * (image[indx + u][3] + image[indx - u][3] +
+                       image[indx + 1][3] + image[indx - 1][3]) +
+                  image[indx + v][3] + image[indx - v][3] + image[indx - 2][3] +
+                  image[indx + 2][3];
 
-        f[0] = (float)(image[indx - u][1] + image[indx + u][1]) /
-               (2 * image[indx][c]);
-
-        if (image[indx - v][c] > 0)
-          f[1] = 2 * (float)image[indx - u][1] /
-                 (image[indx - v][c] + image[indx][c]);
-        else
-          f[1] = f[0];
-
-        if (image[indx - v][c] > 0)
-          f[2] = (float)(image[indx - u][1] + image[indx - w][1]) /
-                 (2 * image[indx - v][c]);
-        else
-          f[2] = f[0];
-
-        if (image[indx + v][c] > 0)
-          f[3] = 2 * (float)image[indx + u][1] /
-                 (image[indx + v][c] + image[indx][c]);
-        else
-          f[3] = f[0];
-
-        if (image[indx + v][c] > 0)
-          f[4] = (float)(image[indx + u][1] + image[indx + w][1]) /
-                 (2 * image[indx + v][c]);
-        else
-          f[4] = f[0];
-
-        g1 = (5 * f[0] + 3 * f[1] + f[2] + 3 * f[3] + f[4]) / 13.0;
-
-        f[0] = (float)(image[indx - 1][1] + image[indx + 1][1]) /
-               (2 * image[indx][c]);
-
-        if (image[indx - 2][c] > 0)
-          f[1] = 2 * (float)image[indx - 1][1] /
-                 (image[indx - 2][c] + image[indx][c]);
-        else
-          f[1] = f[0];
-
-        if (image[indx - 2][c] > 0)
-          f[2] = (float)(image[indx - 1][1] + image[indx - 3][1]) /
-                 (2 * image[indx - 2][c]);
-        else
-          f[2] = f[0];
-
-        if (image[indx + 2][c] > 0)
-          f[3] = 2 * (float)image[indx + 1][1] /
-                 (image[indx + 2][c] + image[indx][c]);
-        else
-          f[3] = f[0];
+        if (image[indx][c] > 1)
+        {
 
-        if (image[indx + 2][c] > 0)
-          f[4] = (float)(image[indx + 1][1] + image[indx + 3][1]) /
-                 (2 * image[indx + 2][c]);
+          f[0] = (float)(image[indx - u][1] + image[indx + u][1]) /
+                 (2 * image[indx][c]);
+
+          if (image[indx - v][c] > 0)
+            f[1] = 2 * (float)image[indx - u][1] /
+                   (image[indx - v][c] + image[indx][c]);
+          else
+            f[1] = f[0];
+
+          if (image[indx - v][c] > 0)
+            f[2] = (float)(image[indx - u][1] + image[indx - w][1]) /
+                   (2 * image[indx - v][c]);
+          else
+            f[2] = f[0];
+
+          if (image[indx + v][c] > 0)
+            f[3] = 2 * (float)image[indx + u][1] /
+                   (image[indx + v][c] + image[indx][c]);
+          else
+            f[3] = f[0];
+
+          if (image[indx + v][c] > 0)
+            f[4] = (float)(image[indx + u][1] + image[indx + w][1]) /
+                   (2 * image[indx + v][c]);
+          else
+            f[4] = f[0];
+
+          g1 = (5 * f[0] + 3 * f[1] + f[2] + 3 * f[3] + f[4]) / 13.0;
+
+          f[0] = (float)(image[indx - 1][1] + image[indx + 1][1]) /
+                 (2 * image[indx][c]);
+
+          if (image[indx - 2][c] > 0)
+            f[1] = 2 * (float)image[indx - 1][1] /
+                   (image[indx - 2][c] + image[indx][c]);
+          else
+            f[1] = f[0];
+
+          if (image[indx - 2][c] > 0)
+            f[2] = (float)(image[indx - 1][1] + image[indx - 3][1]) /
+                   (2 * image[indx - 2][c]);
+          else
+            f[2] = f[0];
+
+          if (image[indx + 2][c] > 0)
+            f[3] = 2 * (float)image[indx + 1][1] /
+                   (image[indx + 2][c] + image[indx][c]);
+          else
+            f[3] = f[0];
+
+          if (image[indx + 2][c] > 0)
+            f[4] = (float)(image[indx + 1][1] + image[indx + 3][1]) /
+                   (2 * image[indx + 2][c]);
+          else
+            f[4] = f[0];
+
+          g2 = (5 * f[0] + 3 * f[1] + f[2] + 3 * f[3] + f[4]) / 13.0;
+
+          image[indx][1] = CLIP((image[indx][c]) *
+                                (current * g1 + (16 - current) * g2) / 16.0);
+        }
         else
-          f[4] = f[0];
-
-        g2 = (5 * f[0] + 3 * f[1] + f[2] + 3 * f[3] + f[4]) / 13.0;
-
-        image[indx][1] = CLIP((image[indx][c]) *
-                              (current * g1 + (16 - current) * g2) / 16.0);
+          image[indx][1] = image[indx][c];
+
+        // get rid of overshooted pixels
+
+        g1 = MIN(
+            image[indx + 1 + u][1],
+            MIN(image[indx + 1 - u][1],
+                MIN(image[indx - 1 + u][1],
+                    MIN(image[indx - 1 - u][1],
+                        MIN(image[indx - 1][1],
+                            MIN(image[indx + 1][1],
+                                MIN(image[indx - u][1],
+                                    image[indx + u][1])))))));
+
+        g2 = MAX(
+            image[indx + 1 + u][1],
+            MAX(image[indx + 1 - u][1],
+                MAX(image[indx - 1 + u][1],
+                    MAX(image[indx - 1 - u][1],
+                        MAX(image[indx - 1][1],
+                            MAX(image[indx + 1][1],
+                                MAX(image[indx - u][1],
+                                    image[indx + u][1])))))));
+
+        image[indx][1] = ULIM(image[indx][1], g2, g1);
       }
-      else
-        image[indx][1] = image[indx][c];
-
-      // get rid of overshooted pixels
-
-      g1 = MIN(
-          image[indx + 1 + u][1],
-          MIN(image[indx + 1 - u][1],
-              MIN(image[indx - 1 + u][1],
-                  MIN(image[indx - 1 - u][1],
-                      MIN(image[indx - 1][1],
-                          MIN(image[indx + 1][1],
-                              MIN(image[indx - u][1], image[indx + u][1])))))));
-
-      g2 = MAX(
-          image[indx + 1 + u][1],
-          MAX(image[indx + 1 - u][1],
-              MAX(image[indx - 1 + u][1],
-                  MAX(image[indx - 1 - u][1],
-                      MAX(image[indx - 1][1],
-                          MAX(image[indx + 1][1],
-                              MAX(image[indx - u][1], image[indx + u][1])))))));
-
-      image[indx][1] = ULIM(image[indx][1], g2, g1);
+      pipe.finish(row, span);
     }
 }
 
@@ -633,6 +828,9 @@ void LibRaw::dcb_refinement()
 void LibRaw::rgb_to_lch(double (*image2)[3])
 {
   int indx;
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) schedule(static)
+#endif
   for (indx = 0; indx < height * width; indx++)
   {
 
@@ -647,6 +845,9 @@ void LibRaw::rgb_to_lch(double (*image2)[3])
 void LibRaw::lch_to_rgb(double (*image2)[3])
 {
   int indx;
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) schedule(static)
+#endif
   for (indx = 0; indx < height * width; indx++)
   {
 
@@ -663,6 +864,10 @@ void LibRaw::fbdd_correction()
 {
   int row, col, c, u = width, indx;
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(col, c, indx)                 \
+    schedule(static)
+#endif
   for (row = 2; row < height - 2; row++)
   {
     for (col = 2, indx = row * width + col; col < width - 2; col++, indx++)
@@ -686,46 +891,58 @@ void LibRaw::fbdd_correction()
 void LibRaw::fbdd_correction2(double (*image2)[3])
 {
   int indx, v = 2 * width;
-  int col, row;
+  int col, row, span;
   double Co, Ho, ratio;
+  dcb_row_pipeline pipe(6, height - 6, 6, width - 6, 2);
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared)                                       \
+    private(col, indx, Co, Ho, ratio, span)                                    \
+    schedule(static, 1) if (pipe.parallel())
+#endif
   for (row = 6; row < height - 6; row++)
   {
-    for (col = 6; col < width - 6; col++)
+    for (span = 0; span < pipe.spans(); span++)
     {
-      indx = row * width + col;
-
-      if (image2[indx][1] * image2[indx][2] != 0)
+      pipe.wait(row, span);
+      for (col = pipe.span_start(span); col < pipe.span_end(span); col++)
       {
-        Co = (image2[indx + v][1] + image2[indx - v][1] + image2[indx - 2][1] +
-              image2[indx + 2][1] -
-              MAX(image2[indx - 2][1],
-                  MAX(image2[indx + 2][1],
-                      MAX(image2[indx - v][1], image2[indx + v][1]))) -
-              MIN(image2[indx - 2][1],
-                  MIN(image2[indx + 2][1],
-                      MIN(image2[indx - v][1], image2[indx + v][1])))) /
-             2.0;
-        Ho = (image2[indx + v][2] + image2[indx - v][2] + image2[indx - 2][2] +
-              image2[indx + 2][2] -
-              MAX(image2[indx - 2][2],
-                  MAX(image2[indx + 2][2],
-                      MAX(image2[indx - v][2], image2[indx + v][2]))) -
-              MIN(image2[indx - 2][2],
-                  MIN(image2[indx + 2][2],
-                      MIN(image2[indx - v][2], image2[indx + v][2])))) /
-             2.0;
-        ratio = sqrt((Co * Co + Ho * Ho) / (image2[indx][1] * image2[indx][1] +
-                                            image2[indx][2] * image2[indx][2]));
-
-        if (ratio < 0.85)
+        indx = row * width + col;
+
+        if (image2[indx][1] * image2[indx][2] != 0)
         {
-          image2[indx][0] =
-              -(image2[indx][1] + image2[indx][2] - Co - Ho) + image2[indx][0];
-          image2[indx][1] = Co;
-          image2[indx][2] = Ho;
+          Co = (image2[indx + v][1] + image2[indx - v][1] +
+                image2[indx - 2][1] + image2[indx + 2][1] -
+                MAX(image2[indx - 2][1],
+                    MAX(image2[indx + 2][1],
+                        MAX(image2[indx - v][1], image2[indx + v][1]))) -
+                MIN(image2[indx - 2][1],
+                    MIN(image2[indx + 2][1],
+                        MIN(image2[indx - v][1], image2[indx + v][1])))) /
+               2.0;
+          Ho = (image2[indx + v][2] + image2[indx - v][2] +
+                image2[indx - 2][2] + image2[indx + 2][2] -
+                MAX(image2[indx - 2][2],
+                    MAX(image2[indx + 2][2],
+                        MAX(image2[indx - v][2], image2[indx + v][2]))) -
+                MIN(image2[indx - 2][2],
+                    MIN(image2[indx + 2][2],
+                        MIN(image2[indx - v][2], image2[indx + v][2])))) /
+               2.0;
+          ratio =
+              sqrt((Co * Co + Ho * Ho) / (image2[indx][1] * image2[indx][1] +
+                                          image2[indx][2] * image2[indx][2]));
+
+          if (ratio < 0.85)
+          {
+            image2[indx][0] = -(image2[indx][1] + image2[indx][2] - Co - Ho) +
+                              image2[indx][0];
+            image2[indx][1] = Co;
+            image2[indx][2] = Ho;
+          }
         }
       }
+      pipe.finish(row, span);
     }
   }
 }
@@ -735,67 +952,80 @@ void LibRaw::fbdd_correction2(double (*image2)[3])
 void LibRaw::fbdd_green()
 {
   int row, col, c, u = width, v = 2 * u, w = 3 * u, x = 4 * u, y = 5 * u, indx,
-                   min, max;
+                   min, max, span;
   float f[4], g[4];
+  dcb_row_pipeline pipe(5, height - 5, 5, u - 5, 1);
 
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared)                                       \
+    private(col, c, indx, min, max, f, g, span)                                \
+    schedule(static, 1) if (pipe.parallel())
+#endif
   for (row = 5; row < height - 5; row++)
-    for (col = 5 + (FC(row, 1) & 1), indx = row * width + col, c = FC(row, col);
-         col < u - 5; col += 2, indx += 2)
+    for (span = 0; span < pipe.spans(); span++)
     {
-
-      f[0] = 1.0 / (1.0 + abs(image[indx - u][1] - image[indx - w][1]) +
-                    abs(image[indx - w][1] - image[indx + y][1]));
-      f[1] = 1.0 / (1.0 + abs(image[indx + 1][1] - image[indx + 3][1]) +
-                    abs(image[indx + 3][1] - image[indx - 5][1]));
-      f[2] = 1.0 / (1.0 + abs(image[indx - 1][1] - image[indx - 3][1]) +
-                    abs(image[indx - 3][1] - image[indx + 5][1]));
-      f[3] = 1.0 / (1.0 + abs(image[indx + u][1] - image[indx + w][1]) +
-                    abs(image[indx + w][1] - image[indx - y][1]));
-
-      g[0] = CLIP((23 * image[indx - u][1] + 23 * image[indx - w][1] +
-                   2 * image[indx - y][1] +
-                   8 * (image[indx - v][c] - image[indx - x][c]) +
-                   40 * (image[indx][c] - image[indx - v][c])) /
-                  48.0);
-      g[1] = CLIP((23 * image[indx + 1][1] + 23 * image[indx + 3][1] +
-                   2 * image[indx + 5][1] +
-                   8 * (image[indx + 2][c] - image[indx + 4][c]) +
-                   40 * (image[indx][c] - image[indx + 2][c])) /
-                  48.0);
-      g[2] = CLIP((23 * image[indx - 1][1] + 23 * image[indx - 3][1] +
-                   2 * image[indx - 5][1] +
-                   8 * (image[indx - 2][c] - image[indx - 4][c]) +
-                   40 * (image[indx][c] - image[indx - 2][c])) /
-                  48.0);
-      g[3] = CLIP((23 * image[indx + u][1] + 23 * image[indx + w][1] +
-                   2 * image[indx + y][1] +
-                   8 * (image[indx + v][c] - image[indx + x][c]) +
-                   40 * (image[indx][c] - image[indx + v][c])) /
-                  48.0);
-
-      image[indx][1] =
-          CLIP((f[0] * g[0] + f[1] * g[1] + f[2] * g[2] + f[3] * g[3]) /
-               (f[0] + f[1] + f[2] + f[3]));
-
-      min = MIN(
-          image[indx + 1 + u][1],
-          MIN(image[indx + 1 - u][1],
-              MIN(image[indx - 1 + u][1],
-                  MIN(image[indx - 1 - u][1],
-                      MIN(image[indx - 1][1],
-                          MIN(image[indx + 1][1],
-                              MIN(image[indx - u][1], image[indx + u][1])))))));
-
-      max = MAX(
-          image[indx + 1 + u][1],
-          MAX(image[indx + 1 - u][1],
-              MAX(image[indx - 1 + u][1],
-                  MAX(image[indx - 1 - u][1],
-                      MAX(image[indx - 1][1],
-                          MAX(image[indx + 1][1],
-                              MAX(image[indx - u][1], image[indx + u][1])))))));
-
-      image[indx][1] = ULIM(image[indx][1], max, min);
+      pipe.wait(row, span);
+      for (col = pipe.span_start(span) + (FC(row, 1) & 1),
+          indx = row * width + col, c = FC(row, col);
+           col < pipe.span_end(span); col += 2, indx += 2)
+      {
+        f[0] = 1.0 / (1.0 + abs(image[indx - u][1] - image[indx - w][1]) +
+                      abs(image[indx - w][1] - image[indx + y][1]));
+        f[1] = 1.0 / (1.0 + abs(image[indx + 1][1] - image[indx + 3][1]) +
+                      abs(image[indx + 3][1] - image[indx - 5][1]));
+        f[2] = 1.0 / (1.0 + abs(image[indx - 1][1] - image[indx - 3][1]) +
+                      abs(image[indx - 3][1] - image[indx + 5][1]));
+        f[3] = 1.0 / (1.0 + abs(image[indx + u][1] - image[indx + w][1]) +
+                      abs(image[indx + w][1] - image[indx - y][1]));
+
+        g[0] = CLIP((23 * image[indx - u][1] + 23 * image[indx - w][1] +
+                     2 * image[indx - y][1] +
+                     8 * (image[indx - v][c] - image[indx - x][c]) +
+                     40 * (image[indx][c] - image[indx - v][c])) /
+                    48.0);
+        g[1] = CLIP((23 * image[indx + 1][1] + 23 * image[indx + 3][1] +
+                     2 * image[indx + 5][1] +
+                     8 * (image[indx + 2][c] - image[indx + 4][c]) +
+                     40 * (image[indx][c] - image[indx + 2][c])) /
+                    48.0);
+        g[2] = CLIP((23 * image[indx - 1][1] + 23 * image[indx - 3][1] +
+                     2 * image[indx - 5][1] +
+                     8 * (image[indx - 2][c] - image[indx - 4][c]) +
+                     40 * (image[indx][c] - image[indx - 2][c])) /
+                    48.0);
+        g[3] = CLIP((23 * image[indx + u][1] + 23 * image[indx + w][1] +
+                     2 * image[indx + y][1] +
+                     8 * (image[indx + v][c] - image[indx + x][c]) +
+                     40 * (image[indx][c] - image[indx + v][c])) /
+                    48.0);
+
+        image[indx][1] =
+            CLIP((f[0] * g[0] + f[1] * g[1] + f[2] * g[2] + f[3] * g[3]) /
+                 (f[0] + f[1] + f[2] + f[3]));
+
+        min = MIN(
+            image[indx + 1 + u][1],
+            MIN(image[indx + 1 - u][1],
+                MIN(image[indx - 1 + u][1],
+                    MIN(image[indx - 1 - u][1],
+                        MIN(image[indx - 1][1],
+                            MIN(image[indx + 1][1],
+                                MIN(image[indx - u][1],
+                                    image[indx + u][1])))))));
+
+        max = MAX(
+            image[indx + 1 + u][1],
+            MAX(image[indx + 1 - u][1],
+                MAX(image[indx - 1 + u][1],
+                    MAX(image[indx - 1 - u][1],
+                        MAX(image[indx - 1][1],
+                            MAX(image[indx + 1][1],
+                                MAX(image[indx - u][1],
+                                    image[indx + u][1])))))));
+
+        image[indx][1] = ULIM(image[indx][1], max, min);
+      }
+      pipe.finish(row, span);
     }
 }
 
@@ -105,6 +105,9 @@ void LibRaw::border_interpolate(int border)
 void LibRaw::lin_interpolate_loop(int *code, int size)
 {
   int row;
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) schedule(static)
+#endif
   for (row = 1; row < height - 1; row++)
   {
     int col, *ip;
@@ -166,6 +169,17 @@ void LibRaw::lin_interpolate()
   RUN_CALLBACK(LIBRAW_PROGRESS_INTERPOLATE, 2, 3);
 }
 
+/* Slot in the per-band hold buffer of an output row, or -1 if the row is
+   not read by any other band and can be written to the image directly */
+static int vng_held_slot(int row, int top, int bottom)
+{
+  if (row < top + 2)
+    return row - top;
+  if (row >= bottom - 2)
+    return 2 + row - (bottom - 2);
+  return -1;
+}
+
 /*
    This algorithm is officially called:
 
@@ -208,10 +222,10 @@ void LibRaw::vng_interpolate()
            +1, -1, +1,   +1, 0,  -120, +1, +0, +1,   +2, 0,  0x08, +1, +0, +2,
            -1, 0,  0x40, +1, +0, +2,   +1, 0,  0x10},
       chood[] = {-1, -1, -1, 0, -1, +1, 0, +1, +1, +1, +1, 0, +1, -1, 0, -1};
-  ushort(*brow[5])[4], *pix;
-  int prow = 8, pcol = 2, *ip, *code[16][16], gval[8], gmin, gmax, sum[4];
+  ushort(*brow[5])[4];
+  int prow = 8, pcol = 2, *ip, *code[16][16];
   int row, col, x, y, x1, x2, y1, y2, t, weight, grads, color, diag;
-  int g, diff, thold, num, c;
+  int g, band;
 
   lin_interpolate();
 
@@ -261,79 +275,151 @@ void LibRaw::vng_interpolate()
           *ip++ = 0;
       }
     }
-  brow[4] = (ushort(*)[4])calloc(width * 3, sizeof **brow);
-  for (row = 0; row < 3; row++)
-    brow[row] = brow[4] + row * width;
-  for (row = 2; row < height - 2; row++)
-  { /* Do VNG interpolation */
-    if (!((row - 2) % 256))
-      RUN_CALLBACK(LIBRAW_PROGRESS_INTERPOLATE, (row - 2) / 256 + 1,
-                   ((height - 3) / 256) + 1);
-    for (col = 2; col < width - 2; col++)
+  /* Every pixel reads the lin_interpolate() output up to two rows away, so
+     the rows are cut into bands that are interpolated independently. A band
+     writes each row back two rows later, once its own rows below no longer
+     need it. The first and last two rows of a band are still read by the
+     neighbouring bands and are held back until all bands are done. */
+  const int rows = MAX(height - 4, 0);
+#ifdef LIBRAW_USE_OPENMP
+  const int buffer_count = omp_get_max_threads();
+  const int band_rows =
+      MAX(16, (rows + buffer_count * 4 - 1) / (buffer_count * 4));
+#else
+  const int buffer_count = 1;
+  const int band_rows = MAX(rows, 1);
+#endif
+  const int band_count = (rows + band_rows - 1) / band_rows;
+  int terminate_flag = 0;
+
+  char **buffers =
+      malloc_omp_buffers(buffer_count, width * 3 * sizeof **brow);
+  ushort(*held)[4] =
+      (ushort(*)[4])calloc(MAX(band_count, 1) * 4 * width, sizeof *held);
+
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for schedule(dynamic) default(shared) private(brow, row, g)
+#endif
+  for (band = 0; band < band_count; band++)
+  {
+    int top = 2 + band * band_rows;
+    int bottom = MIN(top + band_rows, height - 2);
+
+#ifdef LIBRAW_USE_OPENMP
+    brow[4] = (ushort(*)[4])buffers[omp_get_thread_num()];
+#else
+    brow[4] = (ushort(*)[4])buffers[0];
+#endif
+    for (g = 0; g < 3; g++)
+      brow[g] = brow[4] + g * width;
+
+    /* Two extra iterations flush the last rows of the band */
+    for (row = top; row < bottom + 2 && !terminate_flag; row++)
     {
-      pix = image[row * width + col];
-      ip = code[row % prow][col % pcol];
-      memset(gval, 0, sizeof gval);
-      while ((g = ip[0]) != INT_MAX)
-      { /* Calculate gradients */
-        diff = ABS(pix[g] - pix[ip[1]]) << ip[2];
-        gval[ip[3]] += diff;
-        ip += 5;
-        if ((g = ip[-1]) == -1)
-          continue;
-        gval[g] += diff;
-        while ((g = *ip++) != -1)
-          gval[g] += diff;
-      }
-      ip++;
-      gmin = gmax = gval[0]; /* Choose a threshold */
-      for (g = 1; g < 8; g++)
+      if (row < bottom)
       {
-        if (gmin > gval[g])
-          gmin = gval[g];
-        if (gmax < gval[g])
-          gmax = gval[g];
+#ifdef LIBRAW_USE_OPENMP
+        if (0 == omp_get_thread_num())
+#endif
+          if (!((row - 2) % 256) && callbacks.progress_cb)
+          {
+            int rr = (*callbacks.progress_cb)(
+                callbacks.progresscb_data, LIBRAW_PROGRESS_INTERPOLATE,
+                (row - 2) / 256 + 1, ((height - 3) / 256) + 1);
+            if (rr)
+              terminate_flag = 1;
+          }
+        vng_interpolate_row(row, code, prow, pcol, brow[2]);
       }
-      if (gmax == 0)
+      if (row - 2 >= top) /* Write buffer to image */
       {
-        memcpy(brow[2][col], pix, sizeof *image);
-        continue;
-      }
-      thold = gmin + (gmax >> 1);
-      memset(sum, 0, sizeof sum);
-      color = fcol(row, col);
-      for (num = g = 0; g < 8; g++, ip += 2)
-      { /* Average the neighbors */
-        if (gval[g] <= thold)
-        {
-          FORCC
-          if (c == color && ip[1])
-            sum[c] += (pix[c] + pix[ip[1]]) >> 1;
-          else
-            sum[c] += pix[ip[0] + c];
-          num++;
-        }
-      }
-      FORCC
-      { /* Save to buffer */
-        t = pix[color];
-        if (c != color)
-          t += (sum[c] - sum[color]) / num;
-        brow[2][col][c] = CLIP(t);
+        int slot = vng_held_slot(row - 2, top, bottom);
+        ushort(*dest)[4] = slot < 0 ? image + (row - 2) * width
+                                    : held + (band * 4 + slot) * width;
+        memcpy(dest + 2, brow[0] + 2, (width - 4) * sizeof *image);
       }
+      for (g = 0; g < 4; g++)
+        brow[(g - 1) & 3] = brow[g];
     }
-    if (row > 3) /* Write buffer to image */
-      memcpy(image[(row - 2) * width + 2], brow[0] + 2,
-             (width - 4) * sizeof *image);
-    for (g = 0; g < 4; g++)
-      brow[(g - 1) & 3] = brow[g];
   }
-  memcpy(image[(row - 2) * width + 2], brow[0] + 2,
-         (width - 4) * sizeof *image);
-  memcpy(image[(row - 1) * width + 2], brow[1] + 2,
-         (width - 4) * sizeof *image);
-  free(brow[4]);
+
+  for (band = 0; band < band_count && !terminate_flag; band++)
+  {
+    int top = 2 + band * band_rows;
+    int bottom = MIN(top + band_rows, height - 2);
+    for (row = top; row < bottom; row++)
+      if ((g = vng_held_slot(row, top, bottom)) >= 0)
+        memcpy(image[row * width + 2], held[(band * 4 + g) * width + 2],
+               (width - 4) * sizeof *image);
+  }
+
+  free(held);
+  free_omp_buffers(buffers, buffer_count);
   free(code[0][0]);
+
+  if (terminate_flag)
+    throw LIBRAW_EXCEPTION_CANCELLED_BY_CALLBACK;
+}
+
+void LibRaw::vng_interpolate_row(int row, int *(*code)[16], int prow,
+                                 int pcol, ushort (*out)[4])
+{
+  int col, *ip, gval[8], gmin, gmax, sum[4], g, diff, thold, num, color, c, t;
+  ushort *pix;
+
+  for (col = 2; col < width - 2; col++)
+  {
+    pix = image[row * width + col];
+    ip = code[row % prow][col % pcol];
+    memset(gval, 0, sizeof gval);
+    while ((g = ip[0]) != INT_MAX)
+    { /* Calculate gradients */
+      diff = ABS(pix[g] - pix[ip[1]]) << ip[2];
+      gval[ip[3]] += diff;
+      ip += 5;
+      if ((g = ip[-1]) == -1)
+        continue;
+      gval[g] += diff;
+      while ((g = *ip++) != -1)
+        gval[g] += diff;
+    }
+    ip++;
+    gmin = gmax = gval[0]; /* Choose a threshold */
+    for (g = 1; g < 8; g++)
+    {
+      if (gmin > gval[g])
+        gmin = gval[g];
+      if (gmax < gval[g])
+        gmax = gval[g];
+    }
+    if (gmax == 0)
+    {
+      memcpy(out[col], pix, sizeof *image);
+      continue;
+    }
+    thold = gmin + (gmax >> 1);
+    memset(sum, 0, sizeof sum);
+    color = fcol(row, col);
+    for (num = g = 0; g < 8; g++, ip += 2)
+    { /* Average the neighbors */
+      if (gval[g] <= thold)
+      {
+        FORCC
+        if (c == color && ip[1])
+          sum[c] += (pix[c] + pix[ip[1]]) >> 1;
+        else
+          sum[c] += pix[ip[0] + c];
+        num++;
+      }
+    }
+    FORCC
+    { /* Save to buffer */
+      t = pix[color];
+      if (c != color)
+        t += (sum[c] - sum[color]) / num;
+      out[col][c] = CLIP(t);
+    }
+  }
 }
 
 /*
@@ -342,79 +428,108 @@ void LibRaw::vng_interpolate()
 void LibRaw::ppg_interpolate()
 {
   int dir[5] = {1, width, -1, -width, 1};
-  int row, col, diff[2], guess[2], c, d, i;
-  ushort(*pix)[4];
+  int row, band;
 
   border_interpolate(3);
 
-  /*  Fill in the green layer with gradients and pattern recognition: */
+  /* Red and blue only need the greens filled in one row away, so each band
+     of rows is interpolated completely while it is still in cache. The edge
+     rows of a band need greens from the neighbouring bands and are finished
+     once all bands are done. */
+  const int band_rows = 32;
+  const int band_count = (MAX(height - 2, 0) + band_rows - 1) / band_rows;
+
   RUN_CALLBACK(LIBRAW_PROGRESS_INTERPOLATE, 0, 3);
 #ifdef LIBRAW_USE_OPENMP
-#pragma omp parallel for default(shared) private(guess, diff, row, col, d, c,  \
-                                                 i, pix) schedule(static)
+#pragma omp parallel for default(shared) private(row) schedule(dynamic)
 #endif
-  for (row = 3; row < height - 3; row++)
-    for (col = 3 + (FC(row, 3) & 1), c = FC(row, col); col < width - 3;
-         col += 2)
-    {
-      pix = image + row * width + col;
-      for (i = 0; i < 2; i++)
-      {
-        d = dir[i];
-        guess[i] = (pix[-d][1] + pix[0][c] + pix[d][1]) * 2 - pix[-2 * d][c] -
-                   pix[2 * d][c];
-        diff[i] =
-            (ABS(pix[-2 * d][c] - pix[0][c]) + ABS(pix[2 * d][c] - pix[0][c]) +
-             ABS(pix[-d][1] - pix[d][1])) *
-                3 +
-            (ABS(pix[3 * d][1] - pix[d][1]) +
-             ABS(pix[-3 * d][1] - pix[-d][1])) *
-                2;
-      }
-      d = dir[i = diff[0] > diff[1]];
-      pix[0][1] = ULIM(guess[i] >> 2, pix[d][1], pix[-d][1]);
-    }
-  /*  Calculate red and blue for each green pixel:		*/
+  for (band = 0; band < band_count; band++)
+  {
+    int top = 1 + band * band_rows;
+    int bottom = MIN(top + band_rows, height - 1);
+    for (row = MAX(top, 3); row < MIN(bottom, height - 3); row++)
+      ppg_interpolate_green_row(row, dir);
+    for (row = top + 1; row < bottom - 1; row++)
+      ppg_interpolate_rb_row(row, dir);
+  }
+
   RUN_CALLBACK(LIBRAW_PROGRESS_INTERPOLATE, 1, 3);
 #ifdef LIBRAW_USE_OPENMP
-#pragma omp parallel for default(shared) private(guess, diff, row, col, d, c,  \
-                                                 i, pix) schedule(static)
+#pragma omp parallel for default(shared) schedule(static)
 #endif
-  for (row = 1; row < height - 1; row++)
-    for (col = 1 + (FC(row, 2) & 1), c = FC(row, col + 1); col < width - 1;
-         col += 2)
+  for (band = 0; band < band_count; band++)
+  {
+    int top = 1 + band * band_rows;
+    int bottom = MIN(top + band_rows, height - 1);
+    ppg_interpolate_rb_row(top, dir);
+    if (bottom - 1 > top)
+      ppg_interpolate_rb_row(bottom - 1, dir);
+  }
+  RUN_CALLBACK(LIBRAW_PROGRESS_INTERPOLATE, 2, 3);
+}
+
+/*  Fill in the green layer with gradients and pattern recognition: */
+void LibRaw::ppg_interpolate_green_row(int row, const int *dir)
+{
+  int col, diff[2], guess[2], c, d, i;
+  ushort(*pix)[4];
+
+  for (col = 3 + (FC(row, 3) & 1), c = FC(row, col); col < width - 3;
+       col += 2)
+  {
+    pix = image + row * width + col;
+    for (i = 0; i < 2; i++)
     {
-      pix = image + row * width + col;
-      for (i = 0; i < 2; c = 2 - c, i++)
-      {
-        d = dir[i];
-        pix[0][c] = CLIP(
-            (pix[-d][c] + pix[d][c] + 2 * pix[0][1] - pix[-d][1] - pix[d][1]) >>
-            1);
-      }
+      d = dir[i];
+      guess[i] = (pix[-d][1] + pix[0][c] + pix[d][1]) * 2 - pix[-2 * d][c] -
+                 pix[2 * d][c];
+      diff[i] =
+          (ABS(pix[-2 * d][c] - pix[0][c]) + ABS(pix[2 * d][c] - pix[0][c]) +
+           ABS(pix[-d][1] - pix[d][1])) *
+              3 +
+          (ABS(pix[3 * d][1] - pix[d][1]) +
+           ABS(pix[-3 * d][1] - pix[-d][1])) *
+              2;
     }
-  /*  Calculate blue for red pixels and vice versa:		*/
-  RUN_CALLBACK(LIBRAW_PROGRESS_INTERPOLATE, 2, 3);
-#ifdef LIBRAW_USE_OPENMP
-#pragma omp parallel for default(shared) private(guess, diff, row, col, d, c,  \
-                                                 i, pix) schedule(static)
-#endif
-  for (row = 1; row < height - 1; row++)
-    for (col = 1 + (FC(row, 1) & 1), c = 2 - FC(row, col); col < width - 1;
-         col += 2)
+    d = dir[i = diff[0] > diff[1]];
+    pix[0][1] = ULIM(guess[i] >> 2, pix[d][1], pix[-d][1]);
+  }
+}
+
+/*  Calculate red and blue for each green pixel, then blue for red pixels
+    and vice versa: */
+void LibRaw::ppg_interpolate_rb_row(int row, const int *dir)
+{
+  int col, diff[2], guess[2], c, d, i;
+  ushort(*pix)[4];
+
+  for (col = 1 + (FC(row, 2) & 1), c = FC(row, col + 1); col < width - 1;
+       col += 2)
+  {
+    pix = image + row * width + col;
+    for (i = 0; i < 2; c = 2 - c, i++)
     {
-      pix = image + row * width + col;
-      for (i = 0; i < 2; i++)
-      {
-        d = dir[i] + dir[i+1];
-        diff[i] = ABS(pix[-d][c] - pix[d][c]) + ABS(pix[-d][1] - pix[0][1]) +
-                  ABS(pix[d][1] - pix[0][1]);
-        guess[i] =
-            pix[-d][c] + pix[d][c] + 2 * pix[0][1] - pix[-d][1] - pix[d][1];
-      }
-      if (diff[0] != diff[1])
-        pix[0][c] = CLIP(guess[diff[0] > diff[1]] >> 1);
-      else
-        pix[0][c] = CLIP((guess[0] + guess[1]) >> 2);
+      d = dir[i];
+      pix[0][c] = CLIP(
+          (pix[-d][c] + pix[d][c] + 2 * pix[0][1] - pix[-d][1] - pix[d][1]) >>
+          1);
     }
+  }
+  for (col = 1 + (FC(row, 1) & 1), c = 2 - FC(row, col); col < width - 1;
+       col += 2)
+  {
+    pix = image + row * width + col;
+    for (i = 0; i < 2; i++)
+    {
+      d = dir[i] + dir[i+1];
+      diff[i] = ABS(pix[-d][c] - pix[d][c]) + ABS(pix[-d][1] - pix[0][1]) +
+                ABS(pix[d][1] - pix[0][1]);
+      guess[i] =
+          pix[-d][c] + pix[d][c] + 2 * pix[0][1] - pix[-d][1] - pix[d][1];
+    }
+    if (diff[0] != diff[1])
+      pix[0][c] = CLIP(guess[diff[0] > diff[1]] >> 1);
+    else
+      pix[0][c] = CLIP((guess[0] + guess[1]) >> 2);
+  }
 }
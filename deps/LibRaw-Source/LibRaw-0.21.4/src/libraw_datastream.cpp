@@ -27,6 +27,11 @@
 #include "libraw/libraw_types.h"
 #include "libraw/libraw_datastream.h"
 #include <sys/stat.h>
+#ifndef LIBRAW_WIN32_CALLS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #ifdef USE_JASPER
 #include <jasper/jasper.h> /* Decode RED camera movies */
 #else
@@ -152,6 +157,12 @@ int LibRaw_abstract_datastream::jpeg_src(void *jpegdata)
 #endif
 }
 
+int LibRaw_abstract_datastream::read_at(void *ptr, size_t size, INT64 offset)
+{
+  if (seek(offset, SEEK_SET))
+    return 0;
+  return read(ptr, 1, size);
+}
 
 #ifndef LIBRAW_NO_IOSTREAMS_DATASTREAM
 // == LibRaw_file_datastream ==
@@ -415,6 +426,17 @@ int LibRaw_buffer_datastream::seek(INT64 o, int whence)
   }
 }
 
+int LibRaw_buffer_datastream::read_at(void *ptr, size_t sz, INT64 offset)
+{
+  if (offset < 0 || size_t(offset) >= streamsize)
+    return 0;
+  size_t to_read = sz;
+  if (to_read > streamsize - size_t(offset))
+    to_read = streamsize - size_t(offset);
+  memmove(ptr, buf + offset, to_read);
+  return int(to_read);
+}
+
 INT64 LibRaw_buffer_datastream::tell()
 {
   return INT64(streampos);
@@ -653,6 +675,231 @@ void *LibRaw_bigfile_datastream::make_jas_stream()
 }
 #endif
 
+// == LibRaw_mmap_datastream
+#ifndef LIBRAW_WIN32_CALLS
+
+LibRaw_mmap_datastream::LibRaw_mmap_datastream(const char *fname)
+    : LibRaw_buffer_datastream(NULL, 0), filename(fname), map(NULL),
+      mapsize(0)
+{
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (!fstat(fd, &st) && st.st_size > 0)
+  {
+    void *p = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED)
+    {
+      map = p;
+      mapsize = size_t(st.st_size);
+      // most of a raw file is one forward pass over the raw data, so let
+      // the kernel read ahead aggressively
+      madvise(map, mapsize, MADV_SEQUENTIAL);
+      reconstruct_base();
+    }
+  }
+  close(fd); // the mapping keeps the file referenced
+}
+
+LibRaw_mmap_datastream::~LibRaw_mmap_datastream()
+{
+  if (map)
+    munmap(map, mapsize);
+}
+
+const char *LibRaw_mmap_datastream::fname()
+{
+  return filename.size() > 0 ? filename.c_str() : NULL;
+}
+
+#endif
+
+// == LibRaw_prefetch_datastream
+
+LibRaw_prefetch_datastream::LibRaw_prefetch_datastream(
+    LibRaw_abstract_datastream *src, size_t win, int nblocks)
+    : source(src), cur(NULL), window(win < 4096 ? 4096 : win),
+      _fsize(src ? src->size() : 0), _fpos(0), _bytes_read(0),
+      _source_reads(0), clock(0)
+{
+  blocks.resize(nblocks > 0 ? nblocks : 1);
+  for (size_t i = 0; i < blocks.size(); i++)
+  {
+    blocks[i].start = -1;
+    blocks[i].filled = 0;
+    blocks[i].age = 0;
+  }
+}
+
+LibRaw_prefetch_datastream::~LibRaw_prefetch_datastream() { delete source; }
+
+int LibRaw_prefetch_datastream::valid()
+{
+  return source ? source->valid() : 0;
+}
+
+#ifdef LIBRAW_OLD_VIDEO_SUPPORT
+void *LibRaw_prefetch_datastream::make_jas_stream()
+{
+  if (!source)
+    return NULL;
+  source->seek(_fpos, SEEK_SET);
+  return source->make_jas_stream();
+}
+#endif
+
+LibRaw_prefetch_datastream::block_t *
+LibRaw_prefetch_datastream::find_block(INT64 pos)
+{
+  for (size_t i = 0; i < blocks.size(); i++)
+    if (blocks[i].start >= 0 && pos >= blocks[i].start &&
+        pos < blocks[i].start + INT64(blocks[i].filled))
+      return &blocks[i];
+  return NULL;
+}
+
+const unsigned char *LibRaw_prefetch_datastream::block_at(INT64 pos,
+                                                          size_t &avail)
+{
+  if (!source || pos < 0 || pos >= _fsize)
+    return NULL;
+  block_t *b = find_block(pos);
+  if (!b)
+  {
+    // refill the least recently used block with the window holding pos
+    b = &blocks[0];
+    for (size_t i = 1; i < blocks.size(); i++)
+      if (blocks[i].age < b->age)
+        b = &blocks[i];
+    if (b->data.size() != window)
+      b->data.resize(window);
+    b->start = pos - pos % INT64(window);
+    b->filled = 0;
+    _source_reads++;
+    if (source->seek(b->start, SEEK_SET) == 0)
+    {
+      int got = source->read(b->data.data(), 1, window);
+      if (got > 0)
+        b->filled = size_t(got);
+    }
+    _bytes_read += INT64(b->filled);
+    if (pos >= b->start + INT64(b->filled))
+    {
+      b->start = -1;
+      b->filled = 0;
+      return NULL;
+    }
+  }
+  b->age = ++clock;
+  cur = b;
+  avail = size_t(b->start + INT64(b->filled) - pos);
+  return b->data.data() + size_t(pos - b->start);
+}
+
+int LibRaw_prefetch_datastream::read(void *ptr, size_t sz, size_t nmemb)
+{
+  if (!sz)
+    return 0;
+  unsigned char *dst = (unsigned char *)ptr;
+  size_t want = sz * nmemb, done = 0;
+  while (done < want && _fpos < _fsize)
+  {
+    if (want - done >= window && !find_block(_fpos))
+    {
+      // bulk (raw data) read: caching it would only evict the metadata
+      _source_reads++;
+      if (source->seek(_fpos, SEEK_SET))
+        break;
+      int got = source->read(dst + done, 1, want - done);
+      if (got <= 0)
+        break;
+      _bytes_read += got;
+      _fpos += got;
+      done += size_t(got);
+      break;
+    }
+    size_t avail;
+    const unsigned char *p = block_at(_fpos, avail);
+    if (!p)
+      break;
+    size_t n = avail < want - done ? avail : want - done;
+    memcpy(dst + done, p, n);
+    done += n;
+    _fpos += INT64(n);
+  }
+  return int(done / sz);
+}
+
+int LibRaw_prefetch_datastream::seek(INT64 o, int whence)
+{
+  INT64 npos;
+  switch (whence)
+  {
+  case SEEK_SET:
+    npos = o;
+    break;
+  case SEEK_CUR:
+    npos = _fpos + o;
+    break;
+  case SEEK_END:
+    npos = _fsize + o;
+    break;
+  default:
+    return -1;
+  }
+  if (npos < 0)
+    return -1;
+  _fpos = npos;
+  return 0;
+}
+
+char *LibRaw_prefetch_datastream::gets(char *s, int sz)
+{
+  if (sz < 1)
+    return NULL;
+  int i = 0;
+  while (i < sz - 1)
+  {
+    int c = get_char();
+    if (c < 0)
+      break;
+    s[i++] = char(c);
+    if (c == '\n')
+      break;
+  }
+  if (!i)
+    return NULL;
+  s[i] = 0;
+  return s;
+}
+
+int LibRaw_prefetch_datastream::scanf_one(const char *fmt, void *val)
+{
+  // numbers and short tokens only, as with the buffer datastream
+  char buf[33];
+  INT64 save = _fpos;
+  int got = read(buf, 1, sizeof(buf) - 1);
+  _fpos = save;
+  if (got <= 0)
+    return -1;
+  buf[got] = 0;
+  char fmtn[16];
+  if (strlen(fmt) > sizeof(fmtn) - 3)
+    return 0;
+  strcpy(fmtn, fmt);
+  strcat(fmtn, "%n");
+  int consumed = 0, scanf_res;
+#ifndef WIN32SECURECALLS
+  scanf_res = sscanf(buf, fmtn, val, &consumed);
+#else
+  scanf_res = sscanf_s(buf, fmtn, val, &consumed);
+#endif
+  if (scanf_res > 0)
+    _fpos += consumed;
+  return scanf_res;
+}
+
 // == LibRaw_windows_datastream
 #ifdef LIBRAW_WIN32_CALLS
 
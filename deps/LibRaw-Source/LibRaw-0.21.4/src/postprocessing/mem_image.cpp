@@ -165,15 +165,10 @@ void LibRaw::get_mem_image_format(int *width, int *height, int *colors,
   *bps = O.output_bps;
 }
 
-int LibRaw::copy_mem_image(void *scan0, int stride, int bgr)
-
+// Output gamma curve, with the white point from the histogram when
+// auto-brightness is on
+void LibRaw::mem_image_curve()
 {
-  // the image memory pointed to by scan0 is assumed to be in the format
-  // returned by get_mem_image_format
-  if ((imgdata.progress_flags & LIBRAW_PROGRESS_THUMB_MASK) <
-      LIBRAW_PROGRESS_PRE_INTERPOLATE)
-    return LIBRAW_OUT_OF_ORDER_CALL;
-
   if (libraw_internal_data.output_data.histogram)
   {
     int perc, val, total, t_white = 0x2000, c;
@@ -192,7 +187,25 @@ int LibRaw::copy_mem_image(void *scan0, int stride, int bgr)
       }
     gamma_curve(O.gamm[0], O.gamm[1], 2, (t_white << 3) / O.bright);
   }
+}
+
+// 8-bit output: the curve with the >> 8 folded in, which also halves the
+// table the per-sample lookups go through. NULL for 16-bit output (or if
+// the table can't be allocated); the caller frees it
+uchar *LibRaw::mem_image_curve8()
+{
+  uchar *curve8 = O.output_bps == 8 ? (uchar *)::malloc(0x10000) : 0;
+  if (curve8)
+    for (int i = 0; i < 0x10000; i++)
+      curve8[i] = imgdata.color.curve[i] >> 8;
+  return curve8;
+}
 
+// Writes output rows [first_row, first_row + nrows) to scan0, through the
+// curve set up by mem_image_curve() (curve8 from mem_image_curve8())
+void LibRaw::copy_mem_rows(void *scan0, int stride, int bgr, int first_row,
+                           int nrows, const uchar *curve8)
+{
   int s_iheight = S.iheight;
   int s_iwidth = S.iwidth;
   int s_width = S.width;
@@ -206,53 +219,124 @@ int LibRaw::copy_mem_image(void *scan0, int stride, int bgr)
   uchar *ppm;
   ushort *ppm2;
   int c, row, col, soff, rstep, cstep;
+  int last_row = MIN(first_row + nrows, int(S.height));
 
   soff = flip_index(0, 0);
   cstep = flip_index(0, 1) - soff;
-  rstep = flip_index(1, 0) - flip_index(0, S.width);
+  rstep = flip_index(1, 0) - soff;
 
-  for (row = 0; row < S.height; row++, soff += rstep)
+  const int first = bgr ? 2 : 0;
+
+  // every output row starts at its own flip_index(row, 0), so rows are
+  // independent
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp parallel for default(shared) private(ppm, ppm2, c, col)           \
+    schedule(static)
+#endif
+  for (row = first_row; row < last_row; row++)
   {
-    uchar *bufp = ((uchar *)scan0) + row * stride;
+    ushort(*pix)[4] = imgdata.image + soff + (INT64)row * rstep;
+    uchar *bufp = ((uchar *)scan0) + (INT64)(row - first_row) * stride;
     ppm2 = (ushort *)(ppm = bufp);
     // keep trivial decisions in the outer loop for speed
-    if (bgr)
+    if (curve8 && P1.colors == 3)
+    {
+      for (col = 0; col < S.width; col++, pix += cstep, ppm += 3)
+      {
+        ppm[first] = curve8[pix[0][0]];
+        ppm[1] = curve8[pix[0][1]];
+        ppm[2 - first] = curve8[pix[0][2]];
+      }
+    }
+    else if (bgr)
     {
       if (O.output_bps == 8)
       {
-        for (col = 0; col < S.width; col++, soff += cstep)
-          FORBGR *ppm++ = imgdata.color.curve[imgdata.image[soff][c]] >> 8;
+        for (col = 0; col < S.width; col++, pix += cstep)
+          FORBGR *ppm++ = imgdata.color.curve[pix[0][c]] >> 8;
       }
       else
       {
-        for (col = 0; col < S.width; col++, soff += cstep)
-          FORBGR *ppm2++ = imgdata.color.curve[imgdata.image[soff][c]];
+        for (col = 0; col < S.width; col++, pix += cstep)
+          FORBGR *ppm2++ = imgdata.color.curve[pix[0][c]];
       }
     }
     else
     {
       if (O.output_bps == 8)
       {
-        for (col = 0; col < S.width; col++, soff += cstep)
-          FORRGB *ppm++ = imgdata.color.curve[imgdata.image[soff][c]] >> 8;
+        for (col = 0; col < S.width; col++, pix += cstep)
+          FORRGB *ppm++ = imgdata.color.curve[pix[0][c]] >> 8;
       }
       else
       {
-        for (col = 0; col < S.width; col++, soff += cstep)
-          FORRGB *ppm2++ = imgdata.color.curve[imgdata.image[soff][c]];
+        for (col = 0; col < S.width; col++, pix += cstep)
+          FORRGB *ppm2++ = imgdata.color.curve[pix[0][c]];
       }
     }
-
-    //            bufp += stride;           // go to the next line
   }
 
   S.iheight = s_iheight;
   S.iwidth = s_iwidth;
   S.width = s_width;
   S.height = s_hwight;
+}
 
+int LibRaw::copy_mem_image(void *scan0, int stride, int bgr)
+
+{
+  // the image memory pointed to by scan0 is assumed to be in the format
+  // returned by get_mem_image_format
+  if ((imgdata.progress_flags & LIBRAW_PROGRESS_THUMB_MASK) <
+      LIBRAW_PROGRESS_PRE_INTERPOLATE)
+    return LIBRAW_OUT_OF_ORDER_CALL;
+
+  mem_image_curve();
+  uchar *curve8 = mem_image_curve8();
+  copy_mem_rows(scan0, stride, bgr, 0, (S.flip & 4) ? S.width : S.height,
+                curve8);
+  ::free(curve8);
   return 0;
 }
+
+// Same output as copy_mem_image(), handed to cb band_rows rows at a time
+// from a single band buffer, so callers can encode or write the image
+// without holding a second full-size copy of it
+int LibRaw::copy_mem_image_bands(int band_rows, int bgr,
+                                 mem_image_band_callback cb, void *data)
+{
+  if ((imgdata.progress_flags & LIBRAW_PROGRESS_THUMB_MASK) <
+      LIBRAW_PROGRESS_PRE_INTERPOLATE)
+    return LIBRAW_OUT_OF_ORDER_CALL;
+  if (!cb || band_rows < 1)
+    return LIBRAW_UNSPECIFIED_ERROR;
+
+  // rows as copy_mem_rows() lays them out
+  int width = (S.flip & 4) ? S.height : S.width;
+  int height = (S.flip & 4) ? S.width : S.height;
+  int stride = width * (O.output_bps / 8) * P1.colors;
+  band_rows = MIN(band_rows, height);
+  void *band = ::malloc((size_t)band_rows * stride);
+  if (!band)
+    return LIBRAW_UNSUFFICIENT_MEMORY;
+
+  mem_image_curve();
+  uchar *curve8 = mem_image_curve8(); // once per image, not per band
+  int ret = LIBRAW_SUCCESS;
+  for (int row = 0; row < height; row += band_rows)
+  {
+    int nrows = MIN(band_rows, height - row);
+    copy_mem_rows(band, stride, bgr, row, nrows, curve8);
+    if ((*cb)(data, band, row, nrows, stride))
+    {
+      ret = LIBRAW_CANCELLED_BY_CALLBACK;
+      break;
+    }
+  }
+  ::free(curve8);
+  ::free(band);
+  return ret;
+}
 #undef FORBGR
 #undef FORRGB
 
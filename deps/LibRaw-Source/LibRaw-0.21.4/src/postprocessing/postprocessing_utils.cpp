@@ -12,10 +12,190 @@
 
  */
 
+/* System headers go first: the LibRaw defines below clash with them */
+#if defined(__x86_64__) || defined(_M_X64)
+#define LIBRAW_SIMD_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define LIBRAW_AVX2_TARGET
+#else
+#define LIBRAW_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define LIBRAW_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 #include "../../internal/libraw_cxx_defs.h"
 
 #define TBLN 65535
 
+/*
+   Vector kernels for convert_to_rgb_loop() and scale_colors_loop(). They
+   perform the same float operations as the scalar loops, in the same order
+   and without fused multiply-add, then truncate to int and clamp to
+   0..65535, so the output is bit-identical. AVX2 is detected at run time;
+   NEON is always available on 64-bit ARM. LIBRAW_RAWOPTIONS_NO_SIMD_KERNELS
+   selects the scalar loops, so that both can be compared.
+*/
+#if defined(LIBRAW_SIMD_AVX2)
+
+static int cpu_has_avx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return 0;
+  __cpuid(info, 1);
+  /* OSXSAVE and YMM state enabled by the OS */
+  if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6)
+    return 0;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+int LibRaw::simd_kernels_available()
+{
+  static const int avx2 = cpu_has_avx2();
+  return avx2;
+}
+
+/* Two pixels: each 128-bit lane holds one pixel, output channel per float */
+LIBRAW_AVX2_TARGET static inline __m128i convert_to_rgb_avx2_pair(
+    __m128i raw, const __m256 *m, int colors)
+{
+  __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(raw));
+  __m256 out = _mm256_add_ps(_mm256_mul_ps(m[0], _mm256_permute_ps(v, 0x00)),
+                             _mm256_mul_ps(m[1], _mm256_permute_ps(v, 0x55)));
+  out = _mm256_add_ps(out, _mm256_mul_ps(m[2], _mm256_permute_ps(v, 0xAA)));
+  if (colors == 4)
+    out = _mm256_add_ps(out, _mm256_mul_ps(m[3], _mm256_permute_ps(v, 0xFF)));
+  __m256i q = _mm256_cvttps_epi32(out);
+  __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(q),
+                                    _mm256_extracti128_si256(q, 1));
+  return _mm_blend_epi16(packed, raw, 0x88); /* channel 3 is not converted */
+}
+
+LIBRAW_AVX2_TARGET static void convert_to_rgb_simd(ushort (*img)[4], int count,
+                                                   float out_cam[3][4],
+                                                   int colors)
+{
+  __m256 m[4];
+  for (int k = 0; k < 4; k++)
+    m[k] = _mm256_setr_ps(out_cam[0][k], out_cam[1][k], out_cam[2][k], 0.f,
+                          out_cam[0][k], out_cam[1][k], out_cam[2][k], 0.f);
+  int i = 0;
+  for (; i + 2 <= count; i += 2)
+    _mm_storeu_si128(
+        (__m128i *)img[i],
+        convert_to_rgb_avx2_pair(_mm_loadu_si128((const __m128i *)img[i]), m,
+                                 colors));
+  if (i < count)
+    _mm_storel_epi64(
+        (__m128i *)img[i],
+        convert_to_rgb_avx2_pair(_mm_loadl_epi64((const __m128i *)img[i]), m,
+                                 colors));
+}
+
+/* Four pixels; zero samples stay zero, as in the scalar loops */
+LIBRAW_AVX2_TARGET static inline __m256i scale_colors_avx2_quad(
+    __m256i raw, __m256 mul, __m256i black)
+{
+  __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(raw));
+  __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(raw, 1));
+  lo = _mm256_cvttps_epi32(
+      _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(lo, black)), mul));
+  hi = _mm256_cvttps_epi32(
+      _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(hi, black)), mul));
+  /* packus works per 128-bit lane; restore the pixel order afterwards */
+  __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+  __m256i zero = _mm256_cmpeq_epi16(raw, _mm256_setzero_si256());
+  return _mm256_andnot_si256(zero, packed);
+}
+
+LIBRAW_AVX2_TARGET static void scale_colors_simd(ushort (*img)[4],
+                                                 unsigned count,
+                                                 const float scale_mul[4],
+                                                 const int black[4])
+{
+  __m256 mul = _mm256_setr_ps(scale_mul[0], scale_mul[1], scale_mul[2],
+                              scale_mul[3], scale_mul[0], scale_mul[1],
+                              scale_mul[2], scale_mul[3]);
+  __m256i blk = _mm256_setr_epi32(black[0], black[1], black[2], black[3],
+                                  black[0], black[1], black[2], black[3]);
+  unsigned i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm256_storeu_si256(
+        (__m256i *)img[i],
+        scale_colors_avx2_quad(_mm256_loadu_si256((const __m256i *)img[i]),
+                               mul, blk));
+  if (i < count)
+  {
+    ushort tail[4][4] = {{0}};
+    memmove(tail, img[i], (count - i) * sizeof *img);
+    _mm256_storeu_si256(
+        (__m256i *)tail,
+        scale_colors_avx2_quad(_mm256_loadu_si256((const __m256i *)tail), mul,
+                               blk));
+    memmove(img[i], tail, (count - i) * sizeof *img);
+  }
+}
+
+#elif defined(LIBRAW_SIMD_NEON)
+
+int LibRaw::simd_kernels_available() { return 1; }
+
+static void convert_to_rgb_simd(ushort (*img)[4], int count,
+                                float out_cam[3][4], int colors)
+{
+  float32x4_t m[4];
+  for (int k = 0; k < 4; k++)
+  {
+    float column[4] = {out_cam[0][k], out_cam[1][k], out_cam[2][k], 0.f};
+    m[k] = vld1q_f32(column);
+  }
+  for (int i = 0; i < count; i++)
+  {
+    uint16x4_t raw = vld1_u16(img[i]);
+    float32x4_t v = vcvtq_f32_u32(vmovl_u16(raw));
+    float32x4_t out = vaddq_f32(vmulq_n_f32(m[0], vgetq_lane_f32(v, 0)),
+                                vmulq_n_f32(m[1], vgetq_lane_f32(v, 1)));
+    out = vaddq_f32(out, vmulq_n_f32(m[2], vgetq_lane_f32(v, 2)));
+    if (colors == 4)
+      out = vaddq_f32(out, vmulq_n_f32(m[3], vgetq_lane_f32(v, 3)));
+    uint16x4_t res = vqmovun_s32(vcvtq_s32_f32(out));
+    vst1_u16(img[i], vset_lane_u16(vget_lane_u16(raw, 3), res, 3));
+  }
+}
+
+static void scale_colors_simd(ushort (*img)[4], unsigned count,
+                              const float scale_mul[4], const int black[4])
+{
+  float32x4_t mul = vld1q_f32(scale_mul);
+  int32x4_t blk = vld1q_s32(black);
+  for (unsigned i = 0; i < count; i++)
+  {
+    uint16x4_t raw = vld1_u16(img[i]);
+    int32x4_t val =
+        vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(raw)), blk);
+    uint16x4_t res =
+        vqmovun_s32(vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(val), mul)));
+    vst1_u16(img[i], vbic_u16(res, vceq_u16(raw, vdup_n_u16(0))));
+  }
+}
+
+#else
+
+int LibRaw::simd_kernels_available() { return 0; }
+
+#endif
+
 void LibRaw::exp_bef(float shift, float smooth)
 {
   // params limits
@@ -96,6 +276,25 @@ void LibRaw::convert_to_rgb_loop(float out_cam[3][4])
       }
     }
   }
+#if defined(LIBRAW_SIMD_AVX2) || defined(LIBRAW_SIMD_NEON)
+  else if ((imgdata.idata.colors == 3 || imgdata.idata.colors == 4) &&
+           !(imgdata.rawparams.options & LIBRAW_RAWOPTIONS_NO_SIMD_KERNELS) &&
+           simd_kernels_available())
+  {
+    for (img = imgdata.image[0], row = 0; row < S.height; row++)
+    {
+      convert_to_rgb_simd((ushort(*)[4])img, S.width, out_cam,
+                          imgdata.idata.colors);
+      for (col = 0; col < S.width; col++, img += 4)
+      {
+        for (c = 0; c < imgdata.idata.colors; c++)
+        {
+          libraw_internal_data.output_data.histogram[c][img[c] >> 3]++;
+        }
+      }
+    }
+  }
+#endif
   else if (imgdata.idata.colors == 3)
   {
     for (img = imgdata.image[0], row = 0; row < S.height; row++)
@@ -161,6 +360,17 @@ void LibRaw::scale_colors_loop(float scale_mul[4])
       }
     }
   }
+#if defined(LIBRAW_SIMD_AVX2) || defined(LIBRAW_SIMD_NEON)
+  else if (!(imgdata.rawparams.options & LIBRAW_RAWOPTIONS_NO_SIMD_KERNELS) &&
+           simd_kernels_available())
+  {
+    /* With zero black levels this also matches the last branch below */
+    int black[4];
+    for (unsigned c = 0; c < 4; c++)
+      black[c] = C.cblack[c];
+    scale_colors_simd(imgdata.image, size, scale_mul, black);
+  }
+#endif
   else if (C.cblack[0] || C.cblack[1] || C.cblack[2] || C.cblack[3])
   {
     for (unsigned i = 0; i < size; i++)
@@ -298,6 +298,95 @@ void LibRaw::copy_bayer(unsigned short cblack[4], unsigned short *dmaxp)
   }
 }
 
+/* Per-color maxima of the whole visible frame, for cropped processing.
+ * adjust_maximum() derives the white point from C.data_maximum, so a crop
+ * must not see only its own maximum or every region of the same image would
+ * be scaled differently. filt is the pattern of the uncropped frame. */
+void LibRaw::frame_channel_maximum(unsigned filt)
+{
+  const libraw_image_sizes_t &F = imgdata.rawdata.sizes;
+  int maxHeight = MIN(int(F.height), int(F.raw_height) - int(F.top_margin));
+  int maxWidth = MIN(int(F.width), int(F.raw_width) - int(F.left_margin));
+  const unsigned short *raw =
+      imgdata.rawdata.raw_image + F.top_margin * (F.raw_pitch / 2) + F.left_margin;
+  int pitch = F.raw_pitch / 2;
+  ushort *chmax = libraw_internal_data.internal_data.frame_maximum;
+  chmax[0] = chmax[1] = chmax[2] = chmax[3] = 0;
+#if defined(LIBRAW_USE_OPENMP)
+#pragma omp parallel for schedule(dynamic) default(none) shared(chmax) firstprivate(filt, maxHeight, maxWidth, raw, pitch)
+#endif
+  for (int row = 0; row < maxHeight; row++)
+  {
+    const unsigned short *src = raw + size_t(row) * pitch;
+    // Two colors per row: even and odd columns
+    unsigned short lmax[2] = {0, 0};
+    for (int col = 0; col < maxWidth; col++)
+      if (src[col] > lmax[col & 1])
+        lmax[col & 1] = src[col];
+#if defined(LIBRAW_USE_OPENMP)
+#pragma omp critical(dataupdate)
+#endif
+    {
+      for (int c = 0; c < 2; c++)
+      {
+        int cc = filt >> ((((row << 1) & 14) | c) << 1) & 3;
+        if (chmax[cc] < lmax[c])
+          chmax[cc] = lmax[c];
+      }
+    }
+  }
+}
+
+/* Black-subtracted data maximum of the uncropped frame as recorded by
+ * frame_channel_maximum(), or 0 when the image was not cropped */
+int LibRaw::frame_data_maximum(const int cblack[4])
+{
+  int dmax = 0;
+  for (int c = 0; c < 4; c++)
+    dmax = MAX(dmax, int(libraw_internal_data.internal_data.frame_maximum[c]) - cblack[c]);
+  return dmax;
+}
+
+/* Averages factor x factor blocks of the half_size image (each pixel already
+ * holds one 2x2 CFA block), for previews far below half resolution. The
+ * blocks are written in place: block (r,c) never lands after any pixel it
+ * still has to read. S.height/S.width become twice the binned size, so
+ * the code mapping sensor coordinates through shrink stays in range */
+void LibRaw::bin_half_size(int factor)
+{
+  int ih = S.iheight, iw = S.iwidth;
+  int bh = (ih + factor - 1) / factor, bw = (iw + factor - 1) / factor;
+  for (int brow = 0; brow < bh; brow++)
+  {
+    int r0 = brow * factor, r1 = MIN(r0 + factor, ih);
+    for (int bcol = 0; bcol < bw; bcol++)
+    {
+      int c0 = bcol * factor, c1 = MIN(c0 + factor, iw);
+      unsigned sum[4] = {0, 0, 0, 0};
+      for (int r = r0; r < r1; r++)
+      {
+        ushort(*pix)[4] = imgdata.image + r * iw + c0;
+        for (int c = c0; c < c1; c++, pix++)
+        {
+          sum[0] += pix[0][0];
+          sum[1] += pix[0][1];
+          sum[2] += pix[0][2];
+          sum[3] += pix[0][3];
+        }
+      }
+      unsigned n = unsigned((r1 - r0) * (c1 - c0));
+      for (int k = 0; k < 4; k++)
+        imgdata.image[brow * bw + bcol][k] = ushort((sum[k] + n / 2) / n);
+    }
+  }
+  S.iheight = bh;
+  S.iwidth = bw;
+  S.height = bh << IO.shrink;
+  S.width = bw << IO.shrink;
+  imgdata.image =
+      (ushort(*)[4])realloc(imgdata.image, bh * bw * sizeof(*imgdata.image));
+}
+
 int LibRaw::raw2image_ex(int do_subtract_black)
 {
 
@@ -324,6 +413,8 @@ int LibRaw::raw2image_ex(int do_subtract_black)
 
     // process cropping
     int do_crop = 0;
+    unsigned frame_filters = imgdata.idata.filters;
+    ZERO(libraw_internal_data.internal_data.frame_maximum);
     if (~O.cropbox[2] && ~O.cropbox[3])
     {
       int crop[4], c, filt;
@@ -482,6 +573,15 @@ int LibRaw::raw2image_ex(int do_subtract_black)
       else
       {
         copy_bayer(cblack, &dmax);
+        if (do_crop && frame_filters >= 1000)
+        {
+          frame_channel_maximum(frame_filters);
+          if (do_subtract_black)
+          {
+            int bl[4] = {cblack[0], cblack[1], cblack[2], cblack[3]};
+            dmax = frame_data_maximum(bl);
+          }
+        }
       }
     }
     else // if(decoder_info.decoder_flags & LIBRAW_DECODER_LEGACY)
@@ -546,6 +646,10 @@ int LibRaw::raw2image_ex(int do_subtract_black)
       C.black = 0;
     }
 
+    if (O.half_size_bin > 1 && IO.shrink && P1.filters > 1000 &&
+        !IO.fuji_width && imgdata.rawdata.raw_image)
+      bin_half_size(MIN(O.half_size_bin, 64));
+
     // hack - clear later flags!
     imgdata.progress_flags =
         LIBRAW_PROGRESS_START | LIBRAW_PROGRESS_OPEN |
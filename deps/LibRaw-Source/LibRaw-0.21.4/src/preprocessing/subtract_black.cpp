@@ -65,6 +65,8 @@ int LibRaw::subtract_black_internal()
           }
         }
       }
+      // A cropped image keeps the white point of the whole frame
+      dmax = MAX(dmax, frame_data_maximum(cblk));
       C.data_maximum = dmax & 0xffff;
       C.maximum -= C.black;
       ZERO(C.cblack); // Yeah, we used cblack[6+] values too!
@@ -80,7 +82,8 @@ int LibRaw::subtract_black_internal()
       for (idx = 0; idx < S.iheight * S.iwidth * 4; idx++)
         if (dmax < p[idx])
           dmax = p[idx];
-      C.data_maximum = dmax;
+      const int noblack[4] = {0, 0, 0, 0};
+      C.data_maximum = MAX(dmax, frame_data_maximum(noblack));
     }
     return 0;
   }
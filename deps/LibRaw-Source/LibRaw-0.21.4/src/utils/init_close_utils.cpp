@@ -86,6 +86,7 @@ LibRaw::LibRaw(unsigned int flags) : memmgr(1024)
   imgdata.rawparams.use_dngsdk = LIBRAW_DNG_DEFAULT;
   imgdata.params.no_auto_scale = 0;
   imgdata.params.no_interpolation = 0;
+  imgdata.params.half_size_bin = 0;
   imgdata.rawparams.specials = 0; /* was inverted : LIBRAW_PROCESSING_DP2Q_INTERPOLATERG |      LIBRAW_PROCESSING_DP2Q_INTERPOLATEAF; */
   imgdata.rawparams.options = LIBRAW_RAWOPTIONS_CONVERTFLOAT_TO_INT;
   imgdata.rawparams.sony_arw2_posterization_thr = 0;
@@ -212,6 +212,46 @@ int LibRaw::open_file(const wchar_t *fname)
 
 #endif
 
+int LibRaw::open_mmap(const char *fname)
+{
+#ifdef LIBRAW_WIN32_CALLS
+  return open_file(fname);
+#else
+  LibRaw_mmap_datastream *stream;
+  try
+  {
+    stream = new LibRaw_mmap_datastream(fname);
+  }
+  catch (const std::bad_alloc& )
+  {
+    recycle();
+    return LIBRAW_UNSUFFICIENT_MEMORY;
+  }
+  if (!stream->valid())
+  {
+    delete stream;
+    return LIBRAW_IO_ERROR;
+  }
+  if ((stream->size() > (INT64)LIBRAW_MAX_NONDNG_RAW_FILE_SIZE) && (stream->size() > (INT64)LIBRAW_MAX_DNG_RAW_FILE_SIZE))
+  {
+    delete stream;
+    return LIBRAW_TOO_BIG;
+  }
+  ID.input_internal = 0; // preserve from deletion on error
+  int ret = open_datastream(stream);
+  if (ret == LIBRAW_SUCCESS)
+  {
+    ID.input_internal = 1; // flag to delete datastream on recycle
+  }
+  else
+  {
+    delete stream;
+    ID.input_internal = 0;
+  }
+  return ret;
+#endif
+}
+
 int LibRaw::open_buffer(const void *buffer, size_t size)
 {
   // this stream will close on recycle()
@@ -186,6 +186,40 @@ void LibRaw::derror()
   libraw_internal_data.unpacker_data.data_error++;
 }
 
+/*
+   derror() for data read through a bit reader, also called from parallel
+   tile decoders. End of file is judged at the position the reader has
+   consumed up to, not at its read-ahead, and only the first error on this
+   reader (per DNG tile) may turn into LIBRAW_EXCEPTION_IO_EOF.
+ */
+void LibRaw::derror(libraw_getbits_t *gb)
+{
+  LibRaw_abstract_datastream *in =
+      gb->input ? gb->input : libraw_internal_data.internal_data.input;
+  int at_eof = 0;
+  if (!in)
+  {
+    derror();
+    return;
+  }
+  INT64 pos = getbits_tell(gb);
+  if (!gb->errors++)
+    at_eof = pos >= in->size();
+#ifdef LIBRAW_USE_OPENMP
+#pragma omp critical(libraw_derror)
+#endif
+  {
+    if (!libraw_internal_data.unpacker_data.data_error && callbacks.data_cb)
+      (*callbacks.data_cb)(callbacks.datacb_data,
+                           libraw_internal_data.internal_data.input->fname(),
+                           at_eof ? -1 : int(pos));
+    if (!at_eof)
+      libraw_internal_data.unpacker_data.data_error++;
+  }
+  if (at_eof)
+    throw LIBRAW_EXCEPTION_IO_EOF;
+}
+
 const char *LibRaw::version() { return LIBRAW_VERSION_STR; }
 int LibRaw::versionNumber() { return LIBRAW_VERSION; }
 const char *LibRaw::strerror(int p) { return libraw_strerror(p); }
@@ -223,6 +257,8 @@ unsigned LibRaw::capabilities()
 #ifdef USE_JPEG
   ret |= LIBRAW_CAPS_JPEG;
 #endif
+  if (simd_kernels_available())
+    ret |= LIBRAW_CAPS_SIMD_KERNELS;
   return ret;
 }
 
@@ -138,6 +138,85 @@ declare module 'libraw' {
     highlight?: number;
     /** Output TIFF format instead of PPM */
     output_tiff?: boolean;
+    /** Half-size output: one pixel per 2x2 CFA block, no demosaicing */
+    half_size?: boolean;
+    /** With half_size: also average NxN half-size pixels (Bayer sensors, 0 = off) */
+    half_size_bin?: number;
+    /** false: scalar colour conversion and scaling instead of the AVX2/NEON kernels */
+    simd_kernels?: boolean;
+  }
+
+  export interface LibRawPreviewOptions {
+    /** Smallest acceptable longer edge in pixels (default 1024) */
+    maxEdge?: number;
+  }
+
+  export interface LibRawImageStreamOptions {
+    /** Output rows per chunk (default 64) */
+    bandRows?: number;
+  }
+
+  export interface LibRawImageStreamInfo {
+    width: number;
+    height: number;
+    colors: number;
+    bits: number;
+  }
+
+  export interface LibRawRegionOptions {
+    /** Extra sensor pixels processed around the region for the demosaic (default 32) */
+    halo?: number;
+  }
+
+  export interface LibRawLoadOptions {
+    /** Read the file through a read-only memory mapping (default false) */
+    mmap?: boolean;
+    /**
+     * Unpack the raw data while loading (default true). With false only
+     * metadata and thumbnails are read; pixel operations unpack on demand.
+     */
+    unpack?: boolean;
+    /**
+     * Coalesce the metadata reads into window-aligned reads of the file:
+     * true for 64 KiB windows, or a window size in bytes (files only)
+     */
+    prefetch?: boolean | number;
+  }
+
+  export interface LibRawStreamSource {
+    /** File size in bytes */
+    size: number;
+    /** Returns up to `length` bytes at `offset` */
+    read(
+      offset: number,
+      length: number
+    ):
+      | Buffer
+      | Uint8Array
+      | ArrayBuffer
+      | Promise<Buffer | Uint8Array | ArrayBuffer>;
+  }
+
+  export interface LibRawStreamOptions extends LibRawLoadOptions {
+    /** Bytes per cached block (default 262144) */
+    blockSize?: number;
+    /** Number of cached blocks (default 16) */
+    cacheBlocks?: number;
+  }
+
+  export interface LibRawReadStats {
+    /** Bytes read from the file so far */
+    bytesRead: number;
+    /** Read requests issued to the file */
+    reads: number;
+    fileSize: number;
+  }
+
+  export interface LibRawExtractThumbnailOptions {
+    /** Position in the file's thumbnail list; overrides maxSize */
+    index?: number;
+    /** Largest thumbnail whose longer edge is at most maxSize (smallest if none fits) */
+    maxSize?: number;
   }
 
   export interface LibRawImageData {
@@ -182,6 +261,11 @@ declare module 'libraw' {
     colorSpace?: 'srgb' | 'rec2020' | 'p3' | 'cmyk';
     /** Enable fast mode for better performance */
     fastMode?: boolean;
+    /**
+     * Use the addon's libjpeg encoder when available and the options need no
+     * resizing or colour conversion (default true)
+     */
+    nativeEncoder?: boolean;
     /** Encoding effort (1=fastest, 9=slowest) */
     effort?: number;
     /** Maximum concurrency for batch operations */
@@ -372,6 +456,79 @@ declare module 'libraw' {
     };
   }
 
+  export interface LibRawBatchProcessorOptions {
+    /** Number of decode threads (default: hardware concurrency) */
+    threads?: number;
+    /** OpenMP threads per decode (default: cores divided by threads) */
+    threadsPerFile?: number;
+    /** Output parameters applied to every processor in the pool */
+    params?: LibRawOutputParams;
+  }
+
+  export interface LibRawBatchFileResult {
+    /** Index of the file in the array passed to run() */
+    index: number;
+    /** Input file path */
+    file: string;
+    success: boolean;
+    /** Decoded image, present when success is true */
+    image?: LibRawImageData;
+    /** Error message, present when success is false */
+    error?: string;
+    /** Native decode time in milliseconds */
+    timeMs: number;
+  }
+
+  export interface LibRawBatchSummary {
+    total: number;
+    succeeded: number;
+    failed: number;
+    /** Files never started because the batch was cancelled */
+    skipped: number;
+    cancelled: boolean;
+    threads: number;
+    totalTimeMs: number;
+  }
+
+  export interface LibRawPoolOptions {
+    /** Maximum number of idle processors kept for reuse */
+    maxIdle?: number;
+    /** Number of processors to construct up front */
+    prewarm?: number;
+  }
+
+  export interface LibRawPoolStats {
+    idle: number;
+    maxIdle: number;
+    created: number;
+    reused: number;
+    discarded: number;
+  }
+
+  export class BatchProcessor {
+    constructor(options?: LibRawBatchProcessorOptions);
+
+    /**
+     * Decode files on the native worker pool, calling onResult for every file
+     * as soon as it finishes (in completion order). A worker waits for the
+     * Promise onResult returns before decoding on; a throw or rejection
+     * cancels the run and rejects it
+     */
+    run(
+      files: string[],
+      onResult: (result: LibRawBatchFileResult) => void | Promise<unknown>
+    ): Promise<LibRawBatchSummary>;
+
+    /**
+     * Stop the current run; files already being decoded are aborted
+     */
+    cancel(): boolean;
+
+    isRunning(): boolean;
+
+    getThreadCount(): number;
+  }
+
   export class LibRaw {
     constructor();
 
@@ -379,20 +536,40 @@ declare module 'libraw' {
     /**
      * Load RAW image from file
      * @param filename Path to RAW image file
+     * @param options Load options
      */
-    loadFile(filename: string): Promise<boolean>;
+    loadFile(filename: string, options?: LibRawLoadOptions): Promise<boolean>;
 
     /**
-     * Load RAW image from buffer
+     * Load RAW image from buffer. The memory is used in place (not copied)
+     * and stays referenced until the next load or close().
      * @param buffer Binary data buffer containing RAW image
      */
-    loadBuffer(buffer: Buffer): Promise<boolean>;
+    loadBuffer(
+      buffer: Buffer | Uint8Array | ArrayBuffer,
+      options?: LibRawLoadOptions
+    ): Promise<boolean>;
+
+    /**
+     * Load RAW image through a range reader with a native block cache.
+     * The source is used until the next load or close(); with unpack: false
+     * unpack through an async pixel operation before the synchronous ones.
+     */
+    loadStream(
+      source: LibRawStreamSource,
+      options?: LibRawStreamOptions
+    ): Promise<boolean>;
 
     /**
      * Close current image and free resources
      */
     close(): Promise<boolean>;
 
+    /**
+     * File I/O so far for images loaded with prefetch or loadStream() (null otherwise)
+     */
+    getReadStats(): Promise<LibRawReadStats | null>;
+
     // ============== METADATA & INFORMATION ==============
     /**
      * Get basic image metadata and EXIF information
@@ -430,6 +607,24 @@ declare module 'libraw' {
      */
     processImage(): Promise<boolean>;
 
+    /**
+     * Process a reduced-resolution preview (half size / binned, no
+     * demosaicing where possible) and return it as a memory image
+     */
+    processPreview(options?: LibRawPreviewOptions): Promise<LibRawImageData>;
+
+    /**
+     * Process only a rectangle (in full-size output coordinates) of the image
+     * and return it as a memory image
+     */
+    processRegion(
+      x: number,
+      y: number,
+      width: number,
+      height: number,
+      options?: LibRawRegionOptions
+    ): Promise<LibRawImageData>;
+
     /**
      * Subtract black level from image data
      */
@@ -451,6 +646,14 @@ declare module 'libraw' {
      */
     createMemoryImage(): Promise<LibRawImageData>;
 
+    /**
+     * Stream the processed image as bands of interleaved rows; emits 'info'
+     * before the first chunk
+     */
+    createImageStream(
+      options?: LibRawImageStreamOptions
+    ): import('stream').Readable & { info?: LibRawImageStreamInfo };
+
     /**
      * Create thumbnail image in memory
      */
@@ -487,6 +690,14 @@ declare module 'libraw' {
      */
     getOutputParams(): Promise<LibRawOutputParams>;
 
+    /**
+     * Bound the OpenMP team used by this instance's decode operations
+     * (OpenMP builds only; 0 restores the default)
+     * @param threads Maximum threads per operation
+     * @returns Effective team size (always 1 without OpenMP)
+     */
+    setThreads(threads: number): number;
+
     // ============== UTILITY FUNCTIONS ==============
     /**
      * Check if image uses floating point values
@@ -621,6 +832,11 @@ declare module 'libraw' {
      */
     static getVersion(): string;
 
+    /**
+     * Whether the addon was built with the native libjpeg encoder
+     */
+    static hasNativeJPEG(): boolean;
+
     /**
      * Get LibRaw library capabilities bitmask
      */
@@ -635,6 +851,53 @@ declare module 'libraw' {
      * Get count of supported camera models
      */
     static getCameraCount(): number;
+
+    /**
+     * Configure the shared pool of native LibRaw processors
+     */
+    static configurePool(options: LibRawPoolOptions): LibRawPoolStats;
+
+    /**
+     * Get statistics of the shared processor pool
+     */
+    static getPoolStats(): LibRawPoolStats;
+
+    /**
+     * Extract an embedded thumbnail on the thread pool without decoding the
+     * RAW data; only the metadata and the thumbnail bytes are read
+     * @param source File path or RAW file contents
+     */
+    static extractThumbnail(
+      source: string | Buffer | Uint8Array | ArrayBuffer,
+      options?: LibRawExtractThumbnailOptions
+    ): Promise<LibRawImageData & { index?: number }>;
+
+    /**
+     * Convert many RAW files to JPEG, decoding on a native worker pool
+     */
+    static batchConvertToJPEGParallel(inputPaths: string[], outputDir: string, options?: LibRawJPEGOptions & {
+      maxConcurrency?: number;
+    }): Promise<{
+      totalFiles: number;
+      successCount: number;
+      errorCount: number;
+      results: Array<{
+        inputPath: string;
+        outputPath?: string;
+        success: boolean;
+        fileSize?: number;
+        processingTime?: string;
+        error?: string;
+      }>;
+      errors: Array<{ inputPath: string; error: string }>;
+      totalProcessingTime: number;
+      averageTimePerFile: number;
+    }>;
+
+    /**
+     * Native work-stealing batch decoder
+     */
+    static BatchProcessor: typeof BatchProcessor;
   }
 
   export = LibRaw;
@@ -1,4 +1,5 @@
 const path = require("path");
+const { Readable } = require("stream");
 const sharp = require("sharp");
 
 let librawAddon;
@@ -12,6 +13,202 @@ try {
   }
 }
 
+/**
+ * Encode a LibRaw memory image ({ width, height, colors, bits, data }) as JPEG.
+ * Shared by createJPEGBuffer and the native batch pipeline.
+ * @param {Object} imageData - Image returned by createMemoryImage
+ * @param {Object} options - JPEG options (see LibRaw#createJPEGBuffer)
+ * @param {bigint} [startTime] - hrtime the processing time is measured from
+ * @returns {Promise<Object>} - JPEG buffer with metadata
+ */
+async function encodeJPEGBuffer(
+  imageData,
+  options = {},
+  startTime = process.hrtime.bigint()
+) {
+  // Set default options with performance-optimized values
+  const opts = {
+    quality: options.quality || 85,
+    progressive: options.progressive || false,
+    mozjpeg: options.mozjpeg !== false, // Default to true for better compression
+    chromaSubsampling: options.chromaSubsampling || "4:2:0",
+    trellisQuantisation: options.trellisQuantisation || false,
+    optimizeScans: options.optimizeScans || false,
+    overshootDeringing: options.overshootDeringing || false,
+    optimizeCoding: options.optimizeCoding !== false, // Default to true
+    colorSpace: options.colorSpace || "srgb",
+    ...options,
+  };
+
+  // Convert the LibRaw RGB data to Sharp-compatible buffer
+  let sharpInstance;
+
+  // Determine if this is a large image for performance optimizations
+  const isLargeImage = imageData.width * imageData.height > 20_000_000; // > 20MP
+  const fastMode = opts.fastMode !== false; // Default to fast mode
+
+  // Optimized Sharp configuration
+  const sharpConfig = {
+    raw: {
+      width: imageData.width,
+      height: imageData.height,
+      channels: imageData.colors,
+      premultiplied: false,
+    },
+    // Performance optimizations
+    sequentialRead: true,
+    limitInputPixels: false,
+    density: fastMode ? 72 : 300, // Lower DPI for speed
+  };
+
+  if (imageData.bits === 16) {
+    sharpConfig.raw.depth = "ushort";
+  }
+
+  sharpInstance = sharp(imageData.data, sharpConfig);
+
+  // Apply resizing if specified with performance optimizations
+  if (opts.width || opts.height) {
+    const resizeOptions = {
+      withoutEnlargement: true,
+      // Use faster kernel for large images or when fast mode is enabled
+      kernel:
+        isLargeImage || fastMode
+          ? sharp.kernel.cubic
+          : sharp.kernel.lanczos3,
+      fit: "inside",
+      fastShrinkOnLoad: true, // Enable fast shrink-on-load optimization
+    };
+
+    if (opts.width && opts.height) {
+      sharpInstance = sharpInstance.resize(
+        opts.width,
+        opts.height,
+        resizeOptions
+      );
+    } else if (opts.width) {
+      sharpInstance = sharpInstance.resize(
+        opts.width,
+        null,
+        resizeOptions
+      );
+    } else {
+      sharpInstance = sharpInstance.resize(
+        null,
+        opts.height,
+        resizeOptions
+      );
+    }
+  }
+
+  // Configure color space
+  switch (opts.colorSpace.toLowerCase()) {
+    case "rec2020":
+      sharpInstance = sharpInstance.toColorspace("rec2020");
+      break;
+    case "p3":
+      sharpInstance = sharpInstance.toColorspace("p3");
+      break;
+    case "cmyk":
+      sharpInstance = sharpInstance.toColorspace("cmyk");
+      break;
+    case "srgb":
+    default:
+      sharpInstance = sharpInstance.toColorspace("srgb");
+      break;
+  }
+
+  // Configure JPEG options with performance optimizations
+  const jpegOptions = {
+    quality: Math.max(1, Math.min(100, opts.quality)),
+    progressive: fastMode ? false : opts.progressive, // Disable progressive for speed
+    mozjpeg: fastMode ? false : opts.mozjpeg, // Disable mozjpeg for speed
+    trellisQuantisation: fastMode ? false : opts.trellisQuantisation,
+    optimizeScans: fastMode ? false : opts.optimizeScans,
+    overshootDeringing: false, // Always disable for speed
+    optimizeCoding: fastMode ? false : opts.optimizeCoding,
+    // Add effort control for JPEG encoding
+    effort: fastMode ? 1 : Math.min(opts.effort || 4, 6),
+  };
+
+  // Set chroma subsampling
+  switch (opts.chromaSubsampling) {
+    case "4:4:4":
+      jpegOptions.chromaSubsampling = "4:4:4";
+      break;
+    case "4:2:2":
+      jpegOptions.chromaSubsampling = "4:4:4"; // Sharp doesn't support 4:2:2, use 4:4:4 instead
+      break;
+    case "4:2:0":
+    default:
+      jpegOptions.chromaSubsampling = "4:2:0";
+      break;
+  }
+
+  // Convert to JPEG and get buffer
+  const jpegBuffer = await sharpInstance
+    .jpeg(jpegOptions)
+    .toBuffer({ resolveWithObject: true });
+
+  const endTime = process.hrtime.bigint();
+  const processingTime = Number(endTime - startTime) / 1000000; // Convert to milliseconds
+
+  // Calculate compression ratio
+  const originalSize = imageData.dataSize;
+  const compressedSize = jpegBuffer.data.length;
+  const compressionRatio = originalSize / compressedSize;
+
+  const result = {
+    success: true,
+    buffer: jpegBuffer.data,
+    metadata: {
+      originalDimensions: {
+        width: imageData.width,
+        height: imageData.height,
+      },
+      outputDimensions: {
+        width: jpegBuffer.info.width,
+        height: jpegBuffer.info.height,
+      },
+      fileSize: {
+        original: originalSize,
+        compressed: compressedSize,
+        compressionRatio: compressionRatio.toFixed(2),
+      },
+      processing: {
+        timeMs: processingTime.toFixed(2),
+        throughputMBps: (
+          originalSize /
+          1024 /
+          1024 /
+          (processingTime / 1000)
+        ).toFixed(2),
+      },
+      jpegOptions: jpegOptions,
+    },
+  };
+
+  return result;
+}
+
+/**
+ * Whether createJPEGBuffer can use the addon's libjpeg encoder: the native
+ * path encodes the processed image as is, so resizing, colour space
+ * conversion and the slower mozjpeg-style tuning still go through sharp.
+ * @param {Object} options - JPEG options (see LibRaw#createJPEGBuffer)
+ * @returns {boolean}
+ */
+function canEncodeJPEGNatively(options) {
+  return (
+    librawAddon.nativeJPEG === true &&
+    options.nativeEncoder !== false &&
+    options.fastMode !== false &&
+    !options.width &&
+    !options.height &&
+    (!options.colorSpace || options.colorSpace.toLowerCase() === "srgb")
+  );
+}
+
 class LibRaw {
   constructor() {
     this._wrapper = new librawAddon.LibRawWrapper();
@@ -24,30 +221,86 @@ class LibRaw {
   /**
    * Load a RAW file from filesystem
    * @param {string} filename - Path to the RAW file
+   * @param {Object} [options] - Load options
+   * @param {boolean} [options.mmap=false] - Read the file through a memory
+   *   mapping instead of buffered I/O (falls back to buffered I/O on Windows)
+   * @param {boolean} [options.unpack=true] - Pass false to only identify the
+   *   file; metadata and thumbnails are available right away and the raw
+   *   data is unpacked on first pixel access (processImage(), raw2Image())
+   * @param {boolean|number} [options.prefetch=false] - Serve the many small
+   *   metadata reads from a few large window-aligned reads of the file (true
+   *   for 64 KiB windows, or a window size in bytes). Meant for network and
+   *   FUSE storage; see getReadStats(). Takes precedence over mmap
    * @returns {Promise<boolean>} - Success status
    */
-  async loadFile(filename) {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.loadFile(filename);
-        this._isProcessed = false; // Reset processing state for new file
-        this._processedImageData = null; // Clear cached data
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+  async loadFile(filename, options = {}) {
+    this._isProcessed = false; // Reset processing state for new file
+    this._processedImageData = null; // Clear cached data
+    // Decoding runs on the libuv thread pool, keeping the event loop free
+    return this._wrapper.loadFileAsync(filename, options);
   }
 
   /**
    * Load a RAW file from memory buffer
-   * @param {Buffer} buffer - Buffer containing RAW data
+   *
+   * The memory is used in place rather than copied and stays referenced until
+   * the next load or close(), so it must not be modified (or its ArrayBuffer
+   * transferred) in the meantime.
+   * @param {Buffer|Uint8Array|ArrayBuffer} buffer - RAW file contents; a
+   *   Uint8Array view may be backed by a SharedArrayBuffer
+   * @param {Object} [options] - Load options
+   * @param {boolean} [options.unpack=true] - See loadFile()
    * @returns {Promise<boolean>} - Success status
    */
-  async loadBuffer(buffer) {
+  async loadBuffer(buffer, options = {}) {
+    this._isProcessed = false; // Reset processing state for new file
+    this._processedImageData = null; // Clear cached data
+    // Decoding runs on the libuv thread pool, directly over the caller's memory
+    return this._wrapper.loadBufferAsync(buffer, options);
+  }
+
+  /**
+   * Load a RAW file through a range reader, e.g. from an object store,
+   * without fetching the whole file
+   *
+   * LibRaw's reads are served from a native block cache; on a miss
+   * read(offset, length) is called on the JS thread for the block (or a
+   * larger bulk range such as the raw data). Decoding waits for the reader
+   * on a thread of its own rather than a libuv pool thread, since readers
+   * often need the pool themselves. A failed read fails the operation and
+   * every later decode until the next load. The source stays in use until
+   * the next load or close(). With unpack: false, run an async pixel
+   * operation first: the synchronous subtractBlack(), adjustMaximum() and
+   * convertFloatToInt() cannot read the stream from the JS thread.
+   * @param {Object} source - Datastream source
+   * @param {number} source.size - File size in bytes
+   * @param {function(number, number): (Buffer|Uint8Array|ArrayBuffer|Promise<Buffer|Uint8Array|ArrayBuffer>)} source.read -
+   *   Returns up to `length` bytes at `offset`
+   * @param {Object} [options] - Load options
+   * @param {boolean} [options.unpack=true] - See loadFile()
+   * @param {number} [options.blockSize=262144] - Bytes per cached block,
+   *   and so per metadata read
+   * @param {number} [options.cacheBlocks=16] - Number of cached blocks
+   * @returns {Promise<boolean>} - Success status
+   */
+  async loadStream(source, options = {}) {
+    this._isProcessed = false; // Reset processing state for new file
+    this._processedImageData = null; // Clear cached data
+    const reader = {
+      size: source.size,
+      read: (offset, length) => source.read(offset, length),
+    };
+    return this._wrapper.loadStreamAsync(reader, options);
+  }
+
+  /**
+   * Close and cleanup resources
+   * @returns {Promise<boolean>} - Success status
+   */
+  async close() {
     return new Promise((resolve, reject) => {
       try {
-        const result = this._wrapper.loadBuffer(buffer);
+        const result = this._wrapper.close();
         resolve(result);
       } catch (error) {
         reject(error);
@@ -56,14 +309,15 @@ class LibRaw {
   }
 
   /**
-   * Close and cleanup resources
-   * @returns {Promise<boolean>} - Success status
+   * Report how much of the file has been read so far, for files loaded with
+   * the prefetch option or through loadStream()
+   * @returns {Promise<Object|null>} - { bytesRead, reads, fileSize }, or null
+   *   for other loads
    */
-  async close() {
+  async getReadStats() {
     return new Promise((resolve, reject) => {
       try {
-        const result = this._wrapper.close();
-        resolve(result);
+        resolve(this._wrapper.getReadStats());
       } catch (error) {
         reject(error);
       }
@@ -173,14 +427,7 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async unpackThumbnail() {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.unpackThumbnail();
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.unpackThumbnailAsync();
   }
 
   /**
@@ -188,15 +435,51 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async processImage() {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.processImage();
-        this._isProcessed = true; // Mark as processed
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    const result = await this._wrapper.processImageAsync();
+    this._isProcessed = true; // Mark as processed
+    return result;
+  }
+
+  /**
+   * Process a screen-sized preview straight from the RAW data
+   *
+   * Instead of demosaicing the full image and resizing it, the preview is
+   * built from half-size pixels (one per 2x2 sensor block, no demosaicing),
+   * binned further for small targets. The longer edge is at least maxEdge
+   * and, for Bayer sensors, less than about twice that. The instance is left
+   * unprocessed, so the full-size conversions still process at full size.
+   * @param {Object} [options] - Preview options
+   * @param {number} [options.maxEdge=1024] - Smallest acceptable longer edge
+   * @returns {Promise<Object>} - Image data object, as createMemoryImage()
+   */
+  async processPreview(options = {}) {
+    const image = await this._wrapper.processPreviewAsync(options);
+    this._isProcessed = false; // the processed image is not full size
+    return image;
+  }
+
+  /**
+   * Process only a rectangle of the full-size image
+   *
+   * Coordinates are those of the full-size, rotated output of
+   * processImage(). Only the rectangle plus a margin (`halo`) for the
+   * demosaic is decoded, interpolated and converted, so the time depends on
+   * the region size rather than on the sensor size. With the default halo,
+   * Bayer images match the same crop of a full run (bilinear through AHD);
+   * auto-brightness still follows the region's own histogram, so tiles that
+   * must fit together need no_auto_bright or a fixed bright.
+   * @param {number} x - Left edge of the region in output pixels
+   * @param {number} y - Top edge of the region in output pixels
+   * @param {number} width - Region width in pixels
+   * @param {number} height - Region height in pixels
+   * @param {Object} [options] - Region options
+   * @param {number} [options.halo=32] - Extra sensor pixels processed around the region
+   * @returns {Promise<Object>} - Image data object, as createMemoryImage()
+   */
+  async processRegion(x, y, width, height, options = {}) {
+    const image = await this._wrapper.processRegionAsync(x, y, width, height, options);
+    this._isProcessed = false; // the processed image covers the region only
+    return image;
   }
 
   /**
@@ -219,14 +502,7 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async raw2Image() {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.raw2Image();
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.raw2ImageAsync();
   }
 
   /**
@@ -251,26 +527,89 @@ class LibRaw {
    * @returns {Promise<Object>} - Image data object with Buffer
    */
   async createMemoryImage() {
-    return new Promise((resolve, reject) => {
-      try {
-        // Return cached data if available
-        if (this._processedImageData) {
-          resolve(this._processedImageData);
-          return;
-        }
+    // Return cached data if available
+    if (this._processedImageData) {
+      return this._processedImageData;
+    }
 
-        const imageData = this._wrapper.createMemoryImage();
+    const imageData = await this._wrapper.createMemoryImageAsync();
 
-        // Cache the result if image was processed
-        if (this._isProcessed) {
-          this._processedImageData = imageData;
-        }
+    // Cache the result if image was processed
+    if (this._isProcessed) {
+      this._processedImageData = imageData;
+    }
 
-        resolve(imageData);
-      } catch (error) {
-        reject(error);
+    return imageData;
+  }
+
+  /**
+   * Stream the processed image in bands of rows
+   *
+   * Same pixels as createMemoryImage(), but converted band by band: the
+   * native side only ever holds one band of output rows, and the next band
+   * is converted once the consumer has taken the previous one, so no
+   * full-size RGB copy exists next to LibRaw's working image. The native
+   * side waits for the consumer on its own thread, not a libuv pool thread,
+   * so piping into pool-backed sinks such as file streams is safe. The stream
+   * emits 'info' ({ width, height, colors, bits }) before the first data.
+   * Processes the image first if that has not happened yet.
+   * @param {Object} [options] - Stream options
+   * @param {number} [options.bandRows=64] - Output rows per chunk
+   * @returns {Readable} - Readable stream of interleaved RGB rows
+   */
+  createImageStream(options = {}) {
+    const bandRows = options.bandRows || 64;
+    // Settles the native writer's wait for the consumer
+    let wake = null;
+    const resume = (more) => {
+      if (wake) {
+        const settle = wake;
+        wake = null;
+        settle(more);
       }
+    };
+
+    const stream = new Readable({
+      read() {
+        resume(true);
+      },
+      destroy(error, callback) {
+        resume(false);
+        callback(error);
+      },
     });
+
+    const run = async () => {
+      if (!this._isProcessed) {
+        await this.processImage();
+      }
+      await this._wrapper.streamImageAsync(bandRows, (band, info) => {
+        if (stream.destroyed) {
+          return false;
+        }
+        if (!stream.info) {
+          const { width, height, colors, bits } = info;
+          stream.info = { width, height, colors, bits };
+          stream.emit("info", stream.info);
+        }
+        if (stream.push(band)) {
+          return true;
+        }
+        return new Promise((resolve) => {
+          wake = resolve;
+        });
+      });
+    };
+    run().then(
+      () => {
+        if (!stream.destroyed) {
+          stream.push(null);
+        }
+      },
+      (error) => stream.destroy(error)
+    );
+
+    return stream;
   }
 
   /**
@@ -278,14 +617,7 @@ class LibRaw {
    * @returns {Promise<Object>} - Thumbnail data object with Buffer
    */
   async createMemoryThumbnail() {
-    return new Promise((resolve, reject) => {
-      try {
-        const thumbData = this._wrapper.createMemoryThumbnail();
-        resolve(thumbData);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.createMemoryThumbnailAsync();
   }
 
   // ============== FILE WRITERS ==============
@@ -296,14 +628,7 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async writePPM(filename) {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.writePPM(filename);
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.writePPMAsync(filename);
   }
 
   /**
@@ -312,14 +637,7 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async writeTIFF(filename) {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.writeTIFF(filename);
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.writeTIFFAsync(filename);
   }
 
   /**
@@ -328,14 +646,7 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async writeThumbnail(filename) {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.writeThumbnail(filename);
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.writeThumbnailAsync(filename);
   }
 
   // ============== CONFIGURATION & SETTINGS ==============
@@ -563,14 +874,7 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async unpack() {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.unpack();
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.unpackAsync();
   }
 
   /**
@@ -579,14 +883,7 @@ class LibRaw {
    * @returns {Promise<boolean>} - Success status
    */
   async raw2ImageEx(subtractBlack = true) {
-    return new Promise((resolve, reject) => {
-      try {
-        const result = this._wrapper.raw2ImageEx(subtractBlack);
-        resolve(result);
-      } catch (error) {
-        reject(error);
-      }
-    });
+    return this._wrapper.raw2ImageExAsync(subtractBlack);
   }
 
   /**
@@ -707,25 +1004,12 @@ class LibRaw {
    * @param {number} [options.overshootDeringing=false] - Overshoot deringing
    * @param {boolean} [options.optimizeCoding=true] - Optimize Huffman coding
    * @param {string} [options.colorSpace='srgb'] - Output color space ('srgb', 'rec2020', 'p3', 'cmyk')
+   * @param {boolean} [options.nativeEncoder=true] - Use the addon's libjpeg encoder when the options allow it
    * @returns {Promise<Object>} - JPEG buffer with metadata
    */
   async createJPEGBuffer(options = {}) {
     return new Promise(async (resolve, reject) => {
       try {
-        // Set default options with performance-optimized values
-        const opts = {
-          quality: options.quality || 85,
-          progressive: options.progressive || false,
-          mozjpeg: options.mozjpeg !== false, // Default to true for better compression
-          chromaSubsampling: options.chromaSubsampling || "4:2:0",
-          trellisQuantisation: options.trellisQuantisation || false,
-          optimizeScans: options.optimizeScans || false,
-          overshootDeringing: options.overshootDeringing || false,
-          optimizeCoding: options.optimizeCoding !== false, // Default to true
-          colorSpace: options.colorSpace || "srgb",
-          ...options,
-        };
-
         const startTime = process.hrtime.bigint();
 
         // Smart processing: only process if not already processed
@@ -733,6 +1017,11 @@ class LibRaw {
           await this.processImage();
         }
 
+        if (canEncodeJPEGNatively(options)) {
+          resolve(await this._encodeJPEGNative(options, startTime));
+          return;
+        }
+
         // Create processed image in memory (uses cache if available)
         const imageData = await this.createMemoryImage();
 
@@ -740,161 +1029,63 @@ class LibRaw {
           throw new Error("Failed to create memory image from RAW data");
         }
 
-        // Convert the LibRaw RGB data to Sharp-compatible buffer
-        let sharpInstance;
-
-        // Determine if this is a large image for performance optimizations
-        const isLargeImage = imageData.width * imageData.height > 20_000_000; // > 20MP
-        const fastMode = opts.fastMode !== false; // Default to fast mode
-
-        // Optimized Sharp configuration
-        const sharpConfig = {
-          raw: {
-            width: imageData.width,
-            height: imageData.height,
-            channels: imageData.colors,
-            premultiplied: false,
-          },
-          // Performance optimizations
-          sequentialRead: true,
-          limitInputPixels: false,
-          density: fastMode ? 72 : 300, // Lower DPI for speed
-        };
-
-        if (imageData.bits === 16) {
-          sharpConfig.raw.depth = "ushort";
-        }
-
-        sharpInstance = sharp(imageData.data, sharpConfig);
-
-        // Apply resizing if specified with performance optimizations
-        if (opts.width || opts.height) {
-          const resizeOptions = {
-            withoutEnlargement: true,
-            // Use faster kernel for large images or when fast mode is enabled
-            kernel:
-              isLargeImage || fastMode
-                ? sharp.kernel.cubic
-                : sharp.kernel.lanczos3,
-            fit: "inside",
-            fastShrinkOnLoad: true, // Enable fast shrink-on-load optimization
-          };
-
-          if (opts.width && opts.height) {
-            sharpInstance = sharpInstance.resize(
-              opts.width,
-              opts.height,
-              resizeOptions
-            );
-          } else if (opts.width) {
-            sharpInstance = sharpInstance.resize(
-              opts.width,
-              null,
-              resizeOptions
-            );
-          } else {
-            sharpInstance = sharpInstance.resize(
-              null,
-              opts.height,
-              resizeOptions
-            );
-          }
-        }
-
-        // Configure color space
-        switch (opts.colorSpace.toLowerCase()) {
-          case "rec2020":
-            sharpInstance = sharpInstance.toColorspace("rec2020");
-            break;
-          case "p3":
-            sharpInstance = sharpInstance.toColorspace("p3");
-            break;
-          case "cmyk":
-            sharpInstance = sharpInstance.toColorspace("cmyk");
-            break;
-          case "srgb":
-          default:
-            sharpInstance = sharpInstance.toColorspace("srgb");
-            break;
-        }
-
-        // Configure JPEG options with performance optimizations
-        const jpegOptions = {
-          quality: Math.max(1, Math.min(100, opts.quality)),
-          progressive: fastMode ? false : opts.progressive, // Disable progressive for speed
-          mozjpeg: fastMode ? false : opts.mozjpeg, // Disable mozjpeg for speed
-          trellisQuantisation: fastMode ? false : opts.trellisQuantisation,
-          optimizeScans: fastMode ? false : opts.optimizeScans,
-          overshootDeringing: false, // Always disable for speed
-          optimizeCoding: fastMode ? false : opts.optimizeCoding,
-          // Add effort control for JPEG encoding
-          effort: fastMode ? 1 : Math.min(opts.effort || 4, 6),
-        };
-
-        // Set chroma subsampling
-        switch (opts.chromaSubsampling) {
-          case "4:4:4":
-            jpegOptions.chromaSubsampling = "4:4:4";
-            break;
-          case "4:2:2":
-            jpegOptions.chromaSubsampling = "4:4:4"; // Sharp doesn't support 4:2:2, use 4:4:4 instead
-            break;
-          case "4:2:0":
-          default:
-            jpegOptions.chromaSubsampling = "4:2:0";
-            break;
-        }
-
-        // Convert to JPEG and get buffer
-        const jpegBuffer = await sharpInstance
-          .jpeg(jpegOptions)
-          .toBuffer({ resolveWithObject: true });
-
-        const endTime = process.hrtime.bigint();
-        const processingTime = Number(endTime - startTime) / 1000000; // Convert to milliseconds
-
-        // Calculate compression ratio
-        const originalSize = imageData.dataSize;
-        const compressedSize = jpegBuffer.data.length;
-        const compressionRatio = originalSize / compressedSize;
-
-        const result = {
-          success: true,
-          buffer: jpegBuffer.data,
-          metadata: {
-            originalDimensions: {
-              width: imageData.width,
-              height: imageData.height,
-            },
-            outputDimensions: {
-              width: jpegBuffer.info.width,
-              height: jpegBuffer.info.height,
-            },
-            fileSize: {
-              original: originalSize,
-              compressed: compressedSize,
-              compressionRatio: compressionRatio.toFixed(2),
-            },
-            processing: {
-              timeMs: processingTime.toFixed(2),
-              throughputMBps: (
-                originalSize /
-                1024 /
-                1024 /
-                (processingTime / 1000)
-              ).toFixed(2),
-            },
-            jpegOptions: jpegOptions,
-          },
-        };
-
-        resolve(result);
+        resolve(await encodeJPEGBuffer(imageData, options, startTime));
       } catch (error) {
         reject(new Error(`JPEG buffer creation failed: ${error.message}`));
       }
     });
   }
 
+  /**
+   * Encode the processed image with the addon's libjpeg encoder
+   *
+   * Runs on the worker thread straight from LibRaw's working image, so
+   * neither the memory image nor sharp's copy of it is created.
+   * @private
+   * @param {Object} options - JPEG options (see createJPEGBuffer)
+   * @param {bigint} startTime - hrtime the processing time is measured from
+   * @returns {Promise<Object>} - JPEG buffer with metadata, as createJPEGBuffer
+   */
+  async _encodeJPEGNative(options, startTime) {
+    const jpegOptions = {
+      quality: Math.max(1, Math.min(100, options.quality || 85)),
+      progressive: options.progressive === true,
+      optimizeCoding: options.optimizeCoding === true,
+      chromaSubsampling: options.chromaSubsampling || "4:2:0",
+      encoder: "libjpeg",
+    };
+    const { buffer, width, height, colors } =
+      await this._wrapper.encodeJPEGAsync(jpegOptions);
+
+    const processingTime =
+      Number(process.hrtime.bigint() - startTime) / 1000000;
+    const originalSize = width * height * colors;
+
+    return {
+      success: true,
+      buffer,
+      metadata: {
+        originalDimensions: { width, height },
+        outputDimensions: { width, height },
+        fileSize: {
+          original: originalSize,
+          compressed: buffer.length,
+          compressionRatio: (originalSize / buffer.length).toFixed(2),
+        },
+        processing: {
+          timeMs: processingTime.toFixed(2),
+          throughputMBps: (
+            originalSize /
+            1024 /
+            1024 /
+            (processingTime / 1000)
+          ).toFixed(2),
+        },
+        jpegOptions,
+      },
+    };
+  }
+
   /**
    * Create processed image as PNG buffer in memory
    * @param {Object} options - PNG conversion options
@@ -2000,6 +2191,19 @@ class LibRaw {
     });
   }
 
+  // ============== THREADING ==============
+
+  /**
+   * Bound the number of OpenMP threads LibRaw may use for this instance's
+   * decode and processing operations. Only has an effect when the addon was
+   * built with LIBRAW_OPENMP=1.
+   * @param {number} threads - Maximum threads per operation (0 = default)
+   * @returns {number} - Effective team size (1 without OpenMP)
+   */
+  setThreads(threads) {
+    return this._wrapper.setThreads(threads);
+  }
+
   // ============== CANCELLATION SUPPORT ==============
 
   /**
@@ -2060,6 +2264,15 @@ class LibRaw {
     return librawAddon.LibRawWrapper.getVersion();
   }
 
+  /**
+   * Whether the addon was built with its native libjpeg encoder
+   * (LIBRAW_JPEG=1), which createJPEGBuffer uses when the options allow
+   * @returns {boolean}
+   */
+  static hasNativeJPEG() {
+    return librawAddon.nativeJPEG === true;
+  }
+
   /**
    * Get LibRaw capabilities
    * @returns {number} - Capabilities flags
@@ -2084,6 +2297,46 @@ class LibRaw {
     return librawAddon.LibRawWrapper.getCameraCount();
   }
 
+  /**
+   * Configure the shared pool of native LibRaw processors. Instances borrow a
+   * processor on construction (or on the first load after close()) and give
+   * it back on close(), so steady-state workloads avoid re-allocating them.
+   * @param {Object} options - Pool options
+   * @param {number} [options.maxIdle] - Maximum processors kept idle
+   * @param {number} [options.prewarm] - Construct processors up front
+   * @returns {Object} - Pool statistics after the change
+   */
+  static configurePool(options = {}) {
+    return librawAddon.LibRawWrapper.configurePool(options);
+  }
+
+  /**
+   * Get statistics of the shared processor pool
+   * @returns {Object} - { idle, maxIdle, created, reused, discarded }
+   */
+  static getPoolStats() {
+    return librawAddon.LibRawWrapper.getPoolStats();
+  }
+
+  /**
+   * Extract an embedded thumbnail without decoding the RAW data
+   *
+   * Only the metadata and the thumbnail's bytes are read, on the libuv thread
+   * pool, using a processor from the shared pool.
+   * @param {string|Buffer|Uint8Array|ArrayBuffer} source - File path or RAW
+   *   file contents
+   * @param {Object} [options] - Selection options
+   * @param {number} [options.index] - Position in the file's thumbnail list
+   *   (0 = first); overrides maxSize
+   * @param {number} [options.maxSize] - Pick the largest thumbnail whose
+   *   longer edge is at most maxSize pixels (the smallest if none fits)
+   * @returns {Promise<Object>} - { type, width, height, colors, bits,
+   *   dataSize, data, index }; type 1 is JPEG data, 2 is an RGB bitmap
+   */
+  static async extractThumbnail(source, options = {}) {
+    return librawAddon.LibRawWrapper.extractThumbnail(source, options);
+  }
+
   /**
    * High-performance fast JPEG conversion with minimal processing
    * @param {string} outputPath - Output JPEG file path
@@ -2165,10 +2418,16 @@ class LibRaw {
   }
 
   /**
-   * High-performance parallel batch conversion using worker threads
+   * High-performance parallel batch conversion on a native worker pool.
+   * Files are decoded by a work-stealing pool of LibRaw processors and each
+   * decoded image is JPEG-encoded as soon as it arrives. At most
+   * maxConcurrency encodes run at a time; beyond that the decoders wait, so
+   * memory stays bounded when encoding is the slower stage.
    * @param {string[]} inputPaths - Array of RAW file paths
    * @param {string} outputDir - Output directory
    * @param {Object} options - Conversion options
+   * @param {number} [options.maxConcurrency] - Number of decode threads and
+   *   concurrent encodes
    * @returns {Promise<Object>} - Batch conversion results
    */
   static async batchConvertToJPEGParallel(inputPaths, outputDir, options = {}) {
@@ -2182,54 +2441,68 @@ class LibRaw {
 
     const maxConcurrency =
       options.maxConcurrency || Math.min(os.cpus().length, 4);
-    const results = [];
+    const results = new Array(inputPaths.length);
     const errors = [];
+    // Encodes in flight; never rejects, see the catch below
+    const encoding = new Set();
     const startTime = Date.now();
 
-    // Process files in parallel batches
-    for (let i = 0; i < inputPaths.length; i += maxConcurrency) {
-      const batch = inputPaths.slice(i, i + maxConcurrency);
+    const jpegOptions = {
+      fastMode: true,
+      effort: 1,
+      quality: options.quality || 85,
+      ...options,
+    };
 
-      const batchPromises = batch.map(async (inputPath) => {
-        try {
-          const fileName = path.parse(inputPath).name;
-          const outputPath = path.join(outputDir, `${fileName}.jpg`);
+    const batch = new librawAddon.BatchProcessor({ threads: maxConcurrency });
 
-          const libraw = new LibRaw();
-          await libraw.loadFile(inputPath);
+    await batch.run(inputPaths, (event) => {
+      const inputPath = event.file;
 
-          const result = await libraw.convertToJPEG(outputPath, {
-            fastMode: true,
-            effort: 1,
-            quality: options.quality || 85,
-            ...options,
-          });
+      if (!event.success) {
+        errors.push({ inputPath, error: event.error });
+        results[event.index] = { inputPath, success: false, error: event.error };
+        return;
+      }
 
-          await libraw.close();
+      const fileName = path.parse(inputPath).name;
+      const outputPath = path.join(outputDir, `${fileName}.jpg`);
 
-          return {
+      const encode = encodeJPEGBuffer(event.image, jpegOptions)
+        .then(async (result) => {
+          await fs.promises.writeFile(outputPath, result.buffer);
+          results[event.index] = {
             inputPath,
             outputPath,
             success: true,
-            fileSize: result.metadata.fileSize.compressed,
-            processingTime: result.metadata.processing.timeMs,
+            fileSize: result.buffer.length,
+            processingTime: (
+              event.timeMs + parseFloat(result.metadata.processing.timeMs)
+            ).toFixed(2),
           };
-        } catch (error) {
+        })
+        .catch((error) => {
           errors.push({ inputPath, error: error.message });
-          return {
+          results[event.index] = {
             inputPath,
             success: false,
             error: error.message,
           };
-        }
-      });
+        })
+        .finally(() => encoding.delete(encode));
+      encoding.add(encode);
+
+      // At the limit, hold this decoder until an encode finishes, so decoded
+      // images cannot pile up while sharp is slower than LibRaw
+      if (encoding.size >= maxConcurrency) {
+        return Promise.race(encoding);
+      }
+    });
 
-      const batchResults = await Promise.all(batchPromises);
-      results.push(...batchResults);
-    }
+    await Promise.all(encoding);
 
     const endTime = Date.now();
-    const successCount = results.filter((r) => r.success).length;
+    const successCount = results.filter((r) => r && r.success).length;
 
     return {
       totalFiles: inputPaths.length,
@@ -2244,4 +2517,6 @@ class LibRaw {
   }
 }
 
+LibRaw.BatchProcessor = librawAddon.BatchProcessor;
+
 module.exports = LibRaw;
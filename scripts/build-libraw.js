@@ -9,6 +9,33 @@ class LibRawBuilder {
     this.arch = os.arch();
     this.librawSourceDir = path.join(__dirname, "../deps/LibRaw-Source/LibRaw-0.21.4");
     this.buildDir = path.join(this.librawSourceDir, "build");
+    // OpenMP variant: LIBRAW_OPENMP=1 npm run build
+    this.openmp = process.env.LIBRAW_OPENMP === "1";
+    // Lossy DNG support (and the native JPEG encoder): LIBRAW_JPEG=1,
+    // LIBJPEG_INCLUDE / LIBJPEG_LIB select e.g. a static libjpeg-turbo
+    this.jpeg = process.env.LIBRAW_JPEG === "1";
+    // Deflate-compressed (floating-point / HDR) DNGs: LIBRAW_ZLIB=1
+    this.zlib = process.env.LIBRAW_ZLIB === "1";
+  }
+
+  // CPPFLAGS/LDFLAGS so that configure finds the requested libjpeg
+  getConfigureEnv() {
+    const env = { ...process.env };
+    if (!this.jpeg) {
+      return env;
+    }
+    const cppflags = [env.CPPFLAGS];
+    const ldflags = [env.LDFLAGS];
+    if (process.env.LIBJPEG_INCLUDE) {
+      cppflags.push(`-I${process.env.LIBJPEG_INCLUDE}`);
+    }
+    const lib = process.env.LIBJPEG_LIB;
+    if (lib && !lib.startsWith("-")) {
+      ldflags.push(`-L${path.dirname(lib)}`);
+    }
+    env.CPPFLAGS = cppflags.filter(Boolean).join(" ");
+    env.LDFLAGS = ldflags.filter(Boolean).join(" ");
+    return env;
   }
 
   getPlatformName() {
@@ -51,18 +78,34 @@ class LibRawBuilder {
         '--disable-shared',
         '--enable-static',
         '--disable-lcms',      // 禁用 LCMS 颜色管理
-        '--disable-jpeg',      // 禁用 JPEG 支持
-        '--disable-zlib',      // 禁用 zlib 压缩
-        '--disable-openmp',    // 禁用 OpenMP 多线程
+        this.jpeg ? '--enable-jpeg' : '--disable-jpeg', // 有损 DNG (LIBRAW_JPEG=1)
+        this.zlib ? '--enable-zlib' : '--disable-zlib', // Deflate DNG (LIBRAW_ZLIB=1)
+        this.openmp ? '--enable-openmp' : '--disable-openmp', // OpenMP 多线程 (LIBRAW_OPENMP=1)
         '--disable-examples'   // 禁用示例程序
       ];
 
-      this.log("Configuring LibRaw...");
+      this.log(`Configuring LibRaw (OpenMP ${this.openmp ? "enabled" : "disabled"}, JPEG ${this.jpeg ? "enabled" : "disabled"}, zlib ${this.zlib ? "enabled" : "disabled"})...`);
       execSync(`./configure ${configureArgs.join(' ')}`, {
         cwd: this.librawSourceDir,
-        stdio: 'inherit'
+        stdio: 'inherit',
+        env: this.getConfigureEnv()
       });
 
+      // configure only warns when libjpeg is missing
+      if (this.jpeg) {
+        const makefile = fs.readFileSync(path.join(this.librawSourceDir, "Makefile"), "utf8");
+        if (!makefile.includes("-DUSE_JPEG")) {
+          throw new Error("LIBRAW_JPEG=1 but configure did not find libjpeg (set LIBJPEG_INCLUDE / LIBJPEG_LIB)");
+        }
+      }
+      // likewise for zlib, which configure looks up through pkg-config
+      if (this.zlib) {
+        const makefile = fs.readFileSync(path.join(this.librawSourceDir, "Makefile"), "utf8");
+        if (!makefile.includes("-DUSE_ZLIB")) {
+          throw new Error("LIBRAW_ZLIB=1 but configure did not find zlib (pkg-config zlib)");
+        }
+      }
+
       this.log("Building LibRaw...");
       execSync('make -j4', {
         cwd: this.librawSourceDir,
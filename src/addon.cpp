@@ -1,8 +1,10 @@
 #include <napi.h>
 #include "libraw_wrapper.h"
+#include "batch_processor.h"
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
-    return LibRawWrapper::Init(env, exports);
+    LibRawWrapper::Init(env, exports);
+    return BatchProcessor::Init(env, exports);
 }
 
 NODE_API_MODULE(libraw_addon, InitAll)
@@ -0,0 +1,389 @@
+#include "batch_processor.h"
+#include "libraw_wrapper.h"
+#include "libraw_pool.h"
+#include "libraw_async.h"
+#include "js_blocking_call.h"
+#include <algorithm>
+#include <sys/stat.h>
+
+Napi::FunctionReference BatchProcessor::constructor;
+
+Napi::Object BatchProcessor::Init(Napi::Env env, Napi::Object exports)
+{
+    Napi::HandleScope scope(env);
+
+    Napi::Function func = DefineClass(env, "BatchProcessor", {InstanceMethod("run", &BatchProcessor::Run), InstanceMethod("cancel", &BatchProcessor::Cancel), InstanceMethod("isRunning", &BatchProcessor::IsRunning), InstanceMethod("getThreadCount", &BatchProcessor::GetThreadCount)});
+
+    constructor = Napi::Persistent(func);
+    constructor.SuppressDestruct();
+
+    exports.Set("BatchProcessor", func);
+    return exports;
+}
+
+// One decoded file handed to onResult(event)
+struct BatchProcessor::Delivery : public JSBlockingCall
+{
+    FileResult *result;
+
+    explicit Delivery(FileResult *result) : JSBlockingCall("onResult()"), result(result) {}
+
+    std::vector<napi_value> Arguments(Napi::Env env) override
+    {
+        Napi::Object event = Napi::Object::New(env);
+        event.Set("index", Napi::Number::New(env, static_cast<double>(result->index)));
+        event.Set("file", Napi::String::New(env, result->file));
+        event.Set("success", Napi::Boolean::New(env, result->image != nullptr));
+        event.Set("timeMs", Napi::Number::New(env, result->timeMs));
+
+        if (result->image)
+        {
+            libraw_processed_image_t *image = result->image;
+            result->image = nullptr; // ownership moves to the JS Buffer
+            event.Set("image", LibRawWrapper::CreateImageDataObject(env, image));
+        }
+        else
+        {
+            event.Set("error", Napi::String::New(env, result->error));
+        }
+        return {event};
+    }
+
+    void Resolve(Napi::Value) override {}
+};
+
+BatchProcessor::FileResult::~FileResult()
+{
+    if (image)
+        LibRaw::dcraw_clear_mem(image);
+}
+
+BatchProcessor::BatchProcessor(const Napi::CallbackInfo &info)
+    : Napi::ObjectWrap<BatchProcessor>(info), cancelled(false), succeeded(0), failed(0), threadsPerFile(0), running(false)
+{
+    Napi::Env env = info.Env();
+    Napi::HandleScope scope(env);
+
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    Napi::Object params;
+    bool hasParams = false;
+
+    if (info.Length() > 0 && info[0].IsObject())
+    {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("threads") && options.Get("threads").IsNumber())
+        {
+            int32_t requested = options.Get("threads").As<Napi::Number>().Int32Value();
+            if (requested > 0)
+            {
+                threadCount = static_cast<size_t>(requested);
+            }
+        }
+        if (options.Has("threadsPerFile") && options.Get("threadsPerFile").IsNumber())
+        {
+            threadsPerFile = std::max(0, options.Get("threadsPerFile").As<Napi::Number>().Int32Value());
+        }
+        if (options.Has("params") && options.Get("params").IsObject())
+        {
+            params = options.Get("params").As<Napi::Object>();
+            hasParams = true;
+        }
+    }
+
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        std::unique_ptr<LibRaw> processor = LibRawPool::Instance().Acquire();
+        if (hasParams)
+        {
+            LibRawWrapper::ApplyOutputParams(params, processor->imgdata.params);
+        }
+        processors.push_back(std::move(processor));
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+BatchProcessor::~BatchProcessor()
+{
+    // A running batch holds a reference to this object, so no worker can
+    // still be alive here.
+    for (std::thread &thread : threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    for (std::unique_ptr<LibRaw> &processor : processors)
+    {
+        LibRawPool::Instance().Release(std::move(processor));
+    }
+}
+
+Napi::Value BatchProcessor::Run(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (running)
+    {
+        Napi::Error::New(env, "BatchProcessor is already running").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsFunction())
+    {
+        Napi::TypeError::New(env, "Expected (files: string[], onResult: function)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array input = info[0].As<Napi::Array>();
+    std::vector<std::string> paths;
+    paths.reserve(input.Length());
+    for (uint32_t i = 0; i < input.Length(); i++)
+    {
+        Napi::Value item = input.Get(i);
+        if (!item.IsString())
+        {
+            Napi::TypeError::New(env, "Expected array of file paths").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        paths.push_back(item.As<Napi::String>().Utf8Value());
+    }
+
+    deferred = std::make_unique<Napi::Promise::Deferred>(Napi::Promise::Deferred::New(env));
+    Napi::Promise promise = deferred->Promise();
+
+    files = std::move(paths);
+    cancelled = false;
+    callbackError.clear();
+    succeeded = 0;
+    failed = 0;
+    startTime = std::chrono::steady_clock::now();
+    running = true;
+    self = Napi::Persistent(Value());
+
+    size_t workerCount = std::min(processors.size(), files.size());
+    if (workerCount == 0)
+    {
+        Finish(env);
+        return promise;
+    }
+
+    DistributeWork();
+
+    tsfn = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "LibRaw.BatchProcessor", workerCount, workerCount,
+                                         [this](Napi::Env env)
+                                         { Finish(env); });
+
+    // Share the OpenMP cores between the workers instead of letting every
+    // decode spawn a full team
+    int teamSize = threadsPerFile > 0 ? threadsPerFile : std::max(1, OpenMPTeamSize(0) / static_cast<int>(workerCount));
+
+    for (size_t worker = 0; worker < workerCount; worker++)
+    {
+        processors[worker]->clearCancelFlag();
+        threads.emplace_back(&BatchProcessor::WorkerLoop, this, worker, teamSize);
+    }
+
+    return promise;
+}
+
+Napi::Value BatchProcessor::Cancel(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (running)
+    {
+        cancelled = true;
+        for (std::unique_ptr<LibRaw> &processor : processors)
+        {
+            processor->setCancelFlag();
+        }
+    }
+
+    return Napi::Boolean::New(env, running);
+}
+
+Napi::Value BatchProcessor::IsRunning(const Napi::CallbackInfo &info)
+{
+    return Napi::Boolean::New(info.Env(), running);
+}
+
+Napi::Value BatchProcessor::GetThreadCount(const Napi::CallbackInfo &info)
+{
+    return Napi::Number::New(info.Env(), static_cast<double>(processors.size()));
+}
+
+// Deal files to the worker deques largest first, so the expensive files start
+// early and the cheap ones are left over for stealing at the end.
+void BatchProcessor::DistributeWork()
+{
+    std::vector<std::pair<long long, size_t>> bySize;
+    bySize.reserve(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        struct stat st;
+        long long size = stat(files[i].c_str(), &st) == 0 ? static_cast<long long>(st.st_size) : 0;
+        bySize.emplace_back(size, i);
+    }
+    std::stable_sort(bySize.begin(), bySize.end(), [](const std::pair<long long, size_t> &a, const std::pair<long long, size_t> &b)
+                     { return a.first > b.first; });
+
+    size_t workerCount = std::min(processors.size(), files.size());
+    for (size_t i = 0; i < bySize.size(); i++)
+    {
+        queues[i % workerCount]->items.push_back(bySize[i].second);
+    }
+}
+
+bool BatchProcessor::NextItem(size_t worker, size_t &index)
+{
+    {
+        WorkQueue &own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.items.empty())
+        {
+            index = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); offset++)
+    {
+        WorkQueue &victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.items.empty())
+        {
+            index = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void BatchProcessor::WorkerLoop(size_t worker, int teamSize)
+{
+    LimitOpenMPThreads(teamSize);
+
+    LibRaw *processor = processors[worker].get();
+    size_t index;
+
+    while (!cancelled && NextItem(worker, index))
+    {
+        FileResult *result = new FileResult();
+        result->index = index;
+        result->file = files[index];
+
+        auto fileStart = std::chrono::steady_clock::now();
+        bool ok = DecodeFile(processor, result);
+        result->timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fileStart).count();
+
+        if (ok)
+            succeeded++;
+        else
+            failed++;
+
+        // Waits while the JS side is behind, which bounds the number of
+        // decoded images waiting in memory.
+        Delivery delivery(result);
+        if (delivery.Run(tsfn) && !delivery.error.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(callbackErrorMutex);
+                if (callbackError.empty())
+                    callbackError = delivery.error;
+            }
+            cancelled = true;
+            for (std::unique_ptr<LibRaw> &other : processors)
+            {
+                other->setCancelFlag();
+            }
+        }
+        delete result;
+    }
+
+    tsfn.Release();
+}
+
+bool BatchProcessor::DecodeFile(LibRaw *processor, FileResult *result)
+{
+    int ret = processor->open_file(result->file.c_str());
+    if (ret != LIBRAW_SUCCESS)
+    {
+        result->error = std::string("Failed to open file: ") + libraw_strerror(ret);
+        processor->recycle();
+        return false;
+    }
+
+    ret = processor->unpack();
+    if (ret != LIBRAW_SUCCESS)
+    {
+        result->error = std::string("Failed to unpack file: ") + libraw_strerror(ret);
+        processor->recycle();
+        return false;
+    }
+
+    ret = processor->dcraw_process();
+    if (ret != LIBRAW_SUCCESS)
+    {
+        result->error = std::string("Failed to process image: ") + libraw_strerror(ret);
+        processor->recycle();
+        return false;
+    }
+
+    int errcode = 0;
+    result->image = processor->dcraw_make_mem_image(&errcode);
+    processor->recycle();
+    if (!result->image || errcode != LIBRAW_SUCCESS)
+    {
+        result->error = "Failed to create memory image: ";
+        result->error += errcode != LIBRAW_SUCCESS ? libraw_strerror(errcode) : "Unknown error";
+        return false;
+    }
+
+    return true;
+}
+
+void BatchProcessor::Finish(Napi::Env env)
+{
+    for (std::thread &thread : threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    threads.clear();
+
+    for (std::unique_ptr<WorkQueue> &queue : queues)
+    {
+        queue->items.clear();
+    }
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    size_t done = succeeded + failed;
+
+    Napi::Object summary = Napi::Object::New(env);
+    summary.Set("total", Napi::Number::New(env, static_cast<double>(files.size())));
+    summary.Set("succeeded", Napi::Number::New(env, static_cast<double>(succeeded)));
+    summary.Set("failed", Napi::Number::New(env, static_cast<double>(failed)));
+    summary.Set("skipped", Napi::Number::New(env, static_cast<double>(files.size() - done)));
+    summary.Set("cancelled", Napi::Boolean::New(env, cancelled));
+    summary.Set("threads", Napi::Number::New(env, static_cast<double>(std::min(processors.size(), files.size()))));
+    summary.Set("totalTimeMs", Napi::Number::New(env, elapsed));
+
+    files.clear();
+    running = false;
+
+    std::unique_ptr<Napi::Promise::Deferred> pending = std::move(deferred);
+    if (callbackError.empty())
+    {
+        pending->Resolve(summary);
+    }
+    else
+    {
+        Napi::Error error = Napi::Error::New(env, callbackError);
+        error.Set("summary", summary);
+        pending->Reject(error.Value());
+    }
+    self.Reset();
+}
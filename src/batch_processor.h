@@ -0,0 +1,84 @@
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include <napi.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "libraw.h"
+
+// Decodes many RAW files on a native thread pool. Every worker thread owns
+// one LibRaw processor and a deque of file indices; a worker that runs out of
+// files steals from the back of another worker's deque, so a few slow files
+// cannot leave the other cores idle. Each finished file is streamed back to
+// JS through a ThreadSafeFunction as soon as it is decoded; the worker waits
+// until the callback has returned, or until the Promise it returned has
+// settled, so a slow consumer holds back further decodes.
+class BatchProcessor : public Napi::ObjectWrap<BatchProcessor>
+{
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    BatchProcessor(const Napi::CallbackInfo &info);
+    ~BatchProcessor();
+
+private:
+    static Napi::FunctionReference constructor;
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    struct Delivery;
+
+    struct FileResult
+    {
+        size_t index = 0;
+        std::string file;
+        std::string error;
+        libraw_processed_image_t *image = nullptr;
+        double timeMs = 0;
+        ~FileResult();
+    };
+
+    Napi::Value Run(const Napi::CallbackInfo &info);
+    Napi::Value Cancel(const Napi::CallbackInfo &info);
+    Napi::Value IsRunning(const Napi::CallbackInfo &info);
+    Napi::Value GetThreadCount(const Napi::CallbackInfo &info);
+
+    void DistributeWork();
+    bool NextItem(size_t worker, size_t &index);
+    void WorkerLoop(size_t worker, int teamSize);
+    bool DecodeFile(LibRaw *processor, FileResult *result);
+    void Finish(Napi::Env env);
+
+    // One processor per worker thread, reused across runs
+    std::vector<std::unique_ptr<LibRaw>> processors;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    // State of the current run; only valid while running is true
+    std::vector<std::string> files;
+    Napi::ThreadSafeFunction tsfn;
+    std::unique_ptr<Napi::Promise::Deferred> deferred;
+    Napi::ObjectReference self;
+    std::atomic<bool> cancelled;
+    std::atomic<size_t> succeeded;
+    std::atomic<size_t> failed;
+    // First error thrown or rejected by the callback; it cancels the run,
+    // which then rejects with it
+    std::mutex callbackErrorMutex;
+    std::string callbackError;
+    // OpenMP team size per decode; 0 splits the cores evenly across workers
+    int threadsPerFile;
+    std::chrono::steady_clock::time_point startTime;
+    bool running;
+};
+
+#endif // BATCH_PROCESSOR_H
@@ -0,0 +1,156 @@
+#include "jpeg_encoder.h"
+
+#ifdef LIBRAW_ADDON_JPEG
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <jpeglib.h>
+
+namespace
+{
+    // libjpeg reports fatal errors through error_exit, which must not
+    // return; jump back to the setjmp() of the libjpeg call that failed.
+    // Every setjmp() below sits in a frame without destructors to skip.
+    struct ErrorManager
+    {
+        jpeg_error_mgr pub;
+        jmp_buf jump;
+        char message[JMSG_LENGTH_MAX];
+        bool failed;
+    };
+
+    void ErrorExit(j_common_ptr cinfo)
+    {
+        ErrorManager *err = reinterpret_cast<ErrorManager *>(cinfo->err);
+        (*cinfo->err->format_message)(cinfo, err->message);
+        err->failed = true;
+        longjmp(err->jump, 1);
+    }
+
+    struct Encoder
+    {
+        jpeg_compress_struct cinfo;
+        ErrorManager err;
+    };
+
+    bool CreateCompress(Encoder &enc)
+    {
+        if (setjmp(enc.err.jump))
+            return false;
+        jpeg_create_compress(&enc.cinfo);
+        return true;
+    }
+
+    bool StartCompress(Encoder &enc, const JpegEncodeOptions &options, int width, int height, int colors,
+                       unsigned char **data, unsigned long *size)
+    {
+        if (setjmp(enc.err.jump))
+            return false;
+
+        jpeg_mem_dest(&enc.cinfo, data, size);
+        enc.cinfo.image_width = width;
+        enc.cinfo.image_height = height;
+        enc.cinfo.input_components = colors;
+        enc.cinfo.in_color_space = colors == 1 ? JCS_GRAYSCALE : JCS_RGB;
+        jpeg_set_defaults(&enc.cinfo);
+        jpeg_set_quality(&enc.cinfo, options.quality, TRUE);
+        if (colors == 3)
+        {
+            enc.cinfo.comp_info[0].h_samp_factor = options.hSamp;
+            enc.cinfo.comp_info[0].v_samp_factor = options.vSamp;
+        }
+        enc.cinfo.optimize_coding = options.optimizeCoding ? TRUE : FALSE;
+        if (options.progressive)
+            jpeg_simple_progression(&enc.cinfo);
+        jpeg_start_compress(&enc.cinfo, TRUE);
+        return true;
+    }
+
+    // mem_image_band_callback: feeds one band of rows to the compressor
+    int WriteBand(void *data, void *rows, int, int count, int stride)
+    {
+        Encoder &enc = *static_cast<Encoder *>(data);
+        if (setjmp(enc.err.jump))
+            return 1;
+
+        JSAMPROW pointers[64];
+        JSAMPLE *row = static_cast<JSAMPLE *>(rows);
+        for (int done = 0; done < count;)
+        {
+            int n = count - done < 64 ? count - done : 64;
+            for (int i = 0; i < n; i++)
+                pointers[i] = row + static_cast<size_t>(done + i) * stride;
+            JDIMENSION written = jpeg_write_scanlines(&enc.cinfo, pointers, n);
+            if (!written)
+                return 1;
+            done += written;
+        }
+        return 0;
+    }
+
+    bool FinishCompress(Encoder &enc)
+    {
+        if (setjmp(enc.err.jump))
+            return false;
+        jpeg_finish_compress(&enc.cinfo);
+        return true;
+    }
+}
+
+bool EncodeProcessedJPEG(LibRaw *processor, const JpegEncodeOptions &options, JpegEncodeResult &result,
+                         std::string &error)
+{
+    libraw_output_params_t &params = processor->imgdata.params;
+    int savedBps = params.output_bps;
+    params.output_bps = 8;
+
+    int width, height, colors, bps;
+    processor->get_mem_image_format(&width, &height, &colors, &bps);
+    if (colors != 1 && colors != 3)
+    {
+        params.output_bps = savedBps;
+        error = "JPEG output needs a 1- or 3-color image, got " + std::to_string(colors) + " colors";
+        return false;
+    }
+
+    Encoder *enc = new Encoder();
+    enc->cinfo.err = jpeg_std_error(&enc->err.pub);
+    enc->err.pub.error_exit = ErrorExit;
+    enc->err.failed = false;
+
+    unsigned char *data = nullptr;
+    unsigned long size = 0;
+    int ret = LIBRAW_SUCCESS;
+    bool ok = CreateCompress(*enc) && StartCompress(*enc, options, width, height, colors, &data, &size);
+    if (ok)
+    {
+        // 16 rows is one MCU row at 4:2:0, so bands never split an MCU
+        ret = processor->copy_mem_image_bands(16, 0, WriteBand, enc);
+        ok = ret == LIBRAW_SUCCESS && !enc->err.failed && FinishCompress(*enc);
+    }
+    params.output_bps = savedBps;
+
+    if (!ok)
+    {
+        if (enc->err.failed)
+            error = std::string("JPEG encoding failed: ") + enc->err.message;
+        else
+            error = std::string("Failed to convert image for JPEG: ") + libraw_strerror(ret);
+        jpeg_destroy_compress(&enc->cinfo);
+        delete enc;
+        free(data);
+        return false;
+    }
+
+    jpeg_destroy_compress(&enc->cinfo);
+    delete enc;
+    result.data = data;
+    result.size = size;
+    result.width = width;
+    result.height = height;
+    result.colors = colors;
+    return true;
+}
+
+#endif // LIBRAW_ADDON_JPEG
@@ -0,0 +1,41 @@
+#ifndef JPEG_ENCODER_H
+#define JPEG_ENCODER_H
+
+// Native JPEG encoding of LibRaw's processed image, available when the addon
+// is built against libjpeg(-turbo): LIBRAW_JPEG=1 npm run build
+#ifdef LIBRAW_ADDON_JPEG
+
+#include <string>
+#include "libraw.h"
+
+struct JpegEncodeOptions
+{
+    int quality = 85;
+    bool progressive = false;
+    bool optimizeCoding = false;
+    // Chroma sampling factors of the first component: 2x2 is 4:2:0,
+    // 2x1 is 4:2:2, 1x1 is 4:4:4
+    int hSamp = 2;
+    int vSamp = 2;
+};
+
+struct JpegEncodeResult
+{
+    // malloc()ed by libjpeg's memory destination; release with free()
+    unsigned char *data = nullptr;
+    unsigned long size = 0;
+    int width = 0;
+    int height = 0;
+    int colors = 0;
+};
+
+// Encodes the processed image straight from imgdata.image: rows go through
+// the output curve into a small band buffer (copy_mem_image_bands) and from
+// there into the compressor, so no full-size RGB copy is made. Always 8-bit,
+// whatever output_bps is set to. Needs dcraw_process() to have run.
+bool EncodeProcessedJPEG(LibRaw *processor, const JpegEncodeOptions &options, JpegEncodeResult &result,
+                         std::string &error);
+
+#endif // LIBRAW_ADDON_JPEG
+
+#endif // JPEG_ENCODER_H
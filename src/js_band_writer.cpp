@@ -0,0 +1,80 @@
+#include "js_band_writer.h"
+
+// Anything but an explicit false asks for the next band
+static bool WantsMore(Napi::Value value)
+{
+    return !(value.IsBoolean() && !value.As<Napi::Boolean>().Value());
+}
+
+// One band in flight: onBand(buffer, info)
+struct JSBandWriter::Band : public JSBlockingCall
+{
+    JSBandWriter *writer = nullptr;
+    const uint8_t *rows = nullptr;
+    int firstRow = 0;
+    int count = 0;
+    int stride = 0;
+    bool proceed = false;
+
+    Band() : JSBlockingCall("onBand()") {}
+
+    std::vector<napi_value> Arguments(Napi::Env env) override
+    {
+        Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::Copy(
+            env, rows, static_cast<size_t>(count) * stride);
+        Napi::Object info = Napi::Object::New(env);
+        info.Set("width", Napi::Number::New(env, writer->width));
+        info.Set("height", Napi::Number::New(env, writer->height));
+        info.Set("colors", Napi::Number::New(env, writer->colors));
+        info.Set("bits", Napi::Number::New(env, writer->bits));
+        info.Set("firstRow", Napi::Number::New(env, firstRow));
+        info.Set("rows", Napi::Number::New(env, count));
+        return {buffer, info};
+    }
+
+    void Resolve(Napi::Value value) override
+    {
+        proceed = WantsMore(value);
+    }
+};
+
+JSBandWriter::JSBandWriter(Napi::Env env, Napi::Function onBand)
+{
+    tsfn = Napi::ThreadSafeFunction::New(env, onBand, "LibRaw.imageBands", 0, 1);
+}
+
+JSBandWriter::~JSBandWriter()
+{
+    tsfn.Release();
+}
+
+int JSBandWriter::Write(void *data, void *rows, int firstRow, int count, int stride)
+{
+    JSBandWriter *writer = static_cast<JSBandWriter *>(data);
+
+    Band band;
+    band.writer = writer;
+    band.rows = static_cast<const uint8_t *>(rows);
+    band.firstRow = firstRow;
+    band.count = count;
+    band.stride = stride;
+    std::string message;
+    if (!band.Run(writer->tsfn))
+        message = "Band callback is gone";
+    else
+        message = band.error;
+    if (!message.empty())
+    {
+        std::lock_guard<std::mutex> lock(writer->errorMutex);
+        if (writer->error.empty())
+            writer->error = message;
+        return 1;
+    }
+    return band.proceed ? 0 : 1;
+}
+
+std::string JSBandWriter::Error()
+{
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return error;
+}
@@ -0,0 +1,43 @@
+#ifndef JS_BAND_WRITER_H
+#define JS_BAND_WRITER_H
+
+#include <napi.h>
+#include <mutex>
+#include <string>
+#include "libraw.h"
+#include "js_blocking_call.h"
+
+// Hands the rows LibRaw::copy_mem_image_bands() produces to a JavaScript
+// callback, onBand(buffer, info), through a ThreadSafeFunction. Each band is
+// copied into its own Buffer; the converting thread waits until the
+// callback's result has settled before it converts the next band, so a slow
+// consumer holds back the conversion instead of queueing up copies. That
+// thread must not be a libuv pool thread (see LibRawAsyncWorker::Start). The
+// callback may return (a Promise of) false to stop.
+class JSBandWriter
+{
+public:
+    JSBandWriter(Napi::Env env, Napi::Function onBand);
+    ~JSBandWriter();
+
+    // mem_image_band_callback; data is the JSBandWriter
+    static int Write(void *data, void *rows, int firstRow, int count, int stride);
+
+    // Output geometry passed along with every band
+    int width = 0;
+    int height = 0;
+    int colors = 0;
+    int bits = 0;
+
+    // First error thrown or rejected by the callback, empty if none
+    std::string Error();
+
+private:
+    struct Band;
+
+    Napi::ThreadSafeFunction tsfn;
+    std::mutex errorMutex;
+    std::string error;
+};
+
+#endif // JS_BAND_WRITER_H
@@ -0,0 +1,67 @@
+#include "js_blocking_call.h"
+
+static std::string RejectionMessage(Napi::Value reason, const char *what)
+{
+    if (reason.IsObject())
+    {
+        Napi::Value message = reason.As<Napi::Object>().Get("message");
+        if (message.IsString())
+            return message.As<Napi::String>().Utf8Value();
+    }
+    if (reason.IsString())
+        return reason.As<Napi::String>().Utf8Value();
+    return std::string(what) + " was rejected";
+}
+
+bool JSBlockingCall::Run(const Napi::ThreadSafeFunction &tsfn)
+{
+    if (tsfn.BlockingCall(this, Call) != napi_ok)
+        return false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    settled.wait(lock, [this]
+                 { return done; });
+    return true;
+}
+
+void JSBlockingCall::Settle(const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error.empty())
+        error = message;
+    done = true;
+    settled.notify_one();
+}
+
+void JSBlockingCall::Call(Napi::Env env, Napi::Function fn, JSBlockingCall *call)
+{
+    if (env == nullptr || fn == nullptr)
+    {
+        call->Settle(std::string(call->what) + " is gone");
+        return;
+    }
+
+    Napi::Value result = fn.Call(call->Arguments(env));
+    if (env.IsExceptionPending())
+    {
+        Napi::Error error = env.GetAndClearPendingException();
+        call->Settle(error.Message());
+        return;
+    }
+
+    if (!result.IsPromise())
+    {
+        call->Resolve(result);
+        call->Settle("");
+        return;
+    }
+
+    Napi::Object promise = result.As<Napi::Object>();
+    Napi::Function onFulfilled = Napi::Function::New(env, [call](const Napi::CallbackInfo &info)
+                                                     {
+        call->Resolve(info[0]);
+        call->Settle(""); });
+    Napi::Function onRejected = Napi::Function::New(env, [call](const Napi::CallbackInfo &info)
+                                                    { call->Settle(RejectionMessage(info[0], call->what)); });
+    promise.Get("then").As<Napi::Function>().Call(promise, {onFulfilled, onRejected});
+}
@@ -0,0 +1,44 @@
+#ifndef JS_BLOCKING_CALL_H
+#define JS_BLOCKING_CALL_H
+
+#include <napi.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One call into JavaScript made from a worker thread through a
+// ThreadSafeFunction. Run() blocks the worker until the JS thread has called
+// the function and its result, or the Promise it returned, has settled; the
+// object lives on the worker's stack meanwhile. Subclasses supply the
+// arguments and take the fulfilled value, both on the JS thread.
+class JSBlockingCall
+{
+public:
+    // `what` names the function in error messages, e.g. "read()"
+    explicit JSBlockingCall(const char *what) : what(what) {}
+    virtual ~JSBlockingCall() {}
+
+    // Returns false without calling anything if the function is gone
+    bool Run(const Napi::ThreadSafeFunction &tsfn);
+
+    // Set when the call threw, its Promise rejected or Resolve() refused the
+    // value; empty otherwise
+    std::string error;
+
+protected:
+    virtual std::vector<napi_value> Arguments(Napi::Env env) = 0;
+    virtual void Resolve(Napi::Value value) = 0;
+
+    const char *what;
+
+private:
+    static void Call(Napi::Env env, Napi::Function fn, JSBlockingCall *call);
+    void Settle(const std::string &message);
+
+    std::mutex mutex;
+    std::condition_variable settled;
+    bool done = false;
+};
+
+#endif // JS_BLOCKING_CALL_H
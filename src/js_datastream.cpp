@@ -0,0 +1,182 @@
+#include "js_datastream.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// Copies a fulfilled read into the waiting worker's buffer
+static void CompleteRead(Napi::Value value, void *dest, size_t length, size_t &got, std::string &error)
+{
+    const uint8_t *data = nullptr;
+    size_t available = 0;
+    if (value.IsTypedArray() && value.As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array)
+    {
+        Napi::Uint8Array array = value.As<Napi::Uint8Array>();
+        data = array.Data();
+        available = array.ByteLength();
+    }
+    else if (value.IsArrayBuffer())
+    {
+        Napi::ArrayBuffer array = value.As<Napi::ArrayBuffer>();
+        data = static_cast<const uint8_t *>(array.Data());
+        available = array.ByteLength();
+    }
+    else
+    {
+        got = 0;
+        error = "read() must return a Buffer, Uint8Array or ArrayBuffer";
+        return;
+    }
+    got = std::min(available, length);
+    if (got)
+        memcpy(dest, data, got);
+}
+
+// One outstanding read(offset, length)
+struct JSRangeDatastream::Request : public JSBlockingCall
+{
+    INT64 offset = 0;
+    size_t length = 0;
+    void *dest = nullptr;
+    size_t got = 0;
+
+    Request() : JSBlockingCall("read()") {}
+
+    std::vector<napi_value> Arguments(Napi::Env env) override
+    {
+        return {Napi::Number::New(env, static_cast<double>(offset)),
+                Napi::Number::New(env, static_cast<double>(length))};
+    }
+
+    void Resolve(Napi::Value value) override
+    {
+        CompleteRead(value, dest, length, got, error);
+    }
+};
+
+JSRangeDatastream::JSRangeDatastream(Napi::Env env, Napi::Function reader, INT64 size)
+    : jsThread(std::this_thread::get_id()), fileSize(size), pos(0)
+{
+    tsfn = Napi::ThreadSafeFunction::New(env, reader, "LibRaw.datastream", 0, 1);
+    // A loaded image must not keep the process alive
+    tsfn.Unref(env);
+}
+
+JSRangeDatastream::~JSRangeDatastream()
+{
+    tsfn.Release();
+}
+
+size_t JSRangeDatastream::Fetch(void *dest, INT64 offset, size_t length)
+{
+    if (std::this_thread::get_id() == jsThread)
+    {
+        SetError("Datastream sources can only be read by asynchronous operations");
+        return 0;
+    }
+    // Once a read has failed, LibRaw's view of the file is unreliable
+    if (!Error().empty())
+        return 0;
+
+    Request request;
+    request.offset = offset;
+    request.length = length;
+    request.dest = dest;
+    if (!request.Run(tsfn))
+    {
+        SetError("Datastream reader is gone");
+        return 0;
+    }
+    if (!request.error.empty())
+        SetError(request.error);
+    return request.got;
+}
+
+void JSRangeDatastream::SetError(const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (error.empty())
+        error = message;
+}
+
+std::string JSRangeDatastream::Error()
+{
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return error;
+}
+
+int JSRangeDatastream::read(void *ptr, size_t sz, size_t nmemb)
+{
+    if (!sz || pos >= fileSize)
+        return 0;
+    size_t want = std::min(sz * nmemb, static_cast<size_t>(fileSize - pos));
+    size_t got = Fetch(ptr, pos, want);
+    pos += static_cast<INT64>(got);
+    return static_cast<int>(got / sz);
+}
+
+int JSRangeDatastream::seek(INT64 o, int whence)
+{
+    INT64 target;
+    switch (whence)
+    {
+    case SEEK_SET:
+        target = o;
+        break;
+    case SEEK_CUR:
+        target = pos + o;
+        break;
+    case SEEK_END:
+        target = fileSize + o;
+        break;
+    default:
+        return -1;
+    }
+    if (target < 0)
+        return -1;
+    pos = target;
+    return 0;
+}
+
+int JSRangeDatastream::get_char()
+{
+    unsigned char c;
+    return read(&c, 1, 1) == 1 ? c : -1;
+}
+
+char *JSRangeDatastream::gets(char *str, int sz)
+{
+    if (sz < 1)
+        return nullptr;
+    int i = 0;
+    while (i < sz - 1)
+    {
+        int c = get_char();
+        if (c < 0)
+            break;
+        str[i++] = static_cast<char>(c);
+        if (c == '\n')
+            break;
+    }
+    if (!i)
+        return nullptr;
+    str[i] = 0;
+    return str;
+}
+
+int JSRangeDatastream::scanf_one(const char *fmt, void *val)
+{
+    char buf[33];
+    INT64 start = pos;
+    int got = read(buf, 1, sizeof(buf) - 1);
+    pos = start;
+    if (got <= 0)
+        return -1;
+    buf[got] = 0;
+
+    std::string format = std::string(fmt) + "%n";
+    int consumed = 0;
+    int result = sscanf(buf, format.c_str(), val, &consumed);
+    if (result > 0)
+        pos += consumed;
+    return result;
+}
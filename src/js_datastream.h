@@ -0,0 +1,58 @@
+#ifndef JS_DATASTREAM_H
+#define JS_DATASTREAM_H
+
+#include <napi.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "libraw.h"
+#include "js_blocking_call.h"
+
+// LibRaw datastream over a JavaScript range reader, read(offset, length),
+// which returns (a Promise of) a Buffer, Uint8Array or ArrayBuffer holding up
+// to `length` bytes at `offset`. Reads are forwarded through a
+// ThreadSafeFunction and block the calling thread until the JS thread has
+// settled them, so the stream may only be read from async operations that
+// run on a thread of their own (LibRawAsyncWorker::Start): the reader may
+// need the libuv pool itself. Reads on the JS thread fail instead of
+// deadlocking.
+//
+// Every read is a round trip to JS: put a LibRaw_prefetch_datastream in front
+// of it so LibRaw's small reads are served from cached blocks.
+class JSRangeDatastream : public LibRaw_abstract_datastream
+{
+public:
+    JSRangeDatastream(Napi::Env env, Napi::Function reader, INT64 size);
+    virtual ~JSRangeDatastream();
+
+    virtual int valid() { return 1; }
+    virtual int read(void *ptr, size_t size, size_t nmemb);
+    virtual int seek(INT64 o, int whence);
+    virtual INT64 tell() { return pos; }
+    virtual INT64 size() { return fileSize; }
+    virtual int get_char();
+    virtual char *gets(char *str, int sz);
+    virtual int scanf_one(const char *fmt, void *val);
+    virtual int eof() { return pos >= fileSize; }
+#ifdef LIBRAW_OLD_VIDEO_SUPPORT
+    virtual void *make_jas_stream() { return nullptr; }
+#endif
+
+    // First error reported by the reader (rejection, exception or bad
+    // result), empty if none; reads after an error return short
+    std::string Error();
+
+private:
+    struct Request;
+    size_t Fetch(void *dest, INT64 offset, size_t length);
+    void SetError(const std::string &message);
+
+    Napi::ThreadSafeFunction tsfn;
+    std::thread::id jsThread;
+    INT64 fileSize;
+    INT64 pos;
+    std::mutex errorMutex;
+    std::string error;
+};
+
+#endif // JS_DATASTREAM_H
@@ -0,0 +1,109 @@
+#include "libraw_async.h"
+#include "libraw_wrapper.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+
+// Captured on the loading thread, before any limit has been applied
+static const int defaultTeamSize = omp_get_max_threads();
+#endif
+
+int OpenMPTeamSize(int threads)
+{
+#ifdef _OPENMP
+    return threads > 0 ? threads : defaultTeamSize;
+#else
+    (void)threads;
+    return 1;
+#endif
+}
+
+int LimitOpenMPThreads(int threads)
+{
+    int team = OpenMPTeamSize(threads);
+#ifdef _OPENMP
+    omp_set_num_threads(team);
+#endif
+    return team;
+}
+
+LibRawAsyncWorker::LibRawAsyncWorker(Napi::Env env, LibRawWrapper *wrapper, const char *resourceName, Task task, Resolver resolver)
+    : Napi::AsyncWorker(env, resourceName), waitsOnJS(false), wrapper(wrapper), deferred(Napi::Promise::Deferred::New(env)), task(std::move(task)), resolver(std::move(resolver))
+{
+    // Keep the owning JS object (and therefore the LibRaw instance) alive
+    // until the worker has finished.
+    receiver = Napi::Persistent(wrapper->Value());
+}
+
+void LibRawAsyncWorker::Execute()
+{
+    LimitOpenMPThreads(wrapper->ompThreads);
+
+    std::string error;
+    if (!task(error))
+    {
+        SetError(error);
+    }
+}
+
+void LibRawAsyncWorker::Start(bool ownThread)
+{
+    if (!ownThread)
+    {
+        Queue();
+        return;
+    }
+
+    threadFailed = false;
+    threadDone = Napi::ThreadSafeFunction::New(Env(), Napi::Function(), "LibRaw.ownThread", 0, 1);
+    thread = std::thread([this]
+                         {
+        LimitOpenMPThreads(wrapper->ompThreads);
+        threadFailed = !task(threadError);
+        // Fails only while the environment shuts down; the worker is then
+        // left to the process exit
+        threadDone.BlockingCall(this, OnThreadDone);
+        threadDone.Release(); });
+}
+
+// Runs on the JS thread once an own-thread task has finished, where the pool
+// path would call OnWorkComplete()
+void LibRawAsyncWorker::OnThreadDone(Napi::Env env, Napi::Function, LibRawAsyncWorker *worker)
+{
+    worker->thread.join();
+    if (env == nullptr)
+        return;
+
+    if (worker->threadFailed)
+    {
+        worker->OnError(Napi::Error::New(env, worker->threadError));
+    }
+    else
+    {
+        worker->OnOK();
+    }
+    delete worker;
+}
+
+void LibRawAsyncWorker::OnOK()
+{
+    Napi::Env env = Env();
+    Napi::Value result = resolver ? resolver(env) : Napi::Boolean::New(env, true);
+
+    if (env.IsExceptionPending())
+    {
+        deferred.Reject(env.GetAndClearPendingException().Value());
+    }
+    else
+    {
+        deferred.Resolve(result);
+    }
+
+    wrapper->AsyncCompleted();
+}
+
+void LibRawAsyncWorker::OnError(const Napi::Error &error)
+{
+    deferred.Reject(error.Value());
+    wrapper->AsyncCompleted();
+}
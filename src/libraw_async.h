@@ -0,0 +1,65 @@
+#ifndef LIBRAW_ASYNC_H
+#define LIBRAW_ASYNC_H
+
+#include <napi.h>
+#include <functional>
+#include <string>
+#include <thread>
+
+class LibRawWrapper;
+
+// Runs a LibRaw operation on a libuv worker thread (or a thread of its own,
+// see Start) and settles a Promise with the result. Workers belonging to the same LibRawWrapper are executed one at
+// a time in FIFO order (see LibRawWrapper::QueueAsync), so a task has
+// exclusive access to the wrapper's processor while it runs.
+class LibRawAsyncWorker : public Napi::AsyncWorker
+{
+public:
+    // Executed on the worker thread. Returns false and fills `error` on failure.
+    using Task = std::function<bool(std::string &error)>;
+    // Executed on the JS thread after a successful task to build the resolved value.
+    using Resolver = std::function<Napi::Value(Napi::Env env)>;
+
+    LibRawAsyncWorker(Napi::Env env, LibRawWrapper *wrapper, const char *resourceName, Task task, Resolver resolver);
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+    // Starts the task on the libuv thread pool, or with ownThread on a thread
+    // of its own that settles the Promise through a thread-safe function.
+    // Tasks that wait on JavaScript need their own thread: the JS side of the
+    // wait may itself need the pool (fs.promises, zlib, dns), and enough
+    // waiting tasks would occupy every pool thread until nothing completes.
+    void Start(bool ownThread);
+
+    // The task waits on JavaScript by itself (see LibRawWrapper::StartAsync)
+    bool waitsOnJS;
+
+protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error &error) override;
+
+private:
+    static void OnThreadDone(Napi::Env env, Napi::Function, LibRawAsyncWorker *worker);
+
+    LibRawWrapper *wrapper;
+    Napi::ObjectReference receiver;
+    Napi::Promise::Deferred deferred;
+    Task task;
+    Resolver resolver;
+    // Own-thread execution (Start(true)); the pool path uses Execute()
+    std::thread thread;
+    Napi::ThreadSafeFunction threadDone;
+    bool threadFailed;
+    std::string threadError;
+};
+
+// Bounds the OpenMP team used by LibRaw's parallel loops started from the
+// calling thread; 0 restores the process default (OMP_NUM_THREADS or the core
+// count). Worker threads are shared, so the limit is set before every task.
+// Returns the resulting team size, which is always 1 without OpenMP.
+int LimitOpenMPThreads(int threads);
+// Team size LimitOpenMPThreads(threads) would apply, without applying it
+int OpenMPTeamSize(int threads);
+
+#endif // LIBRAW_ASYNC_H
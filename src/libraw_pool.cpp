@@ -0,0 +1,105 @@
+#include "libraw_pool.h"
+#include <algorithm>
+#include <thread>
+
+LibRawPool &LibRawPool::Instance()
+{
+    static LibRawPool pool;
+    return pool;
+}
+
+LibRawPool::LibRawPool()
+    : maxIdle(std::max(4u, 2 * std::thread::hardware_concurrency())), created(0), reused(0), discarded(0)
+{
+    // Capture the constructor defaults once; none of them point into the
+    // instance, so they can be copied onto any other processor.
+    std::unique_ptr<LibRaw> pristine = std::make_unique<LibRaw>();
+    defaultParams = pristine->imgdata.params;
+    defaultRawParams = pristine->imgdata.rawparams;
+    idle.push_back(std::move(pristine));
+    created++;
+}
+
+std::unique_ptr<LibRaw> LibRawPool::Acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty())
+        {
+            std::unique_ptr<LibRaw> processor = std::move(idle.back());
+            idle.pop_back();
+            reused++;
+            return processor;
+        }
+        created++;
+    }
+
+    return std::make_unique<LibRaw>();
+}
+
+void LibRawPool::Release(std::unique_ptr<LibRaw> processor)
+{
+    if (!processor)
+        return;
+
+    // Done outside the lock: recycle() frees the decoded image buffers
+    processor->recycle();
+    processor->clearCancelFlag();
+    processor->imgdata.params = defaultParams;
+    processor->imgdata.rawparams = defaultRawParams;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (idle.size() < maxIdle)
+    {
+        idle.push_back(std::move(processor));
+    }
+    else
+    {
+        discarded++;
+    }
+}
+
+void LibRawPool::SetMaxIdle(size_t value)
+{
+    std::vector<std::unique_ptr<LibRaw>> surplus;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxIdle = value;
+        while (idle.size() > maxIdle)
+        {
+            surplus.push_back(std::move(idle.back()));
+            idle.pop_back();
+            discarded++;
+        }
+    }
+    // surplus processors are destroyed here, outside the lock
+}
+
+size_t LibRawPool::Prewarm(size_t count)
+{
+    size_t missing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        count = std::min(count, maxIdle);
+        missing = count > idle.size() ? count - idle.size() : 0;
+    }
+
+    for (size_t i = 0; i < missing; i++)
+    {
+        std::unique_ptr<LibRaw> processor = std::make_unique<LibRaw>();
+        std::lock_guard<std::mutex> lock(mutex);
+        created++;
+        if (idle.size() >= maxIdle)
+            break;
+        idle.push_back(std::move(processor));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
+
+LibRawPool::Stats LibRawPool::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return Stats{idle.size(), maxIdle, created, reused, discarded};
+}
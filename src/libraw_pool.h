@@ -0,0 +1,56 @@
+#ifndef LIBRAW_POOL_H
+#define LIBRAW_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "libraw.h"
+
+// Process-wide cache of constructed LibRaw processors. Constructing LibRaw
+// allocates its memory manager table and several large internal structures,
+// so LibRawWrapper and BatchProcessor borrow processors from here instead of
+// creating one per file. Returned processors are recycled and have their
+// processing parameters reset, so a borrower always sees a fresh instance.
+// At most maxIdle processors are kept; extra ones are destroyed on release.
+// Safe to use from any thread.
+class LibRawPool
+{
+public:
+    struct Stats
+    {
+        size_t idle;
+        size_t maxIdle;
+        size_t created;
+        size_t reused;
+        size_t discarded;
+    };
+
+    static LibRawPool &Instance();
+
+    std::unique_ptr<LibRaw> Acquire();
+    void Release(std::unique_ptr<LibRaw> processor);
+
+    // Shrinks the idle list immediately if it holds more than maxIdle
+    void SetMaxIdle(size_t maxIdle);
+    // Constructs processors until count are idle (bounded by maxIdle)
+    size_t Prewarm(size_t count);
+    Stats GetStats();
+
+private:
+    LibRawPool();
+    LibRawPool(const LibRawPool &) = delete;
+    LibRawPool &operator=(const LibRawPool &) = delete;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<LibRaw>> idle;
+    size_t maxIdle;
+    size_t created;
+    size_t reused;
+    size_t discarded;
+
+    // Parameters of a freshly constructed LibRaw, restored on release
+    libraw_output_params_t defaultParams;
+    libraw_raw_unpack_params_t defaultRawParams;
+};
+
+#endif // LIBRAW_POOL_H
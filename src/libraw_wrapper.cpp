@@ -1,4 +1,8 @@
 #include "libraw_wrapper.h"
+#include "js_datastream.h"
+#include "js_band_writer.h"
+#include "jpeg_encoder.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -10,7 +14,11 @@ Napi::Object LibRawWrapper::Init(Napi::Env env, Napi::Object exports)
     Napi::HandleScope scope(env);
 
     Napi::Function func = DefineClass(env, "LibRawWrapper", {// File Operations
-                                                             InstanceMethod("loadFile", &LibRawWrapper::LoadFile), InstanceMethod("loadBuffer", &LibRawWrapper::LoadBuffer), InstanceMethod("close", &LibRawWrapper::Close),
+                                                             InstanceMethod("loadFile", &LibRawWrapper::LoadFile), InstanceMethod("loadBuffer", &LibRawWrapper::LoadBuffer), InstanceMethod("close", &LibRawWrapper::Close), InstanceMethod("getReadStats", &LibRawWrapper::GetReadStats),
+
+                                                             // Asynchronous Operations
+                                                             InstanceMethod("loadFileAsync", &LibRawWrapper::LoadFileAsync), InstanceMethod("loadBufferAsync", &LibRawWrapper::LoadBufferAsync), InstanceMethod("loadStreamAsync", &LibRawWrapper::LoadStreamAsync), InstanceMethod("unpackAsync", &LibRawWrapper::UnpackAsync), InstanceMethod("unpackThumbnailAsync", &LibRawWrapper::UnpackThumbnailAsync), InstanceMethod("processImageAsync", &LibRawWrapper::ProcessImageAsync), InstanceMethod("raw2ImageAsync", &LibRawWrapper::Raw2ImageAsync), InstanceMethod("raw2ImageExAsync", &LibRawWrapper::Raw2ImageExAsync),
+                                                             InstanceMethod("createMemoryImageAsync", &LibRawWrapper::CreateMemoryImageAsync), InstanceMethod("streamImageAsync", &LibRawWrapper::StreamImageAsync), InstanceMethod("encodeJPEGAsync", &LibRawWrapper::EncodeJPEGAsync), InstanceMethod("processPreviewAsync", &LibRawWrapper::ProcessPreviewAsync), InstanceMethod("processRegionAsync", &LibRawWrapper::ProcessRegionAsync), InstanceMethod("createMemoryThumbnailAsync", &LibRawWrapper::CreateMemoryThumbnailAsync), InstanceMethod("writePPMAsync", &LibRawWrapper::WritePPMAsync), InstanceMethod("writeTIFFAsync", &LibRawWrapper::WriteTIFFAsync), InstanceMethod("writeThumbnailAsync", &LibRawWrapper::WriteThumbnailAsync),
 
                                                              // Error Handling
                                                              InstanceMethod("getLastError", &LibRawWrapper::GetLastError), InstanceMethod("strerror", &LibRawWrapper::Strerror),
@@ -45,6 +53,9 @@ Napi::Object LibRawWrapper::Init(Napi::Env env, Napi::Object exports)
                                                              // Color Operations
                                                              InstanceMethod("getColorAt", &LibRawWrapper::GetColorAt),
 
+                                                             // Threading
+                                                             InstanceMethod("setThreads", &LibRawWrapper::SetThreads),
+
                                                              // Cancellation Support
                                                              InstanceMethod("setCancelFlag", &LibRawWrapper::SetCancelFlag), InstanceMethod("clearCancelFlag", &LibRawWrapper::ClearCancelFlag),
 
@@ -52,22 +63,27 @@ Napi::Object LibRawWrapper::Init(Napi::Env env, Napi::Object exports)
                                                              InstanceMethod("version", &LibRawWrapper::Version), InstanceMethod("versionNumber", &LibRawWrapper::VersionNumber),
 
                                                              // Static Methods
-                                                             StaticMethod("getVersion", &LibRawWrapper::GetVersion), StaticMethod("getCapabilities", &LibRawWrapper::GetCapabilities), StaticMethod("getCameraList", &LibRawWrapper::GetCameraList), StaticMethod("getCameraCount", &LibRawWrapper::GetCameraCount)});
+                                                             StaticMethod("getVersion", &LibRawWrapper::GetVersion), StaticMethod("getCapabilities", &LibRawWrapper::GetCapabilities), StaticMethod("getCameraList", &LibRawWrapper::GetCameraList), StaticMethod("getCameraCount", &LibRawWrapper::GetCameraCount), StaticMethod("configurePool", &LibRawWrapper::ConfigurePool), StaticMethod("getPoolStats", &LibRawWrapper::GetPoolStats), StaticMethod("extractThumbnail", &LibRawWrapper::ExtractThumbnail)});
 
     constructor = Napi::Persistent(func);
     constructor.SuppressDestruct();
 
     exports.Set("LibRawWrapper", func);
+#ifdef LIBRAW_ADDON_JPEG
+    exports.Set("nativeJPEG", Napi::Boolean::New(env, true));
+#else
+    exports.Set("nativeJPEG", Napi::Boolean::New(env, false));
+#endif
     return exports;
 }
 
 LibRawWrapper::LibRawWrapper(const Napi::CallbackInfo &info)
-    : Napi::ObjectWrap<LibRawWrapper>(info), isLoaded(false), isUnpacked(false), isProcessed(false)
+    : Napi::ObjectWrap<LibRawWrapper>(info), asyncRunning(false), ompThreads(0), streamReader(nullptr), isLoaded(false), isUnpacked(false), isProcessed(false)
 {
     Napi::Env env = info.Env();
     Napi::HandleScope scope(env);
 
-    processor = std::make_unique<LibRaw>();
+    AcquireProcessor();
     if (!processor)
     {
         Napi::TypeError::New(env, "Failed to initialize LibRaw").ThrowAsJavaScriptException();
@@ -76,14 +92,31 @@ LibRawWrapper::LibRawWrapper(const Napi::CallbackInfo &info)
 
 LibRawWrapper::~LibRawWrapper()
 {
-    if (processor && isLoaded)
+    LibRawPool::Instance().Release(std::move(processor));
+}
+
+void LibRawWrapper::AcquireProcessor()
+{
+    if (!processor)
+    {
+        processor = LibRawPool::Instance().Acquire();
+    }
+}
+
+bool LibRawWrapper::CheckIdle(Napi::Env env)
+{
+    if (asyncRunning)
     {
-        processor->recycle();
+        Napi::Error::New(env, "LibRaw instance is busy with an asynchronous operation").ThrowAsJavaScriptException();
+        return false;
     }
+    return true;
 }
 
 bool LibRawWrapper::CheckLoaded(Napi::Env env)
 {
+    if (!CheckIdle(env))
+        return false;
     if (!isLoaded)
     {
         Napi::Error::New(env, "No file loaded. Call loadFile() first.").ThrowAsJavaScriptException();
@@ -92,11 +125,137 @@ bool LibRawWrapper::CheckLoaded(Napi::Env env)
     return true;
 }
 
+// Unpacks an image that was loaded with { unpack: false } on first pixel
+// access. Called on whichever thread currently owns the processor.
+bool LibRawWrapper::EnsureUnpacked(std::string &error)
+{
+    if (isUnpacked)
+        return true;
+
+    int ret = processor->unpack();
+    if (!CheckStreamError(error, "Failed to unpack: "))
+        return false;
+    if (ret != LIBRAW_SUCCESS)
+    {
+        error = std::string("Failed to unpack: ") + libraw_strerror(ret);
+        return false;
+    }
+    isUnpacked = true;
+    return true;
+}
+
+// A loadStream() reader that failed leaves LibRaw with short reads, which
+// most decoders take for a truncated file and still report success; fail the
+// operation with the reader's error instead of handing out a damaged image.
+// The error sticks until the next load.
+bool LibRawWrapper::CheckStreamError(std::string &error, const char *what)
+{
+    if (!streamReader)
+        return true;
+    std::string readError = streamReader->Error();
+    if (readError.empty())
+        return true;
+    error = what + readError;
+    return false;
+}
+
+bool LibRawWrapper::CheckUnpacked(Napi::Env env)
+{
+    if (!CheckLoaded(env))
+        return false;
+    std::string error;
+    if (!EnsureUnpacked(error))
+    {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
 // ============== FILE OPERATIONS ==============
 
+// loadFile/loadBuffer options:
+//   mmap: true     read the file through a read-only memory mapping
+//                  (LibRaw::open_mmap), which parallel decoders share without
+//                  locking; ignored for buffers
+//   unpack: false  stop after identification, for metadata-only access; the
+//                  raw data is unpacked on first pixel access
+//   prefetch: true | bytes
+//                  read the file through LibRaw_prefetch_datastream, which
+//                  serves identify()'s scattered small reads from a few
+//                  window-sized blocks (64 KiB for true); for network and FUSE
+//                  mounts. Files only; takes precedence over mmap
+struct LoadOptions
+{
+    bool mmap = false;
+    bool unpack = true;
+    size_t prefetch = 0;
+};
+
+static const size_t kDefaultPrefetchWindow = 65536;
+
+static LoadOptions GetLoadOptions(const Napi::CallbackInfo &info)
+{
+    LoadOptions result;
+    if (info.Length() < 2 || !info[1].IsObject())
+        return result;
+    Napi::Object options = info[1].As<Napi::Object>();
+    if (options.Has("mmap") && options.Get("mmap").IsBoolean())
+        result.mmap = options.Get("mmap").As<Napi::Boolean>().Value();
+    if (options.Has("unpack") && options.Get("unpack").IsBoolean())
+        result.unpack = options.Get("unpack").As<Napi::Boolean>().Value();
+    if (options.Has("prefetch"))
+    {
+        Napi::Value prefetch = options.Get("prefetch");
+        if (prefetch.IsBoolean() && prefetch.As<Napi::Boolean>().Value())
+            result.prefetch = kDefaultPrefetchWindow;
+        else if (prefetch.IsNumber() && prefetch.As<Napi::Number>().Int64Value() > 0)
+            result.prefetch = static_cast<size_t>(prefetch.As<Napi::Number>().Int64Value());
+    }
+    return result;
+}
+
+// Opens a file the way the load options ask for. A prefetch stream is handed
+// back in `stream`: LibRaw does not own streams given to open_datastream(), so
+// it has to outlive the processor's use of it (until the next open or
+// recycle()).
+static int OpenFileSource(LibRaw *processor, const std::string &filename, const LoadOptions &options,
+                          std::unique_ptr<LibRaw_prefetch_datastream> &stream)
+{
+    if (options.prefetch)
+    {
+        stream.reset(new LibRaw_prefetch_datastream(new LibRaw_bigfile_datastream(filename.c_str()), options.prefetch));
+        return processor->open_datastream(stream.get());
+    }
+    return options.mmap ? processor->open_mmap(filename.c_str()) : processor->open_file(filename.c_str());
+}
+
+// Source memory for loadBuffer: a Buffer or any Uint8Array (including views of
+// a SharedArrayBuffer), or an ArrayBuffer
+static bool GetSourceMemory(Napi::Value value, const uint8_t *&data, size_t &length)
+{
+    if (value.IsTypedArray() && value.As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array)
+    {
+        Napi::Uint8Array array = value.As<Napi::Uint8Array>();
+        data = array.Data();
+        length = array.ByteLength();
+        return true;
+    }
+    if (value.IsArrayBuffer())
+    {
+        Napi::ArrayBuffer array = value.As<Napi::ArrayBuffer>();
+        data = static_cast<const uint8_t *>(array.Data());
+        length = array.ByteLength();
+        return true;
+    }
+    return false;
+}
+
 Napi::Value LibRawWrapper::LoadFile(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
+    if (!CheckIdle(env))
+        return env.Null();
 
     if (info.Length() < 1 || !info[0].IsString())
     {
@@ -105,7 +264,16 @@ Napi::Value LibRawWrapper::LoadFile(const Napi::CallbackInfo &info)
     }
 
     std::string filename = info[0].As<Napi::String>().Utf8Value();
-    int ret = processor->open_file(filename.c_str());
+    LoadOptions options = GetLoadOptions(info);
+    AcquireProcessor();
+    isLoaded = false;
+    isUnpacked = false;
+    isProcessed = false;
+    std::unique_ptr<LibRaw_prefetch_datastream> stream;
+    int ret = OpenFileSource(processor.get(), filename, options, stream);
+    sourceBuffer.Reset(); // the previous buffer stream is gone either way
+    sourceStream = std::move(stream);
+    streamReader = nullptr;
     if (ret != LIBRAW_SUCCESS)
     {
         std::string error = "Failed to open file: ";
@@ -114,71 +282,110 @@ Napi::Value LibRawWrapper::LoadFile(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
-    ret = processor->unpack();
-    if (ret != LIBRAW_SUCCESS)
+    if (options.unpack)
     {
-        std::string error = "Failed to unpack file: ";
-        error += libraw_strerror(ret);
-        Napi::Error::New(env, error).ThrowAsJavaScriptException();
-        return env.Null();
+        ret = processor->unpack();
+        if (ret != LIBRAW_SUCCESS)
+        {
+            std::string error = "Failed to unpack file: ";
+            error += libraw_strerror(ret);
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
     }
 
     isLoaded = true;
-    isUnpacked = true;
-    isProcessed = false;
+    isUnpacked = options.unpack;
     return Napi::Boolean::New(env, true);
 }
 
 Napi::Value LibRawWrapper::LoadBuffer(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
+    if (!CheckIdle(env))
+        return env.Null();
 
-    if (info.Length() < 1 || !info[0].IsBuffer())
+    const uint8_t *data;
+    size_t length;
+    if (info.Length() < 1 || !GetSourceMemory(info[0], data, length))
     {
-        Napi::TypeError::New(env, "Expected Buffer").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected Buffer, Uint8Array or ArrayBuffer").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
-    int ret = processor->open_buffer(buffer.Data(), buffer.Length());
+    LoadOptions options = GetLoadOptions(info);
+    AcquireProcessor();
+    isLoaded = false;
+    isUnpacked = false;
+    isProcessed = false;
+    int ret = processor->open_buffer(data, length);
+    sourceStream.reset();
+    streamReader = nullptr;
     if (ret != LIBRAW_SUCCESS)
     {
+        sourceBuffer.Reset();
         std::string error = "Failed to open buffer: ";
         error += libraw_strerror(ret);
         Napi::Error::New(env, error).ThrowAsJavaScriptException();
         return env.Null();
     }
+    // The datastream reads the caller's memory directly (unpackThumbnail()
+    // and friends seek back into it later), so keep it alive with the image
+    sourceBuffer = Napi::Persistent(info[0]);
 
-    ret = processor->unpack();
-    if (ret != LIBRAW_SUCCESS)
+    if (options.unpack)
     {
-        std::string error = "Failed to unpack buffer: ";
-        error += libraw_strerror(ret);
-        Napi::Error::New(env, error).ThrowAsJavaScriptException();
-        return env.Null();
+        ret = processor->unpack();
+        if (ret != LIBRAW_SUCCESS)
+        {
+            std::string error = "Failed to unpack buffer: ";
+            error += libraw_strerror(ret);
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
     }
 
     isLoaded = true;
-    isUnpacked = true;
-    isProcessed = false;
+    isUnpacked = options.unpack;
     return Napi::Boolean::New(env, true);
 }
 
 Napi::Value LibRawWrapper::Close(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
+    if (!CheckIdle(env))
+        return env.Null();
 
-    if (processor && isLoaded)
-    {
-        processor->recycle();
-        isLoaded = false;
-        isUnpacked = false;
-        isProcessed = false;
-    }
+    // Hand the processor back to the pool; images already returned to JS own
+    // their memory and stay valid.
+    LibRawPool::Instance().Release(std::move(processor));
+    sourceBuffer.Reset();
+    sourceStream.reset();
+    streamReader = nullptr;
+    isLoaded = false;
+    isUnpacked = false;
+    isProcessed = false;
 
     return Napi::Boolean::New(env, true);
 }
 
+// Source I/O of a file loaded with the prefetch option: how much of the file
+// has been read so far, and in how many requests. null for other sources.
+Napi::Value LibRawWrapper::GetReadStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (!CheckLoaded(env))
+        return env.Null();
+    if (!sourceStream)
+        return env.Null();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("bytesRead", Napi::Number::New(env, static_cast<double>(sourceStream->bytes_read())));
+    result.Set("reads", Napi::Number::New(env, sourceStream->source_reads()));
+    result.Set("fileSize", Napi::Number::New(env, static_cast<double>(sourceStream->size())));
+    return result;
+}
+
 // ============== METADATA & INFORMATION ==============
 
 Napi::Value LibRawWrapper::GetMetadata(const Napi::CallbackInfo &info)
@@ -422,6 +629,12 @@ Napi::Value LibRawWrapper::UnpackThumbnail(const Napi::CallbackInfo &info)
     if (!CheckLoaded(env))
         return env.Null();
     int ret = processor->unpack_thumb();
+    std::string readError;
+    if (!CheckStreamError(readError, "Failed to unpack thumbnail: "))
+    {
+        Napi::Error::New(env, readError).ThrowAsJavaScriptException();
+        return env.Null();
+    }
     if (ret != LIBRAW_SUCCESS)
     {
         std::string error = "Failed to unpack thumbnail: ";
@@ -436,7 +649,7 @@ Napi::Value LibRawWrapper::UnpackThumbnail(const Napi::CallbackInfo &info)
 Napi::Value LibRawWrapper::ProcessImage(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    if (!CheckLoaded(env))
+    if (!CheckUnpacked(env))
         return env.Null();
     int ret = processor->dcraw_process();
     if (ret != LIBRAW_SUCCESS)
@@ -454,7 +667,7 @@ Napi::Value LibRawWrapper::ProcessImage(const Napi::CallbackInfo &info)
 Napi::Value LibRawWrapper::SubtractBlack(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    if (!CheckLoaded(env))
+    if (!CheckUnpacked(env))
         return env.Null();
     int ret = processor->subtract_black();
     if (ret != LIBRAW_SUCCESS)
@@ -471,7 +684,7 @@ Napi::Value LibRawWrapper::SubtractBlack(const Napi::CallbackInfo &info)
 Napi::Value LibRawWrapper::Raw2Image(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    if (!CheckLoaded(env))
+    if (!CheckUnpacked(env))
         return env.Null();
     int ret = processor->raw2image();
     if (ret != LIBRAW_SUCCESS)
@@ -488,7 +701,7 @@ Napi::Value LibRawWrapper::Raw2Image(const Napi::CallbackInfo &info)
 Napi::Value LibRawWrapper::AdjustMaximum(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    if (!CheckLoaded(env))
+    if (!CheckUnpacked(env))
         return env.Null();
     int ret = processor->adjust_maximum();
     if (ret != LIBRAW_SUCCESS)
@@ -504,6 +717,8 @@ Napi::Value LibRawWrapper::AdjustMaximum(const Napi::CallbackInfo &info)
 
 // ============== MEMORY IMAGE CREATION ==============
 
+// Takes ownership of img: the returned Buffer wraps img->data directly and
+// releases the allocation with dcraw_clear_mem() when it is garbage collected.
 Napi::Object LibRawWrapper::CreateImageDataObject(Napi::Env env, libraw_processed_image_t *img)
 {
     Napi::Object result = Napi::Object::New(env);
@@ -520,8 +735,17 @@ Napi::Object LibRawWrapper::CreateImageDataObject(Napi::Env env, libraw_processe
     result.Set("bits", Napi::Number::New(env, img->bits));
     result.Set("dataSize", Napi::Number::New(env, img->data_size));
 
-    // Create buffer with the image data
-    Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::Copy(env, img->data, img->data_size);
+    // Expose the image data without copying it
+    int64_t externalSize = static_cast<int64_t>(img->data_size);
+    Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::New(
+        env, img->data, img->data_size,
+        [externalSize](Napi::Env env, uint8_t *, libraw_processed_image_t *hint)
+        {
+            LibRaw::dcraw_clear_mem(hint);
+            Napi::MemoryManagement::AdjustExternalMemory(env, -externalSize);
+        },
+        img);
+    Napi::MemoryManagement::AdjustExternalMemory(env, externalSize);
     result.Set("data", buffer);
 
     return result;
@@ -550,10 +774,7 @@ Napi::Value LibRawWrapper::CreateMemoryImage(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
-    Napi::Object result = CreateImageDataObject(env, img);
-    LibRaw::dcraw_clear_mem(img);
-
-    return result;
+    return CreateImageDataObject(env, img);
 }
 
 Napi::Value LibRawWrapper::CreateMemoryThumbnail(const Napi::CallbackInfo &info)
@@ -579,10 +800,7 @@ Napi::Value LibRawWrapper::CreateMemoryThumbnail(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
-    Napi::Object result = CreateImageDataObject(env, img);
-    LibRaw::dcraw_clear_mem(img);
-
-    return result;
+    return CreateImageDataObject(env, img);
 }
 
 // ============== FILE WRITERS ==============
@@ -680,33 +898,48 @@ Napi::Value LibRawWrapper::SetOutputParams(const Napi::CallbackInfo &info)
     }
 
     Napi::Object params = info[0].As<Napi::Object>();
+    ApplyOutputParams(params, processor->imgdata.params);
+
+    // Scalar colour conversion and scaling instead of the AVX2/NEON kernels
+    if (params.Has("simd_kernels") && params.Get("simd_kernels").IsBoolean())
+    {
+        if (params.Get("simd_kernels").As<Napi::Boolean>().Value())
+            processor->imgdata.rawparams.options &= ~LIBRAW_RAWOPTIONS_NO_SIMD_KERNELS;
+        else
+            processor->imgdata.rawparams.options |= LIBRAW_RAWOPTIONS_NO_SIMD_KERNELS;
+    }
+    return Napi::Boolean::New(env, true);
+}
+
+void LibRawWrapper::ApplyOutputParams(Napi::Object params, libraw_output_params_t &out)
+{
     // Gamma settings
     if (params.Has("gamma") && params.Get("gamma").IsArray())
     {
         Napi::Array gamma = params.Get("gamma").As<Napi::Array>();
         if (gamma.Length() >= 2)
         {
-            processor->imgdata.params.gamm[0] = gamma.Get(0u).As<Napi::Number>().DoubleValue();
-            processor->imgdata.params.gamm[1] = gamma.Get(1u).As<Napi::Number>().DoubleValue();
+            out.gamm[0] = gamma.Get(0u).As<Napi::Number>().DoubleValue();
+            out.gamm[1] = gamma.Get(1u).As<Napi::Number>().DoubleValue();
         }
     }
 
     // Brightness
     if (params.Has("bright") && params.Get("bright").IsNumber())
     {
-        processor->imgdata.params.bright = params.Get("bright").As<Napi::Number>().FloatValue();
+        out.bright = params.Get("bright").As<Napi::Number>().FloatValue();
     }
 
     // Output color space
     if (params.Has("output_color") && params.Get("output_color").IsNumber())
     {
-        processor->imgdata.params.output_color = params.Get("output_color").As<Napi::Number>().Int32Value();
+        out.output_color = params.Get("output_color").As<Napi::Number>().Int32Value();
     }
 
     // Output bits per sample
     if (params.Has("output_bps") && params.Get("output_bps").IsNumber())
     {
-        processor->imgdata.params.output_bps = params.Get("output_bps").As<Napi::Number>().Int32Value();
+        out.output_bps = params.Get("output_bps").As<Napi::Number>().Int32Value();
     }
 
     // User multipliers
@@ -715,29 +948,38 @@ Napi::Value LibRawWrapper::SetOutputParams(const Napi::CallbackInfo &info)
         Napi::Array userMul = params.Get("user_mul").As<Napi::Array>();
         for (uint32_t i = 0; i < 4 && i < userMul.Length(); i++)
         {
-            processor->imgdata.params.user_mul[i] = userMul.Get(i).As<Napi::Number>().FloatValue();
+            out.user_mul[i] = userMul.Get(i).As<Napi::Number>().FloatValue();
         }
     }
 
     // Auto bright
     if (params.Has("no_auto_bright") && params.Get("no_auto_bright").IsBoolean())
     {
-        processor->imgdata.params.no_auto_bright = params.Get("no_auto_bright").As<Napi::Boolean>().Value() ? 1 : 0;
+        out.no_auto_bright = params.Get("no_auto_bright").As<Napi::Boolean>().Value() ? 1 : 0;
     }
 
     // Highlight mode
     if (params.Has("highlight") && params.Get("highlight").IsNumber())
     {
-        processor->imgdata.params.highlight = params.Get("highlight").As<Napi::Number>().Int32Value();
+        out.highlight = params.Get("highlight").As<Napi::Number>().Int32Value();
     }
 
     // Output TIFF
     if (params.Has("output_tiff") && params.Get("output_tiff").IsBoolean())
     {
-        processor->imgdata.params.output_tiff = params.Get("output_tiff").As<Napi::Boolean>().Value() ? 1 : 0;
+        out.output_tiff = params.Get("output_tiff").As<Napi::Boolean>().Value() ? 1 : 0;
     }
 
-    return Napi::Boolean::New(env, true);
+    // Half-size output (one pixel per 2x2 block, no demosaic), optionally
+    // binned further
+    if (params.Has("half_size") && params.Get("half_size").IsBoolean())
+    {
+        out.half_size = params.Get("half_size").As<Napi::Boolean>().Value() ? 1 : 0;
+    }
+    if (params.Has("half_size_bin") && params.Get("half_size_bin").IsNumber())
+    {
+        out.half_size_bin = params.Get("half_size_bin").As<Napi::Number>().Int32Value();
+    }
 }
 
 Napi::Value LibRawWrapper::GetOutputParams(const Napi::CallbackInfo &info)
@@ -760,6 +1002,9 @@ Napi::Value LibRawWrapper::GetOutputParams(const Napi::CallbackInfo &info)
     params.Set("no_auto_bright", Napi::Boolean::New(env, processor->imgdata.params.no_auto_bright));
     params.Set("highlight", Napi::Number::New(env, processor->imgdata.params.highlight));
     params.Set("output_tiff", Napi::Boolean::New(env, processor->imgdata.params.output_tiff));
+    params.Set("half_size", Napi::Boolean::New(env, processor->imgdata.params.half_size));
+    params.Set("half_size_bin", Napi::Number::New(env, processor->imgdata.params.half_size_bin));
+    params.Set("simd_kernels", Napi::Boolean::New(env, !(processor->imgdata.rawparams.options & LIBRAW_RAWOPTIONS_NO_SIMD_KERNELS)));
 
     // User multipliers
     Napi::Array userMul = Napi::Array::New(env);
@@ -870,6 +1115,47 @@ Napi::Value LibRawWrapper::GetCameraCount(const Napi::CallbackInfo &info)
     return Napi::Number::New(env, count);
 }
 
+Napi::Value LibRawWrapper::ConfigurePool(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        Napi::TypeError::New(env, "Expected object with pool options").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object options = info[0].As<Napi::Object>();
+    LibRawPool &pool = LibRawPool::Instance();
+
+    if (options.Has("maxIdle") && options.Get("maxIdle").IsNumber())
+    {
+        int32_t maxIdle = options.Get("maxIdle").As<Napi::Number>().Int32Value();
+        pool.SetMaxIdle(static_cast<size_t>(std::max(0, maxIdle)));
+    }
+    if (options.Has("prewarm") && options.Get("prewarm").IsNumber())
+    {
+        int32_t prewarm = options.Get("prewarm").As<Napi::Number>().Int32Value();
+        pool.Prewarm(static_cast<size_t>(std::max(0, prewarm)));
+    }
+
+    return GetPoolStats(info);
+}
+
+Napi::Value LibRawWrapper::GetPoolStats(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    LibRawPool::Stats stats = LibRawPool::Instance().GetStats();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("idle", Napi::Number::New(env, static_cast<double>(stats.idle)));
+    result.Set("maxIdle", Napi::Number::New(env, static_cast<double>(stats.maxIdle)));
+    result.Set("created", Napi::Number::New(env, static_cast<double>(stats.created)));
+    result.Set("reused", Napi::Number::New(env, static_cast<double>(stats.reused)));
+    result.Set("discarded", Napi::Number::New(env, static_cast<double>(stats.discarded)));
+    return result;
+}
+
 // ============== EXTENDED UTILITY FUNCTIONS ==============
 
 Napi::Value LibRawWrapper::IsNikonSRAW(const Napi::CallbackInfo &info)
@@ -969,6 +1255,12 @@ Napi::Value LibRawWrapper::Unpack(const Napi::CallbackInfo &info)
     if (!CheckLoaded(env))
         return env.Null();
     int ret = processor->unpack();
+    std::string readError;
+    if (!CheckStreamError(readError, "Failed to unpack: "))
+    {
+        Napi::Error::New(env, readError).ThrowAsJavaScriptException();
+        return env.Null();
+    }
     if (ret != LIBRAW_SUCCESS)
     {
         std::string error = "Failed to unpack: ";
@@ -977,13 +1269,14 @@ Napi::Value LibRawWrapper::Unpack(const Napi::CallbackInfo &info)
         return env.Null();
     }
 
+    isUnpacked = true;
     return Napi::Boolean::New(env, true);
 }
 
 Napi::Value LibRawWrapper::Raw2ImageEx(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    if (!CheckLoaded(env))
+    if (!CheckUnpacked(env))
         return env.Null();
     // Default to subtract black, can be overridden
     int do_subtract_black = 1;
@@ -1034,7 +1327,7 @@ Napi::Value LibRawWrapper::FreeImage(const Napi::CallbackInfo &info)
 Napi::Value LibRawWrapper::ConvertFloatToInt(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
-    if (!CheckLoaded(env))
+    if (!CheckUnpacked(env))
         return env.Null();
     // Default values from LibRaw
     float dmin = 4096.0f;
@@ -1124,13 +1417,38 @@ Napi::Value LibRawWrapper::GetColorAt(const Napi::CallbackInfo &info)
     return Napi::Number::New(env, color);
 }
 
+// ============== THREADING ==============
+
+Napi::Value LibRawWrapper::SetThreads(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        Napi::TypeError::New(env, "Expected thread count as number").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int threads = info[0].As<Napi::Number>().Int32Value();
+    if (threads < 0)
+    {
+        Napi::RangeError::New(env, "Thread count must be 0 (default) or positive").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // Applied on the worker thread at the start of each async operation
+    ompThreads = threads;
+    return Napi::Number::New(env, OpenMPTeamSize(threads));
+}
+
 // ============== CANCELLATION SUPPORT ==============
 
 Napi::Value LibRawWrapper::SetCancelFlag(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    processor->setCancelFlag();
+    if (processor)
+        processor->setCancelFlag();
     return Napi::Boolean::New(env, true);
 }
 
@@ -1138,7 +1456,8 @@ Napi::Value LibRawWrapper::ClearCancelFlag(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    processor->clearCancelFlag();
+    if (processor)
+        processor->clearCancelFlag();
     return Napi::Boolean::New(env, true);
 }
 
@@ -1148,7 +1467,7 @@ Napi::Value LibRawWrapper::Version(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    const char *version = processor->version();
+    const char *version = LibRaw::version();
     return Napi::String::New(env, version);
 }
 
@@ -1156,7 +1475,7 @@ Napi::Value LibRawWrapper::VersionNumber(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    int versionNum = processor->versionNumber();
+    int versionNum = LibRaw::versionNumber();
 
     // LibRaw version number is encoded as XXYYZZ where XX.YY.ZZ is the version
     int major = versionNum / 10000;
@@ -1193,6 +1512,1104 @@ Napi::Value LibRawWrapper::Strerror(const Napi::CallbackInfo &info)
     }
 
     int errorCode = info[0].As<Napi::Number>().Int32Value();
-    const char *errorMsg = processor->strerror(errorCode);
+    const char *errorMsg = libraw_strerror(errorCode);
     return Napi::String::New(env, errorMsg);
 }
+
+// ============== ASYNCHRONOUS OPERATIONS ==============
+
+static const char *const kNotLoadedError = "No file loaded. Call loadFile() first.";
+
+Napi::Value LibRawWrapper::QueueAsync(Napi::Env env, const char *name, LibRawAsyncWorker::Task task, LibRawAsyncWorker::Resolver resolver, bool waitsOnJS)
+{
+    LibRawAsyncWorker *worker = new LibRawAsyncWorker(env, this, name, std::move(task), std::move(resolver));
+    worker->waitsOnJS = waitsOnJS;
+    Napi::Promise promise = worker->GetPromise();
+
+    if (asyncRunning)
+    {
+        asyncQueue.push_back(worker);
+    }
+    else
+    {
+        asyncRunning = true;
+        StartAsync(worker);
+    }
+
+    return promise;
+}
+
+// Any task may read a loadStream() source (lazy unpack, thumbnails), so while
+// one is loaded every task gets its own thread, like the tasks that wait on a
+// JS callback by themselves (see LibRawAsyncWorker::Start)
+void LibRawWrapper::StartAsync(LibRawAsyncWorker *worker)
+{
+    worker->Start(worker->waitsOnJS || streamReader != nullptr);
+}
+
+void LibRawWrapper::AsyncCompleted()
+{
+    if (asyncQueue.empty())
+    {
+        asyncRunning = false;
+        return;
+    }
+
+    LibRawAsyncWorker *next = asyncQueue.front();
+    asyncQueue.pop_front();
+    StartAsync(next);
+}
+
+Napi::Value LibRawWrapper::LoadFileAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected string filename").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filename = info[0].As<Napi::String>().Utf8Value();
+    LoadOptions options = GetLoadOptions(info);
+    AcquireProcessor();
+    // Operations queued ahead of this load may still read the pinned buffer;
+    // the worker owns it until the load has replaced the datastream.
+    auto previous = std::make_shared<Napi::Reference<Napi::Value>>(std::move(sourceBuffer));
+    auto task = [this, filename, options, previous](std::string &error)
+    {
+        // open_file() recycles any previously loaded image
+        isLoaded = false;
+        isUnpacked = false;
+        isProcessed = false;
+
+        std::unique_ptr<LibRaw_prefetch_datastream> stream;
+        int ret = OpenFileSource(processor.get(), filename, options, stream);
+        sourceStream = std::move(stream);
+        streamReader = nullptr;
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to open file: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        if (options.unpack)
+        {
+            ret = processor->unpack();
+            if (ret != LIBRAW_SUCCESS)
+            {
+                error = std::string("Failed to unpack file: ") + libraw_strerror(ret);
+                return false;
+            }
+        }
+
+        isLoaded = true;
+        isUnpacked = options.unpack;
+        return true;
+    };
+
+    return QueueAsync(env, "LibRaw.loadFile", task);
+}
+
+Napi::Value LibRawWrapper::LoadBufferAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    const uint8_t *data;
+    size_t length;
+    if (info.Length() < 1 || !GetSourceMemory(info[0], data, length))
+    {
+        Napi::TypeError::New(env, "Expected Buffer, Uint8Array or ArrayBuffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    LoadOptions options = GetLoadOptions(info);
+    AcquireProcessor();
+    // Pinned now, so the worker can decode straight from the caller's memory;
+    // the previous source is released once this load has run (see
+    // LoadFileAsync).
+    auto previous = std::make_shared<Napi::Reference<Napi::Value>>(std::move(sourceBuffer));
+    sourceBuffer = Napi::Persistent(info[0]);
+    auto task = [this, data, length, options, previous](std::string &error)
+    {
+        isLoaded = false;
+        isUnpacked = false;
+        isProcessed = false;
+
+        int ret = processor->open_buffer(data, length);
+        sourceStream.reset();
+        streamReader = nullptr;
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to open buffer: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        if (options.unpack)
+        {
+            ret = processor->unpack();
+            if (ret != LIBRAW_SUCCESS)
+            {
+                error = std::string("Failed to unpack buffer: ") + libraw_strerror(ret);
+                return false;
+            }
+        }
+
+        isLoaded = true;
+        isUnpacked = options.unpack;
+        return true;
+    };
+
+    return QueueAsync(env, "LibRaw.loadBuffer", task);
+}
+
+// loadStream({ size, read }, options): decodes through a JSRangeDatastream
+// behind a block cache (LibRaw_prefetch_datastream), so only the byte ranges
+// LibRaw touches are requested from the reader.
+//   blockSize    bytes per cached block and per metadata read (256 KiB)
+//   cacheBlocks  number of cached blocks (16)
+Napi::Value LibRawWrapper::LoadStreamAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+    {
+        Napi::TypeError::New(env, "Expected a { size, read } datastream source").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object source = info[0].As<Napi::Object>();
+    Napi::Value size = source.Get("size");
+    Napi::Value read = source.Get("read");
+    if (!size.IsNumber() || size.As<Napi::Number>().Int64Value() <= 0 || !read.IsFunction())
+    {
+        Napi::TypeError::New(env, "Datastream source needs a positive size and a read(offset, length) function").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    LoadOptions options = GetLoadOptions(info);
+    size_t blockSize = 262144;
+    int cacheBlocks = 16;
+    if (info.Length() > 1 && info[1].IsObject())
+    {
+        Napi::Object opts = info[1].As<Napi::Object>();
+        if (opts.Has("blockSize") && opts.Get("blockSize").IsNumber() && opts.Get("blockSize").As<Napi::Number>().Int64Value() > 0)
+            blockSize = static_cast<size_t>(opts.Get("blockSize").As<Napi::Number>().Int64Value());
+        if (opts.Has("cacheBlocks") && opts.Get("cacheBlocks").IsNumber())
+            cacheBlocks = std::max(1, opts.Get("cacheBlocks").As<Napi::Number>().Int32Value());
+    }
+
+    AcquireProcessor();
+    // The thread-safe function must be created on the JS thread; the worker
+    // takes the stream over once the previous one has been released.
+    JSRangeDatastream *reader = new JSRangeDatastream(env, read.As<Napi::Function>(), size.As<Napi::Number>().Int64Value());
+    auto stream = std::make_shared<std::unique_ptr<LibRaw_prefetch_datastream>>(
+        new LibRaw_prefetch_datastream(reader, blockSize, cacheBlocks));
+    auto previous = std::make_shared<Napi::Reference<Napi::Value>>(std::move(sourceBuffer));
+    auto task = [this, stream, reader, options, previous](std::string &error)
+    {
+        isLoaded = false;
+        isUnpacked = false;
+        isProcessed = false;
+
+        int ret = processor->open_datastream(stream->get());
+        sourceStream = std::move(*stream);
+        streamReader = reader;
+        if (!CheckStreamError(error, "Failed to open stream: "))
+            return false;
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to open stream: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        if (options.unpack)
+        {
+            ret = processor->unpack();
+            if (!CheckStreamError(error, "Failed to unpack stream: "))
+                return false;
+            if (ret != LIBRAW_SUCCESS)
+            {
+                error = std::string("Failed to unpack stream: ") + libraw_strerror(ret);
+                return false;
+            }
+        }
+
+        isLoaded = true;
+        isUnpacked = options.unpack;
+        return true;
+    };
+
+    return QueueAsync(env, "LibRaw.loadStream", task, nullptr, true);
+}
+Napi::Value LibRawWrapper::UnpackAsync(const Napi::CallbackInfo &info)
+{
+    auto task = [this](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        int ret = processor->unpack();
+        if (!CheckStreamError(error, "Failed to unpack: "))
+            return false;
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to unpack: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        isUnpacked = true;
+        return true;
+    };
+
+    return QueueAsync(info.Env(), "LibRaw.unpack", task);
+}
+
+Napi::Value LibRawWrapper::UnpackThumbnailAsync(const Napi::CallbackInfo &info)
+{
+    auto task = [this](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        int ret = processor->unpack_thumb();
+        if (!CheckStreamError(error, "Failed to unpack thumbnail: "))
+            return false;
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to unpack thumbnail: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        return true;
+    };
+
+    return QueueAsync(info.Env(), "LibRaw.unpackThumbnail", task);
+}
+
+Napi::Value LibRawWrapper::ProcessImageAsync(const Napi::CallbackInfo &info)
+{
+    auto task = [this](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+        if (!EnsureUnpacked(error))
+            return false;
+
+        int ret = processor->dcraw_process();
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to process image: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        isProcessed = true;
+        return true;
+    };
+
+    return QueueAsync(info.Env(), "LibRaw.processImage", task);
+}
+
+Napi::Value LibRawWrapper::Raw2ImageAsync(const Napi::CallbackInfo &info)
+{
+    auto task = [this](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+        if (!EnsureUnpacked(error))
+            return false;
+
+        int ret = processor->raw2image();
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to convert raw to image: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        return true;
+    };
+
+    return QueueAsync(info.Env(), "LibRaw.raw2Image", task);
+}
+
+Napi::Value LibRawWrapper::Raw2ImageExAsync(const Napi::CallbackInfo &info)
+{
+    // Default to subtract black, can be overridden
+    int do_subtract_black = 1;
+    if (info.Length() > 0 && info[0].IsBoolean())
+    {
+        do_subtract_black = info[0].As<Napi::Boolean>().Value() ? 1 : 0;
+    }
+
+    auto task = [this, do_subtract_black](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+        if (!EnsureUnpacked(error))
+            return false;
+
+        int ret = processor->raw2image_ex(do_subtract_black);
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to convert raw to image: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        return true;
+    };
+
+    return QueueAsync(info.Env(), "LibRaw.raw2ImageEx", task);
+}
+
+// Owns a libraw_processed_image_t between the worker thread and the JS thread
+struct ProcessedImageHolder
+{
+    libraw_processed_image_t *img = nullptr;
+    ~ProcessedImageHolder()
+    {
+        if (img)
+            LibRaw::dcraw_clear_mem(img);
+    }
+};
+
+Napi::Value LibRawWrapper::CreateMemoryImageAsync(const Napi::CallbackInfo &info)
+{
+    auto holder = std::make_shared<ProcessedImageHolder>();
+
+    auto task = [this, holder](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        int errcode = 0;
+        holder->img = processor->dcraw_make_mem_image(&errcode);
+        if (!holder->img || errcode != LIBRAW_SUCCESS)
+        {
+            error = "Failed to create memory image: ";
+            error += errcode != LIBRAW_SUCCESS ? libraw_strerror(errcode) : "Unknown error";
+            return false;
+        }
+
+        return true;
+    };
+
+    auto resolver = [this, holder](Napi::Env env) -> Napi::Value
+    {
+        libraw_processed_image_t *img = holder->img;
+        holder->img = nullptr; // ownership moves to the JS Buffer
+        return CreateImageDataObject(env, img);
+    };
+
+    return QueueAsync(info.Env(), "LibRaw.createMemoryImage", task, resolver);
+}
+
+// Converts the processed image band by band instead of into one memory
+// image: only bandRows output rows exist at a time on the native side, and
+// each band goes to onBand(buffer, info) before the next one is converted.
+Napi::Value LibRawWrapper::StreamImageAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsFunction())
+    {
+        Napi::TypeError::New(env, "Expected band rows and an onBand(buffer, info) function").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int bandRows = info[0].As<Napi::Number>().Int32Value();
+    if (bandRows <= 0)
+    {
+        Napi::RangeError::New(env, "Band rows must be a positive number").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    // The thread-safe function must be created on the JS thread
+    auto writer = std::make_shared<JSBandWriter>(env, info[1].As<Napi::Function>());
+
+    auto task = [this, writer, bandRows](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        processor->get_mem_image_format(&writer->width, &writer->height, &writer->colors, &writer->bits);
+        int ret = processor->copy_mem_image_bands(bandRows, 0, JSBandWriter::Write, writer.get());
+        std::string writeError = writer->Error();
+        if (!writeError.empty())
+        {
+            error = writeError;
+            return false;
+        }
+        // A callback returning false ends the stream early; that is no error
+        if (ret != LIBRAW_SUCCESS && ret != LIBRAW_CANCELLED_BY_CALLBACK)
+        {
+            error = std::string("Failed to stream image: ") + libraw_strerror(ret);
+            return false;
+        }
+        return true;
+    };
+
+    // Waits on the consumer, which may need the libuv pool to drain (e.g. a
+    // pipe into fs.createWriteStream), so it must not hold a pool thread
+    return QueueAsync(env, "LibRaw.streamImage", task, nullptr, true);
+}
+
+// Encodes the processed image as JPEG on the worker thread, straight from
+// LibRaw's working image (see EncodeProcessedJPEG). The compressed buffer
+// is handed to JS without a copy.
+Napi::Value LibRawWrapper::EncodeJPEGAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+#ifdef LIBRAW_ADDON_JPEG
+    JpegEncodeOptions options;
+    if (info.Length() > 0 && info[0].IsObject())
+    {
+        Napi::Object opts = info[0].As<Napi::Object>();
+        if (opts.Has("quality") && opts.Get("quality").IsNumber())
+            options.quality = std::max(1, std::min(100, opts.Get("quality").As<Napi::Number>().Int32Value()));
+        if (opts.Has("progressive") && opts.Get("progressive").IsBoolean())
+            options.progressive = opts.Get("progressive").As<Napi::Boolean>().Value();
+        if (opts.Has("optimizeCoding") && opts.Get("optimizeCoding").IsBoolean())
+            options.optimizeCoding = opts.Get("optimizeCoding").As<Napi::Boolean>().Value();
+        if (opts.Has("chromaSubsampling") && opts.Get("chromaSubsampling").IsString())
+        {
+            std::string sampling = opts.Get("chromaSubsampling").As<Napi::String>().Utf8Value();
+            if (sampling == "4:4:4")
+                options.hSamp = options.vSamp = 1;
+            else if (sampling == "4:2:2")
+                options.vSamp = 1;
+            else if (sampling != "4:2:0")
+            {
+                Napi::RangeError::New(env, "chromaSubsampling must be 4:2:0, 4:2:2 or 4:4:4").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+        }
+    }
+
+    auto result = std::make_shared<JpegEncodeResult>();
+
+    auto task = [this, options, result](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+        return EncodeProcessedJPEG(processor.get(), options, *result, error);
+    };
+
+    auto resolver = [result](Napi::Env env) -> Napi::Value
+    {
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("width", Napi::Number::New(env, result->width));
+        object.Set("height", Napi::Number::New(env, result->height));
+        object.Set("colors", Napi::Number::New(env, result->colors));
+
+        int64_t externalSize = static_cast<int64_t>(result->size);
+        Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::New(
+            env, result->data, result->size,
+            [externalSize](Napi::Env env, uint8_t *data)
+            {
+                free(data);
+                Napi::MemoryManagement::AdjustExternalMemory(env, -externalSize);
+            });
+        Napi::MemoryManagement::AdjustExternalMemory(env, externalSize);
+        result->data = nullptr; // ownership moves to the JS Buffer
+        object.Set("buffer", buffer);
+        return object;
+    };
+
+    return QueueAsync(env, "LibRaw.encodeJPEG", task, resolver);
+#else
+    Napi::Error::New(env, "This build has no native JPEG encoder; rebuild with LIBRAW_JPEG=1").ThrowAsJavaScriptException();
+    return env.Null();
+#endif
+}
+
+// Screen-sized preview: picks the cheapest reduction that keeps the longer
+// edge at or above maxEdge. half_size builds one RGB pixel per 2x2 CFA block
+// and so skips demosaicing; far smaller targets additionally bin NxN of
+// those pixels right after raw2image_ex (half_size_bin), which shrinks every
+// later stage too. The caller's half_size settings are restored afterwards.
+Napi::Value LibRawWrapper::ProcessPreviewAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    int maxEdge = 1024;
+    if (info.Length() > 0 && info[0].IsObject())
+    {
+        Napi::Object options = info[0].As<Napi::Object>();
+        if (options.Has("maxEdge") && options.Get("maxEdge").IsNumber())
+            maxEdge = options.Get("maxEdge").As<Napi::Number>().Int32Value();
+    }
+    if (maxEdge <= 0)
+    {
+        Napi::RangeError::New(env, "maxEdge must be a positive number").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    auto holder = std::make_shared<ProcessedImageHolder>();
+
+    auto task = [this, holder, maxEdge](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+        if (!EnsureUnpacked(error))
+            return false;
+
+        // rawdata.sizes keeps the identified size across earlier (possibly
+        // reduced) processing runs
+        libraw_output_params_t &params = processor->imgdata.params;
+        const libraw_image_sizes_t &sizes = processor->imgdata.rawdata.sizes;
+        int factor = std::max<int>(sizes.width, sizes.height) / maxEdge;
+        int savedHalfSize = params.half_size;
+        int savedBin = params.half_size_bin;
+        params.half_size = factor >= 2;
+        params.half_size_bin = factor >= 4 ? factor / 2 : 0;
+
+        int ret = processor->dcraw_process();
+        params.half_size = savedHalfSize;
+        params.half_size_bin = savedBin;
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to process preview: ") + libraw_strerror(ret);
+            return false;
+        }
+        isProcessed = true;
+
+        int errcode = 0;
+        holder->img = processor->dcraw_make_mem_image(&errcode);
+        if (!holder->img || errcode != LIBRAW_SUCCESS)
+        {
+            error = "Failed to create memory image: ";
+            error += errcode != LIBRAW_SUCCESS ? libraw_strerror(errcode) : "Unknown error";
+            return false;
+        }
+        return true;
+    };
+
+    auto resolver = [this, holder](Napi::Env env) -> Napi::Value
+    {
+        libraw_processed_image_t *img = holder->img;
+        holder->img = nullptr; // ownership moves to the JS Buffer
+        return CreateImageDataObject(env, img);
+    };
+
+    return QueueAsync(env, "LibRaw.processPreview", task, resolver);
+}
+
+// Image rectangle, in pixels
+struct PixelRect
+{
+    int x, y, w, h;
+};
+
+// Rotation/mirroring LibRaw applies to the output, resolved the same way
+// raw2image_start() does (user_flip override, degrees mapped to flip bits)
+static int OutputFlip(const libraw_data_t &data)
+{
+    int flip = data.params.user_flip >= 0 ? data.params.user_flip : data.rawdata.sizes.flip;
+    switch ((flip + 3600) % 360)
+    {
+    case 270:
+        return 5;
+    case 180:
+        return 3;
+    case 90:
+        return 6;
+    default:
+        return flip;
+    }
+}
+
+// Maps a rectangle between output and sensor orientation of a frame of
+// sensor size width x height. flip_index() is an involution on rectangles
+// up to the axis swap, so the same function serves both directions.
+static PixelRect FlipRect(PixelRect r, int flip, int width, int height, bool toSensor)
+{
+    if (toSensor && (flip & 4))
+        r = {r.y, r.x, r.h, r.w};
+    if (flip & 2)
+        r.y = height - r.y - r.h;
+    if (flip & 1)
+        r.x = width - r.x - r.w;
+    if (!toSensor && (flip & 4))
+        r = {r.y, r.x, r.h, r.w};
+    return r;
+}
+
+// Cuts r out of a processed image in place: rows only ever move towards
+// the start of the buffer, which then shrinks to the smaller size
+static libraw_processed_image_t *CutMemImage(libraw_processed_image_t *img, const PixelRect &r)
+{
+    size_t pixelBytes = static_cast<size_t>(img->colors) * (img->bits / 8);
+    size_t rowBytes = static_cast<size_t>(r.w) * pixelBytes;
+    for (int row = 0; row < r.h; row++)
+        memmove(img->data + row * rowBytes,
+                img->data + ((static_cast<size_t>(r.y) + row) * img->width + r.x) * pixelBytes, rowBytes);
+    img->width = static_cast<ushort>(r.w);
+    img->height = static_cast<ushort>(r.h);
+    img->data_size = static_cast<unsigned int>(rowBytes * r.h);
+    void *shrunk = realloc(img, sizeof(libraw_processed_image_t) + img->data_size);
+    return shrunk ? static_cast<libraw_processed_image_t *>(shrunk) : img;
+}
+
+// Decodes and processes only a rectangle of the full-size output (x, y in
+// rotated output coordinates). The rectangle is mapped back to the sensor,
+// grown by `halo` pixels so the demosaic sees the same neighbourhood as in a
+// full run, and handed to LibRaw as cropbox: raw2image_ex, every
+// interpolation stage and the output conversion then work on that window
+// only. The halo is cut away again from the finished image. Images LibRaw
+// cannot crop exactly (Fuji rotated layouts, non-square pixels) are
+// processed whole and cut afterwards.
+Napi::Value LibRawWrapper::ProcessRegionAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 4 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber())
+    {
+        Napi::TypeError::New(env, "Expected x, y, width and height").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    PixelRect region = {info[0].As<Napi::Number>().Int32Value(), info[1].As<Napi::Number>().Int32Value(),
+                        info[2].As<Napi::Number>().Int32Value(), info[3].As<Napi::Number>().Int32Value()};
+    if (region.x < 0 || region.y < 0 || region.w <= 0 || region.h <= 0)
+    {
+        Napi::RangeError::New(env, "Region must have a non-negative origin and a positive size").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int halo = 32;
+    if (info.Length() > 4 && info[4].IsObject())
+    {
+        Napi::Object options = info[4].As<Napi::Object>();
+        if (options.Has("halo") && options.Get("halo").IsNumber())
+            halo = options.Get("halo").As<Napi::Number>().Int32Value();
+    }
+    if (halo < 0)
+    {
+        Napi::RangeError::New(env, "halo must not be negative").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    auto holder = std::make_shared<ProcessedImageHolder>();
+
+    auto task = [this, holder, region, halo](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+        if (!EnsureUnpacked(error))
+            return false;
+
+        libraw_data_t &data = processor->imgdata;
+        const libraw_image_sizes_t &sizes = data.rawdata.sizes;
+        int flip = OutputFlip(data);
+        int outWidth = (flip & 4) ? sizes.height : sizes.width;
+        int outHeight = (flip & 4) ? sizes.width : sizes.height;
+        bool exact = !processor->is_fuji_rotated() && sizes.pixel_aspect == 1.0;
+        // Sums of user input: compare in 64 bits so they cannot wrap
+        if (exact && (INT64(region.x) + region.w > outWidth || INT64(region.y) + region.h > outHeight))
+        {
+            error = "Region lies outside the " + std::to_string(outWidth) + "x" + std::to_string(outHeight) + " image";
+            return false;
+        }
+
+        libraw_output_params_t &params = data.params;
+        unsigned savedCrop[4];
+        memcpy(savedCrop, params.cropbox, sizeof(savedCrop));
+        int savedHalfSize = params.half_size;
+        int savedBin = params.half_size_bin;
+        params.half_size = 0;
+        params.half_size_bin = 0;
+
+        PixelRect sensor = FlipRect(region, flip, sizes.width, sizes.height, true);
+        PixelRect crop = {0, 0, 0, 0};
+        if (exact)
+        {
+            // A halo beyond the frame adds nothing
+            int margin = std::min<int>(halo, std::max(sizes.width, sizes.height));
+            crop.x = std::max(0, sensor.x - margin);
+            crop.y = std::max(0, sensor.y - margin);
+            // raw2image_ex rounds the origin down to the CFA repeat for these
+            // layouts; do it here so the halo bookkeeping stays exact
+            int align = data.idata.filters == LIBRAW_XTRANS ? 6 : data.idata.filters == 1 ? 16 : 1;
+            crop.x -= crop.x % align;
+            crop.y -= crop.y % align;
+            crop.w = static_cast<int>(std::min<INT64>(sizes.width, INT64(sensor.x) + sensor.w + margin)) - crop.x;
+            crop.h = static_cast<int>(std::min<INT64>(sizes.height, INT64(sensor.y) + sensor.h + margin)) - crop.y;
+            params.cropbox[0] = crop.x;
+            params.cropbox[1] = crop.y;
+            params.cropbox[2] = crop.w;
+            params.cropbox[3] = crop.h;
+        }
+
+        int ret = processor->dcraw_process();
+        memcpy(params.cropbox, savedCrop, sizeof(savedCrop));
+        params.half_size = savedHalfSize;
+        params.half_size_bin = savedBin;
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to process region: ") + libraw_strerror(ret);
+            return false;
+        }
+        isProcessed = true;
+
+        int errcode = 0;
+        holder->img = processor->dcraw_make_mem_image(&errcode);
+        if (!holder->img || errcode != LIBRAW_SUCCESS)
+        {
+            error = "Failed to create memory image: ";
+            error += errcode != LIBRAW_SUCCESS ? libraw_strerror(errcode) : "Unknown error";
+            return false;
+        }
+
+        // Where the requested pixels ended up inside the processed image
+        PixelRect inner = region;
+        if (exact)
+        {
+            PixelRect local = {sensor.x - crop.x, sensor.y - crop.y, sensor.w, sensor.h};
+            inner = FlipRect(local, flip, crop.w, crop.h, false);
+        }
+        // CutMemImage() trusts the rectangle; check it on both paths
+        if (inner.x < 0 || inner.y < 0 || inner.w <= 0 || inner.h <= 0 ||
+            INT64(inner.x) + inner.w > holder->img->width || INT64(inner.y) + inner.h > holder->img->height)
+        {
+            error = "Region lies outside the " + std::to_string(holder->img->width) + "x" +
+                    std::to_string(holder->img->height) + " image";
+            return false;
+        }
+        holder->img = CutMemImage(holder->img, inner);
+        return true;
+    };
+
+    auto resolver = [this, holder](Napi::Env env) -> Napi::Value
+    {
+        libraw_processed_image_t *img = holder->img;
+        holder->img = nullptr; // ownership moves to the JS Buffer
+        return CreateImageDataObject(env, img);
+    };
+
+    return QueueAsync(env, "LibRaw.processRegion", task, resolver);
+}
+
+Napi::Value LibRawWrapper::CreateMemoryThumbnailAsync(const Napi::CallbackInfo &info)
+{
+    auto holder = std::make_shared<ProcessedImageHolder>();
+
+    auto task = [this, holder](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        int errcode = 0;
+        holder->img = processor->dcraw_make_mem_thumb(&errcode);
+        if (!holder->img || errcode != LIBRAW_SUCCESS)
+        {
+            error = "Failed to create memory thumbnail: ";
+            error += errcode != LIBRAW_SUCCESS ? libraw_strerror(errcode) : "Unknown error";
+            return false;
+        }
+
+        return true;
+    };
+
+    auto resolver = [this, holder](Napi::Env env) -> Napi::Value
+    {
+        libraw_processed_image_t *img = holder->img;
+        holder->img = nullptr; // ownership moves to the JS Buffer
+        return CreateImageDataObject(env, img);
+    };
+
+    return QueueAsync(info.Env(), "LibRaw.createMemoryThumbnail", task, resolver);
+}
+
+Napi::Value LibRawWrapper::WritePPMAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected string filename").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filename = info[0].As<Napi::String>().Utf8Value();
+    auto task = [this, filename](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        int ret = processor->dcraw_ppm_tiff_writer(filename.c_str());
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to write PPM file: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        return true;
+    };
+
+    return QueueAsync(env, "LibRaw.writePPM", task);
+}
+
+Napi::Value LibRawWrapper::WriteTIFFAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected string filename").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filename = info[0].As<Napi::String>().Utf8Value();
+    auto task = [this, filename](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        // Set output format to TIFF
+        processor->imgdata.params.output_tiff = 1;
+
+        int ret = processor->dcraw_ppm_tiff_writer(filename.c_str());
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to write TIFF file: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        return true;
+    };
+
+    return QueueAsync(env, "LibRaw.writeTIFF", task);
+}
+
+Napi::Value LibRawWrapper::WriteThumbnailAsync(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        Napi::TypeError::New(env, "Expected string filename").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    std::string filename = info[0].As<Napi::String>().Utf8Value();
+    auto task = [this, filename](std::string &error)
+    {
+        if (!isLoaded)
+        {
+            error = kNotLoadedError;
+            return false;
+        }
+
+        int ret = processor->dcraw_thumb_writer(filename.c_str());
+        if (ret != LIBRAW_SUCCESS)
+        {
+            error = std::string("Failed to write thumbnail: ") + libraw_strerror(ret);
+            return false;
+        }
+
+        return true;
+    };
+
+    return QueueAsync(env, "LibRaw.writeThumbnail", task);
+}
+
+// Picks the thumbnail whose longer edge is the largest one not above maxSize,
+// or the smallest one if none fits. Returns -1 when the file lists none.
+static int SelectThumbnail(const libraw_thumbnail_list_t &list, int maxSize)
+{
+    int best = -1, bestEdge = 0;
+    int smallest = -1, smallestEdge = 0;
+    for (int i = 0; i < list.thumbcount && i < LIBRAW_THUMBNAIL_MAXCOUNT; i++)
+    {
+        int edge = std::max(list.thumblist[i].twidth, list.thumblist[i].theight);
+        if (edge <= maxSize && (best < 0 || edge > bestEdge))
+        {
+            best = i;
+            bestEdge = edge;
+        }
+        if (smallest < 0 || edge < smallestEdge)
+        {
+            smallest = i;
+            smallestEdge = edge;
+        }
+    }
+    return best >= 0 ? best : smallest;
+}
+
+// Opens a file or buffer on a pooled processor, unpacks one embedded
+// thumbnail and nothing else, so only the metadata and the thumbnail's byte
+// range are read.
+class ExtractThumbnailWorker : public Napi::AsyncWorker
+{
+public:
+    ExtractThumbnailWorker(Napi::Env env, Napi::Value source, int index, int maxSize)
+        : Napi::AsyncWorker(env, "LibRaw.extractThumbnail"), deferred(Napi::Promise::Deferred::New(env)), data(nullptr), length(0), index(index), maxSize(maxSize)
+    {
+        if (source.IsString())
+        {
+            path = source.As<Napi::String>().Utf8Value();
+        }
+        else
+        {
+            GetSourceMemory(source, data, length);
+            // read in place on the worker thread
+            pinned = Napi::Persistent(source);
+        }
+    }
+
+    Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+    void Execute() override
+    {
+        std::unique_ptr<LibRaw> processor = LibRawPool::Instance().Acquire();
+        std::string error = Extract(processor.get());
+        LibRawPool::Instance().Release(std::move(processor));
+        if (!error.empty())
+            SetError(error);
+    }
+
+    void OnOK() override
+    {
+        Napi::Env env = Env();
+        libraw_processed_image_t *img = holder.img;
+        holder.img = nullptr; // ownership moves to the JS Buffer
+        Napi::Object result = LibRawWrapper::CreateImageDataObject(env, img);
+        if (index >= 0)
+            result.Set("index", Napi::Number::New(env, index));
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error &error) override
+    {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    std::string Extract(LibRaw *processor)
+    {
+        int ret;
+        if (path.empty())
+        {
+            ret = processor->open_buffer(data, length);
+        }
+        else
+        {
+            // identify() plus one thumbnail touch a small part of the file
+            LoadOptions options;
+            options.prefetch = kDefaultPrefetchWindow;
+            ret = OpenFileSource(processor, path, options, stream);
+        }
+        if (ret != LIBRAW_SUCCESS)
+            return std::string("Failed to open file: ") + libraw_strerror(ret);
+
+        if (index < 0 && maxSize > 0)
+            index = SelectThumbnail(processor->imgdata.thumbs_list, maxSize);
+
+        if (index >= 0)
+        {
+            ret = processor->unpack_thumb_ex(index);
+        }
+        else
+        {
+            // LibRaw's own choice; find it in the list to report its index
+            const libraw_thumbnail_list_t &list = processor->imgdata.thumbs_list;
+            const libraw_thumbnail_t &chosen = processor->imgdata.thumbnail;
+            for (int i = 0; i < list.thumbcount && i < LIBRAW_THUMBNAIL_MAXCOUNT && index < 0; i++)
+            {
+                if (list.thumblist[i].tlength == chosen.tlength && list.thumblist[i].twidth == chosen.twidth)
+                    index = i;
+            }
+            ret = processor->unpack_thumb();
+        }
+        if (ret != LIBRAW_SUCCESS)
+            return std::string("Failed to unpack thumbnail: ") + libraw_strerror(ret);
+
+        int errcode = 0;
+        holder.img = processor->dcraw_make_mem_thumb(&errcode);
+        if (!holder.img || errcode != LIBRAW_SUCCESS)
+        {
+            std::string error = "Failed to create memory thumbnail: ";
+            error += errcode != LIBRAW_SUCCESS ? libraw_strerror(errcode) : "Unknown error";
+            return error;
+        }
+        return std::string();
+    }
+
+    Napi::Promise::Deferred deferred;
+    Napi::Reference<Napi::Value> pinned;
+    std::string path;
+    const uint8_t *data;
+    size_t length;
+    int index;
+    int maxSize;
+    ProcessedImageHolder holder;
+    // outlives the processor's use of it: Execute() releases the processor
+    std::unique_ptr<LibRaw_prefetch_datastream> stream;
+};
+
+Napi::Value LibRawWrapper::ExtractThumbnail(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    const uint8_t *data;
+    size_t length;
+    if (info.Length() < 1 || !(info[0].IsString() || GetSourceMemory(info[0], data, length)))
+    {
+        Napi::TypeError::New(env, "Expected file path, Buffer, Uint8Array or ArrayBuffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int index = -1;
+    int maxSize = 0;
+    if (info.Length() > 1 && info[1].IsObject())
+    {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("index") && options.Get("index").IsNumber())
+            index = std::max(0, options.Get("index").As<Napi::Number>().Int32Value());
+        if (options.Has("maxSize") && options.Get("maxSize").IsNumber())
+            maxSize = std::max(0, options.Get("maxSize").As<Napi::Number>().Int32Value());
+    }
+
+    ExtractThumbnailWorker *worker = new ExtractThumbnailWorker(env, info[0], index, maxSize);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+}
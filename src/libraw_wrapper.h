@@ -4,13 +4,24 @@
 #include <napi.h>
 #include <string>
 #include <memory>
+#include <deque>
+#include <atomic>
 #include "libraw.h"
+#include "libraw_async.h"
+#include "libraw_pool.h"
+
+class JSRangeDatastream;
 
 class LibRawWrapper : public Napi::ObjectWrap<LibRawWrapper> {
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     LibRawWrapper(const Napi::CallbackInfo& info);
     ~LibRawWrapper();
+    
+    // Shared helpers (also used by BatchProcessor)
+    // Takes ownership of img; the data Buffer frees it when collected
+    static Napi::Object CreateImageDataObject(Napi::Env env, libraw_processed_image_t* img);
+    static void ApplyOutputParams(Napi::Object params, libraw_output_params_t& out);
 
 private:
     static Napi::FunctionReference constructor;
@@ -19,6 +30,26 @@ private:
     Napi::Value LoadFile(const Napi::CallbackInfo& info);
     Napi::Value LoadBuffer(const Napi::CallbackInfo& info);
     Napi::Value Close(const Napi::CallbackInfo& info);
+    Napi::Value GetReadStats(const Napi::CallbackInfo& info);
+    
+    // Asynchronous Operations (run on the libuv thread pool, return Promises)
+    Napi::Value LoadFileAsync(const Napi::CallbackInfo& info);
+    Napi::Value LoadBufferAsync(const Napi::CallbackInfo& info);
+    Napi::Value LoadStreamAsync(const Napi::CallbackInfo& info);
+    Napi::Value UnpackAsync(const Napi::CallbackInfo& info);
+    Napi::Value UnpackThumbnailAsync(const Napi::CallbackInfo& info);
+    Napi::Value ProcessImageAsync(const Napi::CallbackInfo& info);
+    Napi::Value Raw2ImageAsync(const Napi::CallbackInfo& info);
+    Napi::Value Raw2ImageExAsync(const Napi::CallbackInfo& info);
+    Napi::Value CreateMemoryImageAsync(const Napi::CallbackInfo& info);
+    Napi::Value StreamImageAsync(const Napi::CallbackInfo& info);
+    Napi::Value EncodeJPEGAsync(const Napi::CallbackInfo& info);
+    Napi::Value ProcessPreviewAsync(const Napi::CallbackInfo& info);
+    Napi::Value ProcessRegionAsync(const Napi::CallbackInfo& info);
+    Napi::Value CreateMemoryThumbnailAsync(const Napi::CallbackInfo& info);
+    Napi::Value WritePPMAsync(const Napi::CallbackInfo& info);
+    Napi::Value WriteTIFFAsync(const Napi::CallbackInfo& info);
+    Napi::Value WriteThumbnailAsync(const Napi::CallbackInfo& info);
     
     // Metadata & Information
     Napi::Value GetMetadata(const Napi::CallbackInfo& info);
@@ -81,6 +112,9 @@ private:
     // Color Operations
     Napi::Value GetColorAt(const Napi::CallbackInfo& info);
     
+    // Threading
+    Napi::Value SetThreads(const Napi::CallbackInfo& info);
+    
     // Cancellation Support
     Napi::Value SetCancelFlag(const Napi::CallbackInfo& info);
     Napi::Value ClearCancelFlag(const Napi::CallbackInfo& info);
@@ -94,13 +128,43 @@ private:
     static Napi::Value GetCapabilities(const Napi::CallbackInfo& info);
     static Napi::Value GetCameraList(const Napi::CallbackInfo& info);
     static Napi::Value GetCameraCount(const Napi::CallbackInfo& info);
+    static Napi::Value ConfigurePool(const Napi::CallbackInfo& info);
+    static Napi::Value GetPoolStats(const Napi::CallbackInfo& info);
+    static Napi::Value ExtractThumbnail(const Napi::CallbackInfo& info);
     
     // Helper methods
-    Napi::Object CreateImageDataObject(Napi::Env env, libraw_processed_image_t* img);
     bool CheckLoaded(Napi::Env env);
-    
-    // LibRaw instance
+    bool CheckIdle(Napi::Env env);
+    bool CheckUnpacked(Napi::Env env);
+    bool EnsureUnpacked(std::string& error);
+    bool CheckStreamError(std::string& error, const char* what);
+    void AcquireProcessor();
+    
+    // Async queue: at most one worker per instance runs at a time, the rest
+    // wait in FIFO order. Only touched from the JS thread.
+    friend class LibRawAsyncWorker;
+    Napi::Value QueueAsync(Napi::Env env, const char* name, LibRawAsyncWorker::Task task, LibRawAsyncWorker::Resolver resolver = nullptr, bool waitsOnJS = false);
+    void StartAsync(LibRawAsyncWorker* worker);
+    void AsyncCompleted();
+    std::deque<LibRawAsyncWorker*> asyncQueue;
+    bool asyncRunning;
+    // OpenMP team size for this instance's async operations (0 = default)
+    std::atomic<int> ompThreads;
+    
+    // LibRaw instance, borrowed from LibRawPool. Returned by close() and
+    // borrowed again by the next load.
     std::unique_ptr<LibRaw> processor;
+    // JS memory the processor's open_buffer() datastream reads from, pinned
+    // until the next load or close() instead of copying the RAW file
+    Napi::Reference<Napi::Value> sourceBuffer;
+    // Datastream of a prefetch or loadStream() load (LibRaw doesn't own
+    // streams passed to open_datastream()); replaced after the next open has
+    // let go of it
+    std::unique_ptr<LibRaw_prefetch_datastream> sourceStream;
+    // Reader behind sourceStream after a loadStream() load (owned by it),
+    // null for other sources. Set by the loading task, read on the JS thread
+    // only between tasks
+    JSRangeDatastream* streamReader;
     bool isLoaded;
     bool isUnpacked;
     bool isProcessed;
@@ -0,0 +1,322 @@
+const LibRaw = require("../lib/index.js");
+const fs = require("fs");
+const path = require("path");
+
+/**
+ * Test asynchronous (thread pool) operations
+ */
+
+function findSampleFiles(limit = 4) {
+  const sampleImagesDir = path.join(__dirname, "..", "raw-samples-repo");
+  if (!fs.existsSync(sampleImagesDir)) {
+    return [];
+  }
+
+  const sampleFiles = [];
+  const subdirs = fs
+    .readdirSync(sampleImagesDir, { withFileTypes: true })
+    .filter((dirent) => dirent.isDirectory())
+    .map((dirent) => dirent.name);
+
+  for (const subdir of subdirs) {
+    const subdirPath = path.join(sampleImagesDir, subdir);
+    const files = fs
+      .readdirSync(subdirPath)
+      .filter((f) => f.toLowerCase().match(/\.(cr2|cr3|nef|arw|raf|rw2|dng)$/))
+      .map((f) => path.join(subdirPath, f));
+    sampleFiles.push(...files);
+  }
+
+  return sampleFiles.slice(0, limit);
+}
+
+async function testAsyncOperations() {
+  console.log("⏱️ LibRaw Async Operations Test");
+  console.log("=".repeat(40));
+
+  const sampleFiles = findSampleFiles();
+  if (sampleFiles.length === 0) {
+    console.log("\nℹ️ No RAW sample files found, skipping async tests");
+    return;
+  }
+
+  await testEventLoopResponsiveness(sampleFiles[0]);
+  await testInstanceBusyState(sampleFiles[0]);
+  await testPipelinedNativeCalls(sampleFiles[0]);
+  await testConcurrentInstances(sampleFiles);
+  await testMmapLoad(sampleFiles[0]);
+  await testMetadataOnlyLoad(sampleFiles[0]);
+  await testPrefetchLoad(sampleFiles[0]);
+
+  console.log("\n🎉 Async operations test completed!");
+  console.log("=".repeat(40));
+}
+
+async function testEventLoopResponsiveness(filePath) {
+  console.log("\n🔄 Event Loop Responsiveness:");
+
+  const processor = new LibRaw();
+  let ticks = 0;
+  const timer = setInterval(() => ticks++, 5);
+
+  try {
+    await processor.loadFile(filePath);
+    await processor.processImage();
+    const image = await processor.createMemoryImage();
+
+    if (!image || !image.data || image.data.length !== image.dataSize) {
+      throw new Error("Invalid image data returned from async pipeline");
+    }
+
+    if (ticks === 0) {
+      throw new Error("Event loop was blocked during decode");
+    }
+
+    console.log(`   ✅ Timer fired ${ticks} times while decoding`);
+  } catch (error) {
+    console.log(`   ❌ Responsiveness test failed: ${error.message}`);
+    throw error;
+  } finally {
+    clearInterval(timer);
+    await processor.close();
+  }
+}
+
+async function testInstanceBusyState(filePath) {
+  console.log("\n🔒 Per-instance Locking:");
+
+  const processor = new LibRaw();
+
+  try {
+    const loading = processor.loadFile(filePath);
+
+    let rejected = false;
+    try {
+      processor._wrapper.getMetadata();
+    } catch (error) {
+      rejected = /busy/.test(error.message);
+    }
+
+    await loading;
+
+    if (!rejected) {
+      throw new Error("Synchronous call during async load was not rejected");
+    }
+    console.log("   ✅ Synchronous access rejected while busy");
+
+    const metadata = await processor.getMetadata();
+    if (!metadata || !metadata.width) {
+      throw new Error("Metadata unavailable after async load");
+    }
+    console.log("   ✅ Instance usable again after completion");
+  } catch (error) {
+    console.log(`   ❌ Locking test failed: ${error.message}`);
+    throw error;
+  } finally {
+    await processor.close();
+  }
+}
+
+async function testPipelinedNativeCalls(filePath) {
+  console.log("\n📬 FIFO Ordering Of Queued Operations:");
+
+  const processor = new LibRaw();
+
+  try {
+    // Queue without awaiting: the native queue must run these in order
+    const results = await Promise.all([
+      processor._wrapper.loadFileAsync(filePath),
+      processor._wrapper.processImageAsync(),
+      processor._wrapper.createMemoryImageAsync(),
+    ]);
+
+    const image = results[2];
+    if (!image || !image.data || image.width <= 0) {
+      throw new Error("Queued operations did not produce an image");
+    }
+
+    console.log(`   ✅ Queued pipeline produced ${image.width}x${image.height} image`);
+  } catch (error) {
+    console.log(`   ❌ Ordering test failed: ${error.message}`);
+    throw error;
+  } finally {
+    await processor.close();
+  }
+}
+
+async function testConcurrentInstances(sampleFiles) {
+  console.log("\n🧵 Concurrent Instances:");
+
+  const startTime = Date.now();
+
+  const results = await Promise.all(
+    sampleFiles.map(async (filePath) => {
+      const processor = new LibRaw();
+      try {
+        await processor.loadFile(filePath);
+        await processor.processImage();
+        const image = await processor.createMemoryImage();
+        return { file: path.basename(filePath), success: true, image };
+      } catch (error) {
+        return { file: path.basename(filePath), success: false, error };
+      } finally {
+        await processor.close();
+      }
+    })
+  );
+
+  for (const result of results) {
+    if (result.success) {
+      console.log(
+        `   ✅ ${result.file}: ${result.image.width}x${result.image.height}`
+      );
+    } else {
+      console.log(`   ⚠️ ${result.file}: ${result.error.message}`);
+    }
+  }
+
+  if (!results.some((r) => r.success)) {
+    throw new Error("No file decoded successfully in parallel");
+  }
+
+  console.log(
+    `   ✅ ${results.length} files decoded concurrently in ${Date.now() - startTime}ms`
+  );
+}
+
+async function testMmapLoad(filePath) {
+  console.log("\n🗺️ Memory-Mapped Loading:");
+
+  const decode = async (options) => {
+    const processor = new LibRaw();
+    try {
+      await processor.loadFile(filePath, options);
+      await processor.processImage();
+      return await processor.createMemoryImage();
+    } finally {
+      await processor.close();
+    }
+  };
+
+  const buffered = await decode({});
+  const mapped = await decode({ mmap: true });
+
+  if (!buffered.data.equals(mapped.data)) {
+    throw new Error("mmap load decoded a different image");
+  }
+
+  const processor = new LibRaw();
+  try {
+    await processor.loadFile(path.join(__dirname, "missing.raw"), {
+      mmap: true,
+    });
+    throw new Error("Expected mmap load of a missing file to fail");
+  } catch (error) {
+    if (!/Failed to open file/.test(error.message)) {
+      throw error;
+    }
+  } finally {
+    await processor.close();
+  }
+
+  console.log(
+    `   ✅ mmap and buffered loads match (${mapped.width}x${mapped.height})`
+  );
+}
+
+async function testMetadataOnlyLoad(filePath) {
+  console.log("\n🏷️ Metadata-Only Loading:");
+
+  const full = new LibRaw();
+  const lazy = new LibRaw();
+
+  try {
+    await full.loadFile(filePath);
+    await lazy.loadFile(filePath, { unpack: false });
+
+    const expected = await full.getMetadata();
+    const actual = await lazy.getMetadata();
+    for (const field of ["make", "model", "width", "height", "iso"]) {
+      if (expected[field] !== actual[field]) {
+        throw new Error(
+          `Metadata-only load differs in ${field}: ${actual[field]} vs ${expected[field]}`
+        );
+      }
+    }
+    console.log(`   ✅ Metadata matches without unpacking`);
+
+    // First pixel access unpacks on demand
+    await full.processImage();
+    await lazy.processImage();
+    const fullImage = await full.createMemoryImage();
+    const lazyImage = await lazy.createMemoryImage();
+    if (!fullImage.data.equals(lazyImage.data)) {
+      throw new Error("Lazily unpacked image differs from eager load");
+    }
+    console.log(`   ✅ Lazy unpack on processImage() matches eager load`);
+  } finally {
+    await full.close();
+    await lazy.close();
+  }
+}
+
+async function testPrefetchLoad(filePath) {
+  console.log("\n📡 Prefetching Loads:");
+
+  const plain = new LibRaw();
+  const prefetched = new LibRaw();
+
+  try {
+    await plain.loadFile(filePath, { unpack: false });
+    await prefetched.loadFile(filePath, { prefetch: true, unpack: false });
+
+    if ((await plain.getReadStats()) !== null) {
+      throw new Error("getReadStats() should be null without prefetch");
+    }
+
+    const stats = await prefetched.getReadStats();
+    if (stats.fileSize !== fs.statSync(filePath).size) {
+      throw new Error(`Unexpected fileSize ${stats.fileSize}`);
+    }
+    if (stats.bytesRead <= 0 || stats.bytesRead >= stats.fileSize) {
+      throw new Error(
+        `Metadata load read ${stats.bytesRead} of ${stats.fileSize} bytes`
+      );
+    }
+
+    const expected = await plain.getMetadata();
+    const actual = await prefetched.getMetadata();
+    for (const field of ["make", "model", "width", "height", "iso"]) {
+      if (expected[field] !== actual[field]) {
+        throw new Error(
+          `Prefetch load differs in ${field}: ${actual[field]} vs ${expected[field]}`
+        );
+      }
+    }
+    console.log(
+      `   ✅ Metadata read with ${stats.bytesRead} of ${stats.fileSize} bytes in ${stats.reads} reads`
+    );
+
+    await plain.processImage();
+    await prefetched.processImage();
+    const plainImage = await plain.createMemoryImage();
+    const prefetchedImage = await prefetched.createMemoryImage();
+    if (!plainImage.data.equals(prefetchedImage.data)) {
+      throw new Error("Prefetch load decoded a different image");
+    }
+    console.log(`   ✅ Decoded image matches buffered load`);
+  } finally {
+    await plain.close();
+    await prefetched.close();
+  }
+}
+
+// Run the test
+if (require.main === module) {
+  testAsyncOperations().catch((error) => {
+    console.error(error);
+    process.exit(1);
+  });
+}
+
+module.exports = { testAsyncOperations };
@@ -0,0 +1,211 @@
+const LibRaw = require("../lib/index.js");
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+
+/**
+ * Test the native work-stealing batch decoder
+ */
+
+function findSampleFiles(limit = 6) {
+  const sampleImagesDir = path.join(__dirname, "..", "raw-samples-repo");
+  if (!fs.existsSync(sampleImagesDir)) {
+    return [];
+  }
+
+  const sampleFiles = [];
+  const subdirs = fs
+    .readdirSync(sampleImagesDir, { withFileTypes: true })
+    .filter((dirent) => dirent.isDirectory())
+    .map((dirent) => dirent.name);
+
+  for (const subdir of subdirs) {
+    const subdirPath = path.join(sampleImagesDir, subdir);
+    const files = fs
+      .readdirSync(subdirPath)
+      .filter((f) => f.toLowerCase().match(/\.(cr2|cr3|nef|arw|raf|rw2|dng)$/))
+      .map((f) => path.join(subdirPath, f));
+    sampleFiles.push(...files);
+  }
+
+  return sampleFiles.slice(0, limit);
+}
+
+async function testBatchProcessor() {
+  console.log("🏭 LibRaw Batch Processor Test");
+  console.log("=".repeat(40));
+
+  await testEmptyBatch();
+
+  const sampleFiles = findSampleFiles();
+  if (sampleFiles.length === 0) {
+    console.log("\nℹ️ No RAW sample files found, skipping batch decode tests");
+    return;
+  }
+
+  await testBatchDecode(sampleFiles);
+  await testBatchCancel(sampleFiles);
+  await testBatchBackpressure(sampleFiles);
+  await testBatchConvertToJPEGParallel(sampleFiles);
+
+  console.log("\n🎉 Batch processor test completed!");
+  console.log("=".repeat(40));
+}
+
+async function testEmptyBatch() {
+  console.log("\n📭 Empty Batch:");
+
+  const batch = new LibRaw.BatchProcessor({ threads: 2 });
+  const summary = await batch.run([], () => {
+    throw new Error("Callback must not be called for an empty batch");
+  });
+
+  if (summary.total !== 0 || batch.isRunning()) {
+    throw new Error("Empty batch did not complete cleanly");
+  }
+  console.log("   ✅ Empty batch resolves immediately");
+}
+
+async function testBatchDecode(sampleFiles) {
+  console.log("\n🧵 Parallel Decode:");
+
+  // A missing file must be reported without failing the whole batch
+  const files = [...sampleFiles, path.join(__dirname, "missing-file.cr2")];
+  const batch = new LibRaw.BatchProcessor({
+    threads: 3,
+    params: { output_bps: 8 },
+  });
+  const seen = new Set();
+
+  const summary = await batch.run(files, (result) => {
+    if (seen.has(result.index) || files[result.index] !== result.file) {
+      throw new Error(`Unexpected result for ${result.file}`);
+    }
+    seen.add(result.index);
+
+    if (result.success) {
+      if (result.image.bits !== 8 || result.image.data.length !== result.image.dataSize) {
+        throw new Error(`Invalid image for ${path.basename(result.file)}`);
+      }
+      console.log(
+        `   ✅ ${path.basename(result.file)}: ${result.image.width}x${result.image.height} in ${result.timeMs.toFixed(0)}ms`
+      );
+    } else {
+      console.log(`   ⚠️ ${path.basename(result.file)}: ${result.error}`);
+    }
+  });
+
+  if (seen.size !== files.length) {
+    throw new Error(`Expected ${files.length} results, got ${seen.size}`);
+  }
+  if (summary.failed < 1 || summary.succeeded + summary.failed !== files.length) {
+    throw new Error("Batch summary does not match delivered results");
+  }
+
+  console.log(
+    `   ✅ ${summary.succeeded}/${summary.total} decoded on ${summary.threads} threads in ${summary.totalTimeMs.toFixed(0)}ms`
+  );
+}
+
+async function testBatchCancel(sampleFiles) {
+  console.log("\n🛑 Cancellation:");
+
+  const batch = new LibRaw.BatchProcessor({ threads: 1 });
+  let delivered = 0;
+
+  const running = batch.run(sampleFiles, () => {
+    delivered++;
+  });
+  batch.cancel();
+  const summary = await running;
+
+  if (!summary.cancelled || delivered + summary.skipped !== sampleFiles.length) {
+    throw new Error("Cancelled batch summary is inconsistent");
+  }
+  console.log(`   ✅ Cancelled after ${delivered} file(s), ${summary.skipped} skipped`);
+
+  // The pool must be reusable after a cancelled run
+  const again = await batch.run(sampleFiles.slice(0, 1), () => {});
+  if (again.cancelled || again.succeeded + again.failed !== 1) {
+    throw new Error("Batch processor not reusable after cancel");
+  }
+  console.log("   ✅ Pool reusable after cancel");
+}
+
+async function testBatchBackpressure(sampleFiles) {
+  console.log("\n🚦 Backpressure:");
+
+  // Every worker waits for the Promise its callback returned, so no more
+  // results than threads can be outstanding at once
+  const threads = 2;
+  const batch = new LibRaw.BatchProcessor({ threads });
+  let outstanding = 0;
+  let peak = 0;
+  const summary = await batch.run(sampleFiles, () => {
+    outstanding++;
+    peak = Math.max(peak, outstanding);
+    return new Promise((resolve) =>
+      setTimeout(() => {
+        outstanding--;
+        resolve();
+      }, 50)
+    );
+  });
+  if (peak > threads || summary.succeeded + summary.failed !== sampleFiles.length) {
+    throw new Error(`${peak} results outstanding with ${threads} threads`);
+  }
+  console.log(`   ✅ At most ${peak} result(s) outstanding on ${threads} threads`);
+
+  // A rejected callback cancels the run and rejects it
+  try {
+    await batch.run(sampleFiles, async () => {
+      throw new Error("consumer failed");
+    });
+    throw new Error("Expected a rejecting callback to reject the run");
+  } catch (error) {
+    if (!/consumer failed/.test(error.message) || !error.summary) {
+      throw error;
+    }
+  }
+  console.log("   ✅ Callback rejection rejects the run");
+}
+
+async function testBatchConvertToJPEGParallel(sampleFiles) {
+  console.log("\n🖼️ batchConvertToJPEGParallel:");
+
+  const outputDir = fs.mkdtempSync(path.join(os.tmpdir(), "libraw-batch-"));
+
+  try {
+    const result = await LibRaw.batchConvertToJPEGParallel(
+      sampleFiles,
+      outputDir,
+      { maxConcurrency: 2, quality: 80 }
+    );
+
+    if (result.totalFiles !== sampleFiles.length || result.results.length !== sampleFiles.length) {
+      throw new Error("Result count does not match input count");
+    }
+
+    for (const entry of result.results) {
+      if (entry.success && !fs.existsSync(entry.outputPath)) {
+        throw new Error(`Missing output for ${entry.inputPath}`);
+      }
+    }
+
+    console.log(
+      `   ✅ ${result.successCount}/${result.totalFiles} converted in ${result.totalProcessingTime}ms`
+    );
+  } finally {
+    fs.rmSync(outputDir, { recursive: true, force: true });
+  }
+}
+
+// Run the test
+if (require.main === module) {
+  testBatchProcessor().catch((error) => {
+    console.error(error);
+    process.exit(1);
+  });
+}
+
+module.exports = { testBatchProcessor };
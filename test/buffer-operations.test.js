@@ -1,5 +1,6 @@
 const LibRaw = require("../lib/index.js");
 const fs = require("fs");
+const os = require("os");
 const path = require("path");
 
 /**
@@ -47,6 +48,9 @@ async function testBufferOperations() {
   console.log(`\n📁 Testing with: ${sampleFiles[0]}`);
 
   await testWithRealFile(testFile);
+  await testBufferSourceTypes(testFile);
+  await testStreamSource(testFile);
+  await testImageStream(testFile);
 }
 
 async function testWithRealFile(filePath) {
@@ -151,6 +155,22 @@ async function testWithRealFile(filePath) {
       } else {
         console.log("   ⚠️ Memory images differ in size");
       }
+
+      // The data Buffer adopts LibRaw's allocation, so it must stay valid
+      // after the processor has been recycled
+      const head = image1.data.readUInt32LE(0);
+      const tail = image1.data.readUInt32LE(image1.data.length - 4);
+      await processor1.close();
+
+      if (
+        image1.data.length === image1.dataSize &&
+        image1.data.readUInt32LE(0) === head &&
+        image1.data.readUInt32LE(image1.data.length - 4) === tail
+      ) {
+        console.log("   ✅ Memory image data survives processor close");
+      } else {
+        console.log("   ❌ Memory image data changed after processor close");
+      }
     } catch (e) {
       console.log(`   ⚠️ Memory image creation: ${e.message}`);
     }
@@ -162,6 +182,285 @@ async function testWithRealFile(filePath) {
   }
 }
 
+async function testBufferSourceTypes(filePath) {
+  console.log("\n🧷 Buffer Source Types:");
+
+  const fileData = fs.readFileSync(filePath);
+  const arrayBuffer = fileData.buffer.slice(
+    fileData.byteOffset,
+    fileData.byteOffset + fileData.length
+  );
+  const shared = new Uint8Array(new SharedArrayBuffer(fileData.length));
+  shared.set(fileData);
+
+  const sources = [
+    { name: "Buffer", make: () => Buffer.from(fileData) },
+    { name: "ArrayBuffer", make: () => arrayBuffer },
+    { name: "SharedArrayBuffer view", make: () => shared },
+  ];
+
+  let reference = null;
+  for (const source of sources) {
+    const processor = new LibRaw();
+    try {
+      // Drop our own reference right away: the loaded image must keep the
+      // memory alive by itself while unpackThumbnail() reads from it
+      await processor.loadBuffer(source.make());
+      if (global.gc) global.gc();
+
+      await processor.processImage();
+      const image = await processor.createMemoryImage();
+      await processor.unpackThumbnail();
+
+      if (reference === null) {
+        reference = image.data;
+      } else if (!reference.equals(image.data)) {
+        throw new Error(`${source.name} decoded a different image`);
+      }
+      console.log(`   ✅ ${source.name}: ${image.width}x${image.height}`);
+    } finally {
+      await processor.close();
+    }
+  }
+
+  try {
+    await new LibRaw().loadBuffer(new Uint16Array(16));
+    throw new Error("Expected a Uint16Array source to be rejected");
+  } catch (error) {
+    if (!/Expected Buffer/.test(error.message)) {
+      throw error;
+    }
+    console.log("   ✅ Non-byte typed array rejected");
+  }
+}
+
+async function testStreamSource(filePath) {
+  console.log("\n🌊 Range-Read Stream Source:");
+
+  const handle = await fs.promises.open(filePath, "r");
+  const size = (await handle.stat()).size;
+  const ranges = [];
+  const source = {
+    size,
+    async read(offset, length) {
+      ranges.push([offset, length]);
+      const buffer = Buffer.alloc(length);
+      const { bytesRead } = await handle.read(buffer, 0, length, offset);
+      return buffer.subarray(0, bytesRead);
+    },
+  };
+
+  const fromFile = new LibRaw();
+  const fromStream = new LibRaw();
+  try {
+    await fromFile.loadFile(filePath);
+    await fromStream.loadStream(source, { unpack: false, blockSize: 65536 });
+
+    const stats = await fromStream.getReadStats();
+    if (stats.reads !== ranges.length || stats.bytesRead >= size) {
+      throw new Error(
+        `Unexpected metadata I/O: ${stats.bytesRead} bytes in ${stats.reads} reads`
+      );
+    }
+    const expected = await fromFile.getMetadata();
+    const actual = await fromStream.getMetadata();
+    if (expected.make !== actual.make || expected.width !== actual.width) {
+      throw new Error("Stream load returned different metadata");
+    }
+    console.log(
+      `   ✅ Metadata from ${stats.bytesRead} of ${size} bytes in ${stats.reads} range reads`
+    );
+
+    await fromFile.processImage();
+    await fromStream.processImage();
+    const fileImage = await fromFile.createMemoryImage();
+    const streamImage = await fromStream.createMemoryImage();
+    if (!fileImage.data.equals(streamImage.data)) {
+      throw new Error("Stream load decoded a different image");
+    }
+    console.log(`   ✅ Decoded image matches file load`);
+  } finally {
+    await fromFile.close();
+    await fromStream.close();
+    await handle.close();
+  }
+
+  const failing = new LibRaw();
+  try {
+    await failing.loadStream({
+      size,
+      read: async () => {
+        throw new Error("blob store unavailable");
+      },
+    });
+    throw new Error("Expected a failing reader to reject the load");
+  } catch (error) {
+    if (!/blob store unavailable/.test(error.message)) {
+      throw error;
+    }
+    console.log("   ✅ Reader errors reject the load");
+  } finally {
+    await failing.close();
+  }
+
+  // A reader failing mid-decode must fail the lazy unpack, not hand back an
+  // image decoded from short reads
+  const failHandle = await fs.promises.open(filePath, "r");
+  const lazy = new LibRaw();
+  let broken = false;
+  try {
+    await lazy.loadStream(
+      {
+        size,
+        async read(offset, length) {
+          if (broken) {
+            throw new Error("connection reset");
+          }
+          const buffer = Buffer.alloc(length);
+          const { bytesRead } = await failHandle.read(buffer, 0, length, offset);
+          return buffer.subarray(0, bytesRead);
+        },
+      },
+      { unpack: false }
+    );
+    broken = true;
+    await lazy.processImage();
+    throw new Error("Expected a reader failing mid-unpack to reject");
+  } catch (error) {
+    if (!/connection reset/.test(error.message)) {
+      throw error;
+    }
+    console.log("   ✅ Reader errors during a lazy unpack reject it");
+  } finally {
+    await lazy.close();
+    await failHandle.close();
+  }
+
+  // More stream loads than libuv pool threads, each reading through
+  // fs.promises (which needs the pool): stream tasks must not occupy pool
+  // threads while they wait for a read
+  const poolSize = Number(process.env.UV_THREADPOOL_SIZE) || 4;
+  const concurrent = poolSize * 2;
+  const handles = [];
+  const loaders = [];
+  try {
+    for (let i = 0; i < concurrent; i++) {
+      const fileHandle = await fs.promises.open(filePath, "r");
+      handles.push(fileHandle);
+      const loader = new LibRaw();
+      loaders.push(loader);
+    }
+    await Promise.all(
+      loaders.map((loader, i) =>
+        loader.loadStream({
+          size,
+          async read(offset, length) {
+            const buffer = Buffer.alloc(length);
+            const { bytesRead } = await handles[i].read(buffer, 0, length, offset);
+            return buffer.subarray(0, bytesRead);
+          },
+        })
+      )
+    );
+    console.log(
+      `   ✅ ${concurrent} concurrent stream loads with a ${poolSize}-thread pool`
+    );
+  } finally {
+    for (const loader of loaders) await loader.close();
+    for (const fileHandle of handles) await fileHandle.close();
+  }
+}
+
+async function testImageStream(filePath) {
+  console.log("\n🎞️ Row-Band Image Stream:");
+
+  const processor = new LibRaw();
+  try {
+    await processor.loadFile(filePath);
+    await processor.processImage();
+    const image = await processor.createMemoryImage();
+
+    // Small bands and a slow consumer exercise the backpressure path
+    const stream = processor.createImageStream({ bandRows: 17 });
+    let info = null;
+    stream.once("info", (value) => {
+      info = value;
+    });
+    const chunks = [];
+    for await (const chunk of stream) {
+      chunks.push(chunk);
+      if (chunks.length % 32 === 0) {
+        await new Promise((resolve) => setImmediate(resolve));
+      }
+    }
+    const streamed = Buffer.concat(chunks);
+
+    if (!info || info.width !== image.width || info.height !== image.height) {
+      throw new Error("Stream info does not match the memory image");
+    }
+    if (chunks[0].length !== 17 * image.width * image.colors * (image.bits / 8)) {
+      throw new Error(`Unexpected band size ${chunks[0].length}`);
+    }
+    if (!streamed.equals(image.data)) {
+      throw new Error("Streamed rows differ from createMemoryImage()");
+    }
+    console.log(
+      `   ✅ ${chunks.length} bands match the ${image.width}x${image.height} memory image`
+    );
+
+    // Destroying the stream stops the native conversion
+    const early = processor.createImageStream({ bandRows: 8 });
+    await new Promise((resolve, reject) => {
+      early.once("data", () => {
+        early.destroy();
+        resolve();
+      });
+      early.once("error", reject);
+    });
+    // Queued behind the stopped stream, so this only resolves once it ended
+    await processor._wrapper.createMemoryImageAsync();
+    console.log("   ✅ Destroyed stream releases the processor");
+  } finally {
+    await processor.close();
+  }
+
+  // More piped streams than libuv pool threads: the file writes need the
+  // pool, so stream conversions must not hold pool threads while they wait
+  const poolSize = Number(process.env.UV_THREADPOOL_SIZE) || 4;
+  const concurrent = poolSize * 2;
+  const processors = [];
+  const outputs = [];
+  try {
+    for (let i = 0; i < concurrent; i++) {
+      const piped = new LibRaw();
+      processors.push(piped);
+      await piped.loadFile(filePath);
+      await piped.setOutputParams({ half_size: true });
+      await piped.processImage();
+      outputs.push(path.join(os.tmpdir(), `libraw-band-pipe-${process.pid}-${i}.rgb`));
+    }
+    await Promise.all(
+      processors.map(
+        (piped, i) =>
+          new Promise((resolve, reject) => {
+            const source = piped.createImageStream({ bandRows: 8 });
+            const sink = fs.createWriteStream(outputs[i], { highWaterMark: 1024 });
+            source.once("error", reject);
+            sink.once("error", reject);
+            sink.once("finish", resolve);
+            source.pipe(sink);
+          })
+      )
+    );
+    console.log(
+      `   ✅ ${concurrent} piped image streams with a ${poolSize}-thread pool`
+    );
+  } finally {
+    for (const piped of processors) await piped.close();
+    for (const output of outputs) fs.rmSync(output, { force: true });
+  }
+}
+
 async function testWithSyntheticData() {
   console.log("\n🧪 Synthetic Buffer Tests:");
 
@@ -34,6 +34,7 @@ async function testConfiguration() {
     await testOutputParameters(processor);
     await testParameterValidation(processor);
     await testParameterRanges(processor);
+    testThreadSettings(processor);
 
     await processor.close();
   } catch (error) {
@@ -215,6 +216,35 @@ async function testParameterValidation(processor) {
   }
 }
 
+function testThreadSettings(processor) {
+  console.log("\n🧵 Thread Settings Tests:");
+
+  try {
+    const team = processor.setThreads(2);
+    if (team !== 2 && team !== 1) {
+      throw new Error(`Unexpected team size ${team}`);
+    }
+    console.log(
+      `   ✅ setThreads(2): team size ${team}${team === 1 ? " (built without OpenMP)" : ""}`
+    );
+
+    const defaultTeam = processor.setThreads(0);
+    if (!Number.isInteger(defaultTeam) || defaultTeam < 1) {
+      throw new Error(`Invalid default team size ${defaultTeam}`);
+    }
+    console.log(`   ✅ setThreads(0): default team size ${defaultTeam}`);
+  } catch (error) {
+    console.log(`   ❌ Thread settings failed: ${error.message}`);
+  }
+
+  try {
+    processor.setThreads(-1);
+    console.log("   ❌ Negative thread count: Should have thrown error");
+  } catch (error) {
+    console.log("   ✅ Negative thread count: Correctly rejected");
+  }
+}
+
 async function testParameterRanges(processor) {
   console.log("\n📏 Parameter Range Tests:");
 
@@ -0,0 +1,132 @@
+const LibRaw = require("../lib/index.js");
+const fs = require("fs");
+const path = require("path");
+
+/**
+ * Decode the synthetic tiled DNGs in test/fixtures/dng single-threaded and
+ * with the OpenMP tile-parallel decoders, from a file and from a buffer, and
+ * compare the output byte for byte
+ */
+
+const fixturesDir = path.join(__dirname, "fixtures", "dng");
+
+const LIBRAW_CAPS_ZLIB = 0x40;
+
+// The same pixels in every encoding; all must decode to the same image
+const intactFixtures = [
+  "tiled-lossless.dng",
+  "tiled-lossless-restart.dng",
+  "tiled-packed-10bit.dng",
+  "tiled-packed-16bit.dng",
+];
+
+// Fixed processing, so that the outputs depend on the raw data only
+const params = {
+  output_bps: 16,
+  no_auto_bright: true,
+  use_camera_wb: false,
+  user_qual: 0,
+};
+
+async function decode(file, { threads, fromBuffer }) {
+  const processor = new LibRaw();
+  try {
+    const team = processor.setThreads(threads);
+    if (fromBuffer) {
+      await processor.loadBuffer(fs.readFileSync(file));
+    } else {
+      await processor.loadFile(file);
+    }
+    await processor.setOutputParams(params);
+    await processor.processImage();
+    const image = await processor.createMemoryImage();
+    return { team, data: Buffer.from(image.data) };
+  } finally {
+    await processor.close();
+  }
+}
+
+async function decodeAllWays(file) {
+  const serial = await decode(file, { threads: 1 });
+  const parallel = await decode(file, { threads: 4 });
+  const parallelBuffer = await decode(file, { threads: 4, fromBuffer: true });
+  if (!serial.data.equals(parallel.data)) {
+    throw new Error(`${path.basename(file)}: parallel decode differs from single-threaded`);
+  }
+  if (!serial.data.equals(parallelBuffer.data)) {
+    throw new Error(`${path.basename(file)}: parallel buffer decode differs from single-threaded`);
+  }
+  return { data: serial.data, team: parallel.team };
+}
+
+async function expectRejected(file) {
+  for (const options of [{ threads: 1 }, { threads: 4 }, { threads: 4, fromBuffer: true }]) {
+    let failed = false;
+    try {
+      await decode(file, options);
+    } catch (error) {
+      failed = true;
+    }
+    if (!failed) {
+      throw new Error(`${path.basename(file)} decoded with ${JSON.stringify(options)}`);
+    }
+  }
+}
+
+async function testDngTiles() {
+  console.log("🧩 LibRaw Tiled DNG Test");
+  console.log("=".repeat(40));
+
+  let reference = null;
+  for (const name of intactFixtures) {
+    const { data, team } = await decodeAllWays(path.join(fixturesDir, name));
+    if (reference && !reference.equals(data)) {
+      throw new Error(`${name} decodes differently from ${intactFixtures[0]}`);
+    }
+    reference = reference || data;
+    console.log(`   ✅ ${name}: 1 and ${team} threads identical`);
+  }
+
+  // A tile with a damaged JPEG header is left empty; the rest still decodes
+  const damaged = await decodeAllWays(
+    path.join(fixturesDir, "tiled-lossless-bad-tile.dng")
+  );
+  if (damaged.data.equals(reference)) {
+    throw new Error("tiled-lossless-bad-tile.dng decodes like the intact file");
+  }
+  console.log("   ✅ tiled-lossless-bad-tile.dng: decoded partially, 1 and N threads identical");
+
+  // Data cut short inside a tile fails the decode on every path
+  await expectRejected(path.join(fixturesDir, "tiled-lossless-truncated.dng"));
+  console.log("   ✅ tiled-lossless-truncated.dng: rejected with 1 and N threads");
+
+  await testFloatTiles();
+
+  console.log("\n🎉 Tiled DNG test completed!");
+  console.log("=".repeat(40));
+}
+
+// Deflate-compressed floating-point tiles are inflated in parallel
+async function testFloatTiles() {
+  if (!(LibRaw.getCapabilities() & LIBRAW_CAPS_ZLIB)) {
+    console.log("\nℹ️ LibRaw built without zlib, skipping floating-point DNG tests");
+    return;
+  }
+
+  const { team } = await decodeAllWays(path.join(fixturesDir, "tiled-float.dng"));
+  console.log(`   ✅ tiled-float.dng: 1 and ${team} threads identical`);
+
+  // A tile that does not inflate fails the decode on every path
+  await expectRejected(path.join(fixturesDir, "tiled-float-bad-tile.dng"));
+  console.log("   ✅ tiled-float-bad-tile.dng: rejected with 1 and N threads");
+}
+
+// Run the test
+if (require.main === module) {
+  testDngTiles().catch((error) => {
+    console.error(error);
+    process.exit(1);
+  });
+}
+
+module.exports = { testDngTiles };
@@ -0,0 +1,373 @@
+const fs = require("fs");
+const path = require("path");
+const zlib = require("zlib");
+
+/**
+ * Writes the small synthetic tiled DNGs in test/fixtures/dng. Every integer
+ * fixture stores the same 10-bit CFA image, so they must all decode to the
+ * same pixels whatever the tile encoding; the floating-point fixtures hold
+ * a deflate-compressed HDR image. Run `node test/fixtures/make-dng-fixtures.js`
+ * to regenerate them.
+ */
+
+const WIDTH = 160;
+const HEIGHT = 96;
+const BITS = 10;
+
+// Deterministic LCG, so the fixtures do not change between runs
+function random(seed) {
+  let state = seed >>> 0;
+  return () => {
+    state = (Math.imul(state, 1664525) + 1013904223) >>> 0;
+    return state / 0x100000000;
+  };
+}
+
+function makePixels() {
+  const next = random(20231);
+  const max = (1 << BITS) - 1;
+  const pixels = [];
+  for (let y = 0; y < HEIGHT; y++) {
+    const row = [];
+    for (let x = 0; x < WIDTH; x++) {
+      let v = ((x * 7 + y * 3) % 900) + Math.floor(next() * 81) - 40;
+      if (next() < 0.01) v = Math.floor(next() * (max + 1));
+      row.push(Math.max(0, Math.min(max, v)));
+    }
+    pixels.push(row);
+  }
+  return pixels;
+}
+
+function makeFloatPixels() {
+  const next = random(7);
+  const pixels = [];
+  for (let y = 0; y < HEIGHT; y++) {
+    const row = [];
+    for (let x = 0; x < WIDTH; x++) {
+      row.push(((x * 3 + y * 2) % 5000) / 10 + Math.floor(next() * 16) / 16);
+    }
+    pixels.push(row);
+  }
+  return pixels;
+}
+
+// MSB-first bit packer; JPEG entropy data stuffs a zero byte after 0xff
+class BitWriter {
+  constructor(stuffing = true) {
+    this.stuffing = stuffing;
+    this.bytes = [];
+    this.acc = 0;
+    this.count = 0;
+  }
+
+  put(value, bits) {
+    for (let i = bits - 1; i >= 0; i--) {
+      this.acc = (this.acc << 1) | ((value >> i) & 1);
+      if (++this.count === 8) {
+        this.bytes.push(this.acc);
+        if (this.acc === 0xff && this.stuffing) this.bytes.push(0);
+        this.acc = 0;
+        this.count = 0;
+      }
+    }
+  }
+
+  align() {
+    if (this.count) this.put((1 << (8 - this.count)) - 1, 8 - this.count);
+  }
+}
+
+// Code lengths of difference categories 0-16 for the Huffman table
+const CODE_LENGTHS = [3, 3, 3, 3, 3, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14];
+
+function huffmanCodes() {
+  const symbols = [...CODE_LENGTHS.keys()].sort(
+    (a, b) => CODE_LENGTHS[a] - CODE_LENGTHS[b] || a - b
+  );
+  const codes = [];
+  let code = 0;
+  let previous = 0;
+  for (const symbol of symbols) {
+    code <<= CODE_LENGTHS[symbol] - previous;
+    previous = CODE_LENGTHS[symbol];
+    codes[symbol] = { code: code++, length: previous };
+  }
+  return { symbols, codes };
+}
+
+function segment(marker, payload) {
+  const header = Buffer.alloc(4);
+  header.writeUInt16BE(marker, 0);
+  header.writeUInt16BE(payload.length + 2, 2);
+  return Buffer.concat([header, Buffer.from(payload)]);
+}
+
+// One lossless JPEG (SOF3, predictor 1) tile, optionally with restart markers
+function losslessTile(tile, restartRows) {
+  const height = tile.length;
+  const width = tile[0].length;
+  const { symbols, codes } = huffmanCodes();
+  const counts = new Array(16).fill(0);
+  for (const length of CODE_LENGTHS) counts[length - 1]++;
+
+  const parts = [Buffer.from([0xff, 0xd8])];
+  parts.push(segment(0xffc4, [0, ...counts, ...symbols]));
+  parts.push(
+    segment(0xffc3, [BITS, height >> 8, height & 0xff, width >> 8, width & 0xff, 1, 1, 0x11, 0])
+  );
+  if (restartRows) {
+    const interval = restartRows * width;
+    parts.push(segment(0xffdd, [interval >> 8, interval & 0xff]));
+  }
+  parts.push(segment(0xffda, [1, 1, 0, 1, 0, 0]));
+
+  const bits = new BitWriter();
+  let restart = 0;
+  for (let y = 0; y < height; y++) {
+    const restarted = restartRows && y % restartRows === 0;
+    if (restarted && y) {
+      bits.align();
+      bits.bytes.push(0xff, 0xd0 + restart);
+      restart = (restart + 1) & 7;
+    }
+    for (let x = 0; x < width; x++) {
+      let predictor;
+      if (x) predictor = tile[y][x - 1];
+      else if (y && !restarted) predictor = tile[y - 1][0];
+      else predictor = 1 << (BITS - 1);
+      const diff = tile[y][x] - predictor;
+      const category = diff ? Math.abs(diff).toString(2).length : 0;
+      bits.put(codes[category].code, codes[category].length);
+      if (category) bits.put(diff > 0 ? diff : diff + (1 << category) - 1, category);
+    }
+  }
+  bits.align();
+  parts.push(Buffer.from(bits.bytes), Buffer.from([0xff, 0xd9]));
+  return Buffer.concat(parts);
+}
+
+// One uncompressed tile: 16-bit little-endian samples, or MSB-first packed
+// rows padded to whole bytes
+function packedTile(tile, bps) {
+  const rows = tile.map((row) => {
+    if (bps === 16) {
+      const buffer = Buffer.alloc(row.length * 2);
+      row.forEach((v, i) => buffer.writeUInt16LE(v, i * 2));
+      return buffer;
+    }
+    const bits = new BitWriter(false);
+    for (const v of row) bits.put(v, bps);
+    bits.align();
+    return Buffer.from(bits.bytes);
+  });
+  return Buffer.concat(rows);
+}
+
+// One deflate tile of 32-bit floats with the floating-point predictor (3):
+// each row's big-endian bytes are split into byte planes, then differenced
+function floatTile(tile) {
+  const rows = tile.map((row) => {
+    const samples = Buffer.alloc(row.length * 4);
+    row.forEach((v, i) => samples.writeFloatBE(v, i * 4));
+    const planes = Buffer.alloc(samples.length);
+    for (let plane = 0; plane < 4; plane++) {
+      for (let i = 0; i < row.length; i++) {
+        planes[plane * row.length + i] = samples[i * 4 + plane];
+      }
+    }
+    for (let i = planes.length - 1; i > 0; i--) {
+      planes[i] = (planes[i] - planes[i - 1]) & 0xff;
+    }
+    return planes;
+  });
+  return zlib.deflateSync(Buffer.concat(rows), { level: 6 });
+}
+
+function cutTiles(pixels, tileWidth, tileLength) {
+  const tiles = [];
+  for (let ty = 0; ty < HEIGHT; ty += tileLength) {
+    for (let tx = 0; tx < WIDTH; tx += tileWidth) {
+      const tile = [];
+      for (let y = 0; y < tileLength; y++) {
+        const row = [];
+        for (let x = 0; x < tileWidth; x++) {
+          row.push(pixels[Math.min(ty + y, HEIGHT - 1)][Math.min(tx + x, WIDTH - 1)]);
+        }
+        tile.push(row);
+      }
+      tiles.push(tile);
+    }
+  }
+  return tiles;
+}
+
+// Bytes per value; RATIONAL/SRATIONAL values are listed as two numbers
+const TYPE_SIZE = { 1: 1, 2: 1, 3: 2, 4: 4, 10: 4 };
+
+function packValues(type, values) {
+  const buffer = Buffer.alloc(values.length * TYPE_SIZE[type]);
+  values.forEach((v, i) => {
+    if (type === 1 || type === 2) buffer.writeUInt8(v, i);
+    else if (type === 3) buffer.writeUInt16LE(v, i * 2);
+    else if (type === 4) buffer.writeUInt32LE(v, i * 4);
+    else buffer.writeInt32LE(v, i * 4);
+  });
+  return buffer;
+}
+
+// Little-endian single-IFD DNG with a 2x2 RGGB CFA and the given tiles
+function writeDNG(file, { tileWidth, tileLength, bps, compression, tiles, extraTags = [] }) {
+  const ascii = (s) => [...Buffer.from(s + "\0")];
+  const tags = [
+    [254, 4, [0]],
+    [256, 4, [WIDTH]],
+    [257, 4, [HEIGHT]],
+    [258, 3, [bps]],
+    [259, 3, [compression]],
+    [262, 3, [32803]],
+    [271, 2, ascii("Synthetic")],
+    [272, 2, ascii("TileTest")],
+    [277, 3, [1]],
+    [284, 3, [1]],
+    [322, 4, [tileWidth]],
+    [323, 4, [tileLength]],
+    [324, 4, new Array(tiles.length).fill(0)],
+    [325, 4, tiles.map((t) => t.length)],
+    [33421, 3, [2, 2]],
+    [33422, 1, [0, 1, 1, 2]],
+    [50706, 1, [1, 4, 0, 0]],
+    [50708, 2, ascii("Synthetic TileTest")],
+    [50721, 10, [1, 1, 0, 1, 0, 1, 0, 1, 1, 1, 0, 1, 0, 1, 0, 1, 1, 1]],
+    [50778, 3, [21]],
+    ...extraTags,
+  ].sort((a, b) => a[0] - b[0]);
+
+  const entriesEnd = 8 + 2 + 12 * tags.length + 4;
+  const records = [];
+  let extra = Buffer.alloc(0);
+  for (const [tag, type, values] of tags) {
+    const raw = packValues(type, values);
+    const count = type === 10 ? values.length / 2 : values.length;
+    let offset = null;
+    if (raw.length > 4) {
+      offset = entriesEnd + extra.length;
+      extra = Buffer.concat([extra, raw, Buffer.alloc(raw.length & 1)]);
+    }
+    records.push({ tag, type, count, raw, offset });
+  }
+
+  let position = entriesEnd + extra.length;
+  const offsets = tiles.map((t) => {
+    const at = position;
+    position += t.length + (t.length & 1);
+    return at;
+  });
+  const offsetRecord = records.find((r) => r.tag === 324);
+  const offsetData = packValues(4, offsets);
+  if (offsetRecord.offset !== null) {
+    offsetData.copy(extra, offsetRecord.offset - entriesEnd);
+  } else {
+    offsetRecord.raw = offsetData;
+  }
+
+  const header = Buffer.alloc(entriesEnd);
+  header.write("II*\0", 0, "latin1");
+  header.writeUInt32LE(8, 4);
+  header.writeUInt16LE(records.length, 8);
+  records.forEach((r, i) => {
+    const at = 10 + i * 12;
+    header.writeUInt16LE(r.tag, at);
+    header.writeUInt16LE(r.type, at + 2);
+    header.writeUInt32LE(r.count, at + 4);
+    if (r.offset !== null) header.writeUInt32LE(r.offset, at + 8);
+    else r.raw.copy(header, at + 8);
+  });
+
+  const body = tiles.flatMap((t) => [t, Buffer.alloc(t.length & 1)]);
+  const data = Buffer.concat([header, extra, ...body]);
+  fs.writeFileSync(file, data);
+  return data;
+}
+
+function makeFixtures(dir = path.join(__dirname, "dng")) {
+  fs.mkdirSync(dir, { recursive: true });
+  const pixels = makePixels();
+  const lossless = (restartRows) => (tile, i) =>
+    losslessTile(tile, i % 2 ? 0 : restartRows);
+
+  const ljTiles = cutTiles(pixels, 48, 48).map(lossless(0));
+  const lj = writeDNG(path.join(dir, "tiled-lossless.dng"), {
+    tileWidth: 48,
+    tileLength: 48,
+    bps: BITS,
+    compression: 7,
+    tiles: ljTiles,
+  });
+
+  writeDNG(path.join(dir, "tiled-lossless-restart.dng"), {
+    tileWidth: 48,
+    tileLength: 48,
+    bps: BITS,
+    compression: 7,
+    tiles: cutTiles(pixels, 48, 48).map(lossless(8)),
+  });
+
+  writeDNG(path.join(dir, "tiled-packed-10bit.dng"), {
+    tileWidth: 50,
+    tileLength: 48,
+    bps: 10,
+    compression: 1,
+    tiles: cutTiles(pixels, 50, 48).map((t) => packedTile(t, 10)),
+  });
+
+  writeDNG(path.join(dir, "tiled-packed-16bit.dng"), {
+    tileWidth: 48,
+    tileLength: 48,
+    bps: 16,
+    compression: 1,
+    tiles: cutTiles(pixels, 48, 48).map((t) => packedTile(t, 16)),
+    extraTags: [[50717, 4, [(1 << BITS) - 1]]],
+  });
+
+  // The third tile's JPEG header is damaged: that tile decodes empty
+  const damaged = ljTiles.map((t, i) => (i === 2 ? Buffer.concat([Buffer.from([0, 0]), t.subarray(2)]) : t));
+  writeDNG(path.join(dir, "tiled-lossless-bad-tile.dng"), {
+    tileWidth: 48,
+    tileLength: 48,
+    bps: BITS,
+    compression: 7,
+    tiles: damaged,
+  });
+
+  // Cut in the middle of the tile data
+  fs.writeFileSync(path.join(dir, "tiled-lossless-truncated.dng"), lj.subarray(0, Math.floor(lj.length * 0.6)));
+
+  const floatTiles = cutTiles(makeFloatPixels(), 64, 64).map(floatTile);
+  const float = {
+    tileWidth: 64,
+    tileLength: 64,
+    bps: 32,
+    compression: 8,
+    extraTags: [
+      [317, 3, [3]],
+      [339, 3, [3]],
+    ],
+  };
+  writeDNG(path.join(dir, "tiled-float.dng"), { ...float, tiles: floatTiles });
+
+  // The fourth tile's deflate stream is damaged: the decode fails
+  const corrupt = floatTiles.map((t, i) => {
+    if (i !== 3) return t;
+    const copy = Buffer.from(t);
+    copy.fill(0xa5, 2, Math.min(copy.length, 66));
+    return copy;
+  });
+  writeDNG(path.join(dir, "tiled-float-bad-tile.dng"), { ...float, tiles: corrupt });
+}
+
+if (require.main === module) {
+  makeFixtures();
+}
+
+module.exports = { makeFixtures, WIDTH, HEIGHT, BITS };
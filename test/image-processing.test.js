@@ -16,6 +16,8 @@ class ImageProcessingTests {
       processing: {},
       memory: {},
       output: {},
+      preview: {},
+      region: {},
     };
     this.testFiles = [];
   }
@@ -622,6 +624,173 @@ class ImageProcessingTests {
     }
   }
 
+  async testPreviewProcessing() {
+    console.log("\n🖼️ Testing Preview Processing");
+    console.log("=============================");
+
+    if (this.testFiles.length === 0) {
+      this.log("No test files available for preview testing", "warning");
+      return false;
+    }
+
+    const processor = new LibRaw();
+
+    try {
+      await processor.loadFile(this.testFiles[0]);
+      const size = await processor.getImageSize();
+      const longEdge = Math.max(size.width, size.height);
+
+      for (const maxEdge of [Math.floor(longEdge / 2), 512]) {
+        const start = Date.now();
+        const preview = await processor.processPreview({ maxEdge });
+        const previewEdge = Math.max(preview.width, preview.height);
+        if (previewEdge < maxEdge || previewEdge >= 2 * maxEdge + 2) {
+          throw new Error(
+            `Preview for maxEdge ${maxEdge} is ${preview.width}x${preview.height}`
+          );
+        }
+        if (preview.data.length !== preview.width * preview.height * 3) {
+          throw new Error("Preview data size does not match its dimensions");
+        }
+        this.log(
+          `maxEdge ${maxEdge}: ${preview.width}x${preview.height} in ${Date.now() - start}ms`,
+          "data"
+        );
+      }
+
+      // The caller's output parameters survive, and full processing still
+      // yields the full-size image
+      const params = await processor.getOutputParams();
+      if (params.half_size || params.half_size_bin) {
+        throw new Error("processPreview() changed the output parameters");
+      }
+      await processor.processImage();
+      const full = await processor.createMemoryImage();
+      if (Math.max(full.width, full.height) < longEdge - 2) {
+        throw new Error(`Full image is only ${full.width}x${full.height}`);
+      }
+      this.log(`Full processing after preview: ${full.width}x${full.height}`, "success");
+
+      await processor.close();
+      this.results.preview = { success: true };
+      return true;
+    } catch (error) {
+      this.log(`Preview processing test failed: ${error.message}`, "error");
+      await processor.close();
+      this.results.preview = { success: false, error: error.message };
+      return false;
+    }
+  }
+
+  async testRegionProcessing() {
+    console.log("\n🔲 Testing Region Processing");
+    console.log("============================");
+
+    if (this.testFiles.length === 0) {
+      this.log("No test files available for region testing", "warning");
+      return false;
+    }
+
+    const processor = new LibRaw();
+
+    try {
+      await processor.loadFile(this.testFiles[0]);
+      // Auto-brightness follows the processed area's histogram
+      await processor.setOutputParams({ no_auto_bright: true });
+
+      let start = Date.now();
+      await processor.processImage();
+      const full = await processor.createMemoryImage();
+      const fullTime = Date.now() - start;
+
+      // Regions are cut from a cropped run where LibRaw can crop exactly
+      // (square pixels, no Fuji rotation); for Bayer data these must be the
+      // same bytes as the full run, anything else is compared loosely
+      const metadata = await processor.getMetadata();
+      const sameFrame =
+        (full.width === metadata.width && full.height === metadata.height) ||
+        (full.width === metadata.height && full.height === metadata.width);
+      const bayer = metadata.filters !== 0 && metadata.filters !== 9;
+      const exact = bayer && sameFrame && !(await processor.isFujiRotated());
+
+      // Odd offsets and sizes, one region touching the image corner; the
+      // oversized halo is clamped to the frame
+      const regions = [
+        [Math.floor(full.width / 3) + 1, Math.floor(full.height / 3), 257, 131, {}],
+        [full.width - 96, full.height - 64, 96, 64, {}],
+        [5, 3, 64, 48, { halo: 2147483647 }],
+      ];
+      for (const [x, y, width, height, options] of regions) {
+        start = Date.now();
+        const region = await processor.processRegion(x, y, width, height, options);
+        if (region.width !== width || region.height !== height) {
+          throw new Error(
+            `Region ${width}x${height} came back as ${region.width}x${region.height}`
+          );
+        }
+
+        let diff = 0;
+        let differing = 0;
+        const rowBytes = width * 3;
+        for (let row = 0; row < height; row++) {
+          const offset = ((y + row) * full.width + x) * 3;
+          for (let i = 0; i < rowBytes; i++) {
+            const d = Math.abs(full.data[offset + i] - region.data[row * rowBytes + i]);
+            diff += d;
+            if (d) differing++;
+          }
+        }
+        const meanDiff = diff / (rowBytes * height);
+        if (exact ? differing > 0 : meanDiff > 0.5) {
+          throw new Error(
+            `Region at ${x},${y} differs from the full image in ${differing} bytes (mean ${meanDiff.toFixed(2)})`
+          );
+        }
+        this.log(
+          `${width}x${height} at ${x},${y}: ${Date.now() - start}ms (full: ${fullTime}ms), ${
+            exact ? "identical" : `mean difference ${meanDiff.toFixed(3)}`
+          }`,
+          "data"
+        );
+      }
+
+      // Sums that overflow 32 bits must be rejected, not wrap
+      for (const args of [
+        [1, 0, 2147483647, 16],
+        [0, 1, 16, 2147483647],
+      ]) {
+        let overflowRejected = false;
+        try {
+          await processor.processRegion(...args);
+        } catch (error) {
+          overflowRejected = true;
+        }
+        if (!overflowRejected) {
+          throw new Error(`Region ${args.join(",")} was accepted`);
+        }
+      }
+
+      let rejected = false;
+      try {
+        await processor.processRegion(full.width - 10, 0, 20, 20);
+      } catch (error) {
+        rejected = true;
+      }
+      if (!rejected) {
+        throw new Error("A region outside the image was accepted");
+      }
+
+      await processor.close();
+      this.results.region = { success: true };
+      return true;
+    } catch (error) {
+      this.log(`Region processing test failed: ${error.message}`, "error");
+      await processor.close();
+      this.results.region = { success: false, error: error.message };
+      return false;
+    }
+  }
+
   printSummary() {
     console.log("\n📊 Image Processing Test Summary");
     console.log("================================");
@@ -632,6 +801,8 @@ class ImageProcessingTests {
       { name: "Advanced Processing", result: this.results.processing },
       { name: "Parameter Configuration", result: this.results.output },
       { name: "Memory Operations", result: this.results.memory },
+      { name: "Preview Processing", result: this.results.preview },
+      { name: "Region Processing", result: this.results.region },
     ];
 
     let totalTests = 0;
@@ -695,6 +866,8 @@ class ImageProcessingTests {
     results.push(await this.testAdvancedProcessing());
     results.push(await this.testParameterConfiguration());
     results.push(await this.testMemoryOperations());
+    results.push(await this.testPreviewProcessing());
+    results.push(await this.testRegionProcessing());
 
     this.printSummary();
 
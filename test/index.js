@@ -2,6 +2,10 @@ const { testStaticMethods } = require("./static-methods.test.js");
 const { testErrorHandling } = require("./error-handling.test.js");
 const { runAllBufferTests } = require("./buffer-operations.test.js");
 const { testConfiguration } = require("./configuration.test.js");
+const { testAsyncOperations } = require("./async-operations.test.js");
+const { testBatchProcessor } = require("./batch-processor.test.js");
+const { testSimdKernels } = require("./simd-kernels.test.js");
+const { testDngTiles } = require("./dng-tiles.test.js");
 
 /**
  * Master test runner for all LibRaw tests
@@ -25,6 +29,10 @@ async function runAllTests() {
     { name: "Error Handling", fn: testErrorHandling },
     { name: "Buffer Operations", fn: runAllBufferTests },
     { name: "Configuration", fn: testConfiguration },
+    { name: "Async Operations", fn: testAsyncOperations },
+    { name: "Batch Processor", fn: testBatchProcessor },
+    { name: "SIMD Kernels", fn: testSimdKernels },
+    { name: "Tiled DNG", fn: testDngTiles },
   ];
 
   console.log(`\n📋 Running ${tests.length} test suites...\n`);
@@ -179,6 +187,18 @@ async function main() {
       case "config":
         await testConfiguration();
         break;
+      case "async":
+        await testAsyncOperations();
+        break;
+      case "batch":
+        await testBatchProcessor();
+        break;
+      case "simd":
+        await testSimdKernels();
+        break;
+      case "dng":
+        await testDngTiles();
+        break;
       case "full":
       default:
         const results = await runAllTests();
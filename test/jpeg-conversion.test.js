@@ -16,6 +16,7 @@ class JPEGConversionTests {
       batchTests: {},
       optimizationTests: {},
       performanceTests: {},
+      nativeTests: {},
     };
     this.testFiles = [];
     this.outputDir = path.join(__dirname, "jpeg-output");
@@ -408,6 +409,74 @@ class JPEGConversionTests {
     }
   }
 
+  async testNativeEncoder() {
+    this.log("Testing native libjpeg encoder...", "test");
+
+    if (!LibRaw.hasNativeJPEG()) {
+      this.log("Addon built without LIBRAW_JPEG=1, skipping", "warning");
+      return;
+    }
+
+    const testFile = this.testFiles[0];
+    if (!testFile) {
+      this.log("No test files available for native encoder testing", "warning");
+      return;
+    }
+
+    const processor = new LibRaw();
+    try {
+      await processor.loadFile(testFile);
+
+      let start = process.hrtime.bigint();
+      const native = await processor.createJPEGBuffer({ quality: 90 });
+      const nativeTime = Number(process.hrtime.bigint() - start) / 1000000;
+      start = process.hrtime.bigint();
+      const viaSharp = await processor.createJPEGBuffer({
+        quality: 90,
+        nativeEncoder: false,
+      });
+      const sharpTime = Number(process.hrtime.bigint() - start) / 1000000;
+
+      if (native.metadata.jpegOptions.encoder !== "libjpeg") {
+        throw new Error("createJPEGBuffer did not use the native encoder");
+      }
+
+      // Both encode the same pixels at the same quality, so the decoded
+      // images may only differ by DCT rounding
+      const a = await sharp(native.buffer).raw().toBuffer({ resolveWithObject: true });
+      const b = await sharp(viaSharp.buffer).raw().toBuffer({ resolveWithObject: true });
+      if (a.info.width !== b.info.width || a.info.height !== b.info.height) {
+        throw new Error(
+          `Native JPEG is ${a.info.width}x${a.info.height}, sharp's ${b.info.width}x${b.info.height}`
+        );
+      }
+      let diff = 0;
+      for (let i = 0; i < a.data.length; i++) {
+        diff += Math.abs(a.data[i] - b.data[i]);
+      }
+      const meanDiff = diff / a.data.length;
+      if (meanDiff > 2) {
+        throw new Error(`Native JPEG differs by ${meanDiff.toFixed(2)} on average`);
+      }
+
+      this.results.nativeTests = {
+        success: true,
+        nativeTime,
+        sharpTime,
+        meanDiff,
+      };
+      this.log(
+        `native ${nativeTime.toFixed(1)}ms (${(native.buffer.length / 1024).toFixed(1)}KB) vs sharp ${sharpTime.toFixed(1)}ms (${(viaSharp.buffer.length / 1024).toFixed(1)}KB), mean difference ${meanDiff.toFixed(3)}`,
+        "perf"
+      );
+    } catch (error) {
+      this.results.nativeTests = { success: false, error: error.message };
+      this.log(`Native encoder test failed: ${error.message}`, "error");
+    } finally {
+      await processor.close();
+    }
+  }
+
   async testOptimalSettings() {
     this.log("Testing optimal settings analysis...", "test");
 
@@ -662,6 +731,7 @@ class JPEGConversionTests {
       await this.testSizeOptions();
       await this.testBatchConversion();
       await this.testOptimizationOptions();
+      await this.testNativeEncoder();
       await this.testOptimalSettings();
       await this.testPerformanceBenchmarks();
 
@@ -250,10 +250,72 @@ async function performanceBenchmark() {
   }
 }
 
+// Decoder (unpack) benchmark for the Huffman-coded formats: loads each file
+// with unpack: false and times unpack() alone, best of several runs
+async function unpackBenchmark(iterations = 5) {
+  console.log("\n🧩 Unpack Benchmark (lossless JPEG / Huffman decoders)");
+  console.log("=====================================================\n");
+
+  const sampleDir = path.join(__dirname, "../raw-samples-repo");
+  const extensions = [".cr2", ".nef", ".dng", ".arw", ".pef"];
+  const files = [];
+  const walk = (dir) => {
+    for (const entry of fs.readdirSync(dir, { withFileTypes: true })) {
+      const full = path.join(dir, entry.name);
+      if (entry.isDirectory()) walk(full);
+      else if (extensions.includes(path.extname(entry.name).toLowerCase()))
+        files.push(full);
+    }
+  };
+  if (fs.existsSync(sampleDir)) walk(sampleDir);
+  files.sort();
+
+  if (files.length === 0) {
+    console.log("❌ No CR2/NEF/DNG/ARW/PEF files found for benchmarking");
+    return [];
+  }
+
+  const results = [];
+  for (const filepath of files) {
+    const processor = new LibRaw();
+    try {
+      let best = Infinity;
+      let decoder = "";
+      let megapixels = 0;
+      for (let i = 0; i < iterations; i++) {
+        await processor.loadFile(filepath, { unpack: false });
+        const start = process.hrtime.bigint();
+        await processor.unpack();
+        const ms = Number(process.hrtime.bigint() - start) / 1000000;
+        best = Math.min(best, ms);
+        if (i === 0) {
+          decoder = (await processor.getDecoderInfo()).decoder_name;
+          const size = await processor.getImageSize();
+          megapixels = (size.rawWidth * size.rawHeight) / 1000000;
+        }
+      }
+      results.push({ file: path.basename(filepath), decoder, best, megapixels });
+      console.log(
+        `   • ${path.basename(filepath)} [${decoder}]: ${best.toFixed(
+          1
+        )}ms (${(megapixels / (best / 1000)).toFixed(1)} MP/s)`
+      );
+    } catch (error) {
+      console.log(`   ❌ ${path.basename(filepath)}: ${error.message}`);
+    } finally {
+      await processor.close();
+    }
+  }
+  return results;
+}
+
 // Export for use in other tests
 module.exports = performanceBenchmark;
+module.exports.unpackBenchmark = unpackBenchmark;
 
 // Run the benchmark if executed directly
 if (require.main === module) {
-  performanceBenchmark().catch(console.error);
+  performanceBenchmark()
+    .then(() => unpackBenchmark())
+    .catch(console.error);
 }
@@ -0,0 +1,131 @@
+const LibRaw = require("../lib/index.js");
+const fs = require("fs");
+const path = require("path");
+
+/**
+ * Compare the AVX2/NEON colour conversion and scaling kernels with the
+ * scalar loops (simd_kernels: false) on the same input, byte for byte
+ */
+
+const LIBRAW_CAPS_SIMD_KERNELS = 0x400;
+
+function findSampleFiles(limit = 4) {
+  const sampleImagesDir = path.join(__dirname, "..", "raw-samples-repo");
+  if (!fs.existsSync(sampleImagesDir)) {
+    return [];
+  }
+
+  const sampleFiles = [];
+  const subdirs = fs
+    .readdirSync(sampleImagesDir, { withFileTypes: true })
+    .filter((dirent) => dirent.isDirectory())
+    .map((dirent) => dirent.name);
+
+  for (const subdir of subdirs) {
+    const subdirPath = path.join(sampleImagesDir, subdir);
+    const files = fs
+      .readdirSync(subdirPath)
+      .filter((f) => f.toLowerCase().match(/\.(cr2|cr3|nef|arw|raf|rw2|dng)$/))
+      .map((f) => path.join(subdirPath, f));
+    sampleFiles.push(...files.slice(0, 1));
+  }
+
+  return sampleFiles.slice(0, limit);
+}
+
+// Each variant goes through scale_colors and convert_to_rgb; the boosted
+// multipliers push many samples past 65535 so the clamping is compared too
+const variants = [
+  { name: "sRGB, 16-bit", params: { output_bps: 16 } },
+  {
+    name: "Adobe RGB, boosted WB",
+    params: { output_bps: 16, output_color: 2, user_mul: [4, 2, 4, 2] },
+  },
+  { name: "ProPhoto, 8-bit", params: { output_color: 4 } },
+];
+
+async function decode(file, params) {
+  const processor = new LibRaw();
+  try {
+    await processor.loadFile(file);
+    await processor.setOutputParams(params);
+    const applied = await processor.getOutputParams();
+    if (applied.simd_kernels !== params.simd_kernels) {
+      throw new Error(`simd_kernels reads back as ${applied.simd_kernels}`);
+    }
+    await processor.processImage();
+    return await processor.createMemoryImage();
+  } finally {
+    await processor.close();
+  }
+}
+
+function countDifferences(a, b) {
+  const length = Math.min(a.length, b.length);
+  let differences = Math.abs(a.length - b.length);
+  for (let i = 0; i < length; i++) {
+    if (a[i] !== b[i]) differences++;
+  }
+  return differences;
+}
+
+async function testSimdKernels() {
+  console.log("🧮 LibRaw SIMD Kernel Test");
+  console.log("=".repeat(40));
+
+  if (!(LibRaw.getCapabilities() & LIBRAW_CAPS_SIMD_KERNELS)) {
+    console.log(
+      `\nℹ️ No AVX2/NEON kernels on this CPU (${process.arch}), both paths are scalar; skipping`
+    );
+    return;
+  }
+
+  const sampleFiles = findSampleFiles();
+  if (sampleFiles.length === 0) {
+    console.log("\nℹ️ No RAW sample files found, skipping SIMD kernel tests");
+    return;
+  }
+
+  let failures = 0;
+  for (const file of sampleFiles) {
+    console.log(`\n📁 ${path.basename(file)}:`);
+    for (const variant of variants) {
+      const simd = await decode(file, { ...variant.params, simd_kernels: true });
+      const scalar = await decode(file, { ...variant.params, simd_kernels: false });
+
+      const differences =
+        simd.width !== scalar.width || simd.height !== scalar.height
+          ? -1
+          : countDifferences(simd.data, scalar.data);
+      if (differences === 0) {
+        console.log(
+          `   ✅ ${variant.name}: ${simd.width}x${simd.height}, identical`
+        );
+      } else {
+        console.log(
+          `   ❌ ${variant.name}: ${
+            differences < 0 ? "sizes differ" : `${differences} bytes differ`
+          }`
+        );
+        failures++;
+      }
+    }
+  }
+
+  if (failures > 0) {
+    throw new Error(`${failures} SIMD/scalar comparisons differ`);
+  }
+
+  console.log("\n🎉 SIMD kernel test completed!");
+  console.log("=".repeat(40));
+}
+
+// Run the test
+if (require.main === module) {
+  testSimdKernels().catch((error) => {
+    console.error(error);
+    process.exit(1);
+  });
+}
+
+module.exports = { testSimdKernels };
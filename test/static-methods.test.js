@@ -178,6 +178,34 @@ async function testStaticMethods() {
     console.log(`   ❌ Capability analysis failed: ${error.message}`);
   }
 
+  // Test processor pool
+  console.log("\n♻️ Processor Pool:");
+
+  try {
+    const stats = LibRaw.configurePool({ maxIdle: 4, prewarm: 2 });
+    if (stats.maxIdle !== 4 || stats.idle < 2) {
+      throw new Error(`Unexpected pool state: ${JSON.stringify(stats)}`);
+    }
+    console.log(`   ✅ Pool prewarmed: ${stats.idle} idle of ${stats.maxIdle}`);
+
+    const processor = new LibRaw();
+    const reusedBefore = LibRaw.getPoolStats().reused;
+    await processor.close();
+    const afterClose = LibRaw.getPoolStats();
+    if (afterClose.idle < 2) {
+      throw new Error("close() did not return the processor to the pool");
+    }
+
+    const second = new LibRaw();
+    if (LibRaw.getPoolStats().reused !== reusedBefore + 1) {
+      throw new Error("New instance did not reuse a pooled processor");
+    }
+    await second.close();
+    console.log(`   ✅ Processors reused across instances`);
+  } catch (error) {
+    console.log(`   ❌ Processor pool test failed: ${error.message}`);
+  }
+
   console.log("\n🎉 Static methods test completed!");
   console.log("=".repeat(40));
 }
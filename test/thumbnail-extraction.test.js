@@ -1260,6 +1260,68 @@ class ThumbnailExtractionTests {
     return successfulTests > 0;
   }
 
+  async testStaticExtractThumbnail() {
+    console.log("\n📤 Testing Static Thumbnail Extraction");
+    console.log("=====================================");
+
+    let passed = 0;
+
+    for (const testFile of this.testFiles) {
+      const fileName = path.basename(testFile);
+      const processor = new LibRaw();
+
+      try {
+        await processor.loadFile(testFile);
+        if (!(await processor.thumbOK())) {
+          this.log(`${fileName}: no thumbnail - skipping`, "warning");
+          continue;
+        }
+        await processor.unpackThumbnail();
+        const expected = await processor.createMemoryThumbnail();
+
+        const fromPath = await LibRaw.extractThumbnail(testFile);
+        const fromBuffer = await LibRaw.extractThumbnail(
+          fs.readFileSync(testFile)
+        );
+
+        if (
+          !expected.data.equals(fromPath.data) ||
+          !expected.data.equals(fromBuffer.data)
+        ) {
+          throw new Error("extracted thumbnail differs from unpackThumbnail()");
+        }
+
+        // A tiny maxSize still yields a thumbnail (the smallest one)
+        const smallest = await LibRaw.extractThumbnail(testFile, {
+          maxSize: 1,
+        });
+        if (!smallest.data || smallest.data.length === 0) {
+          throw new Error("maxSize selection returned no data");
+        }
+
+        this.log(
+          `${fileName}: ${fromPath.width}x${fromPath.height}, ${fromPath.dataSize} bytes`,
+          "success"
+        );
+        passed++;
+      } catch (error) {
+        this.log(`${fileName}: ${error.message}`, "error");
+      } finally {
+        await processor.close();
+      }
+    }
+
+    try {
+      await LibRaw.extractThumbnail(path.join(__dirname, "missing.raw"));
+      this.log("Missing file: should have failed", "error");
+      return false;
+    } catch (error) {
+      this.log(`Missing file rejected: ${error.message}`, "success");
+    }
+
+    return passed > 0;
+  }
+
   async testMultiSizeJPEGGeneration() {
     console.log("\n📐 Testing Multi-Size JPEG Generation from RAW");
     console.log("==============================================");
@@ -1793,6 +1855,9 @@ class ThumbnailExtractionTests {
 
       // 6. Multi-size JPEG generation testing
       results.push(await this.testMultiSizeJPEGGeneration());
+
+      // 7. Static extraction without unpacking the RAW data
+      results.push(await this.testStaticExtractThumbnail());
     }
 
     this.printSummary();